@@ -10,16 +10,21 @@
 #include "../Common/CommonUtils.h"
 #include "../Common/DistanceUtils.h"
 #include "../Common/QueryResultSet.h"
+#include "../Common/IndexResultIterator.h"
 #include "../Common/Dataset.h"
 #include "../Common/WorkSpace.h"
 #include "../Common/WorkSpacePool.h"
 #include "../Common/RelativeNeighborhoodGraph.h"
 #include "../Common/BKTree.h"
 #include "../Common/Labelset.h"
+#include "../Common/Attributeset.h"
+#include "../Common/PQQuantizer.h"
+#include "../Common/SQ8Quantizer.h"
 #include "inc/Helper/SimpleIniReader.h"
 #include "inc/Helper/StringConvert.h"
 #include "inc/Helper/ThreadPool.h"
 
+#include <atomic>
 #include <functional>
 #include <shared_mutex>
 
@@ -51,6 +56,10 @@ namespace SPTAG
         private:
             // data points
             COMMON::Dataset<T> m_pSamples;
+
+            // Norm of every sample, kept for Cosine only so that exact distances to a sample skip its
+            // self product. Saved right after m_pSamples in the same file or stream.
+            COMMON::Dataset<float> m_pSampleNorms;
         
             // BKT structures. 
             COMMON::BKTree m_pTrees;
@@ -62,12 +71,15 @@ namespace SPTAG
             std::string m_sGraphFilename;
             std::string m_sDataPointsFilename;
             std::string m_sDeleteDataPointsFilename;
+            std::string m_sQuantizerFilename;
+            std::string m_sOriginalIDFilename;
 
             int m_addCountForRebuild;
             float m_fDeletePercentageForRefine;
             std::mutex m_dataAddLock; // protect data and graph
             std::shared_timed_mutex m_dataDeleteLock;
             COMMON::Labelset m_deletedID;
+            COMMON::Attributeset m_attributes;
 
             std::unique_ptr<COMMON::WorkSpacePool> m_workSpacePool;
             Helper::ThreadPool m_threadPool;
@@ -75,12 +87,39 @@ namespace SPTAG
 
             DistCalcMethod m_iDistCalcMethod;
             float(*m_fComputeDistance)(const T* pX, const T* pY, DimensionType length);
+            void(*m_fComputeDistanceBatch)(const T* pQuery, const T* const* pRows, int count, DimensionType length, float* pResults);
             int m_iBaseSquare;
 
+            // Compressed copy of m_pSamples scored during graph traversal; results are re-ranked
+            // against m_pSamples. Immutable once trained, so refined indexes share it.
+            QuantizerType m_eQuantizerType;
+            DimensionType m_iPQSubvectors;
+            int m_iQuantizerSamples;
+            int m_iRerankFactor;
+            std::shared_ptr<COMMON::IQuantizer<T>> m_pQuantizer;
+            COMMON::Dataset<std::uint8_t> m_pQuantizedSamples;
+
             int m_iMaxCheck;        
             int m_iThresholdOfNumberOfContinuousNoBetterPropagation;
             int m_iNumberOfInitialDynamicPivots;
             int m_iNumberOfOtherDynamicPivots;
+
+            // How a query remembers the nodes it has already visited.
+            VisitedTableType m_eVisitedTable;
+
+            // Queries searched together by one thread in SearchIndexGroup and the batch SearchIndex.
+            int m_iSearchGroupSize;
+
+            // Stop scoring a neighbor or pivot once it is farther than the current worst result.
+            bool m_bEarlyAbandon;
+            mutable std::atomic<std::uint64_t> m_iBoundedDistances;
+            mutable std::atomic<std::uint64_t> m_iAbandonedDistances;
+
+            // Renumber the vectors at build and refine time so that the vectors of each BKTree cluster have
+            // consecutive ids, and neighbors in the graph tend to share cache lines and pages.
+            // m_pOriginalIDs keeps the id each vector had before, i.e. the one it has without reordering.
+            bool m_bReorderVectors;
+            COMMON::Dataset<SizeType> m_pOriginalIDs;
         public:
             Index()
             {
@@ -91,9 +130,14 @@ namespace SPTAG
 #undef DefineBKTParameter
 
                 m_bReady = false;
+                m_iBoundedDistances = 0;
+                m_iAbandonedDistances = 0;
                 m_pSamples.SetName("Vector");
-                m_fComputeDistance = COMMON::DistanceCalcSelector<T>(m_iDistCalcMethod);
-                m_iBaseSquare = (m_iDistCalcMethod == DistCalcMethod::Cosine) ? COMMON::Utils::GetBase<T>() * COMMON::Utils::GetBase<T>() : 1;
+                m_pSampleNorms.SetName("VectorNorm");
+                m_pQuantizedSamples.SetName("QuantizedVector");
+                m_pOriginalIDs.SetName("OriginalID");
+                SelectDistanceKernels();
+                m_iBaseSquare = (m_iDistCalcMethod == DistCalcMethod::Cosine || m_iDistCalcMethod == DistCalcMethod::InnerProduct) ? COMMON::Utils::GetBase<T>() * COMMON::Utils::GetBase<T>() : 1;
             }
 
             ~Index() {}
@@ -109,24 +153,47 @@ namespace SPTAG
             inline VectorValueType GetVectorValueType() const { return GetEnumValueType<T>(); }
             
             inline float AccurateDistance(const void* pX, const void* pY) const { 
-                if (m_iDistCalcMethod == DistCalcMethod::L2) return m_fComputeDistance((const T*)pX, (const T*)pY, m_pSamples.C());
+                if (m_iDistCalcMethod != DistCalcMethod::Cosine) return m_fComputeDistance((const T*)pX, (const T*)pY, m_pSamples.C());
 
                 float xy = m_iBaseSquare - m_fComputeDistance((const T*)pX, (const T*)pY, m_pSamples.C());
                 float xx = m_iBaseSquare - m_fComputeDistance((const T*)pX, (const T*)pX, m_pSamples.C());
                 float yy = m_iBaseSquare - m_fComputeDistance((const T*)pY, (const T*)pY, m_pSamples.C());
                 return 1.0f - xy / (sqrt(xx) * sqrt(yy));
             }
+            inline float AccurateDistance(const void* pX, const SizeType idx) const {
+                if (!KeepsSampleNorms()) return m_fComputeDistance((const T*)pX, m_pSamples[idx], m_pSamples.C());
+
+                float xy = m_iBaseSquare - m_fComputeDistance((const T*)pX, m_pSamples[idx], m_pSamples.C());
+                float xx = m_iBaseSquare - m_fComputeDistance((const T*)pX, (const T*)pX, m_pSamples.C());
+                return 1.0f - xy / (sqrt(xx) * *m_pSampleNorms[idx]);
+            }
             inline float ComputeDistance(const void* pX, const void* pY) const { return m_fComputeDistance((const T*)pX, (const T*)pY, m_pSamples.C()); }
+            inline float ComputeDistanceBounded(const void* pX, const void* pY, float p_bound, bool& p_abandoned) const {
+                if (!UseBoundedDistance()) {
+                    p_abandoned = false;
+                    return m_fComputeDistance((const T*)pX, (const T*)pY, m_pSamples.C());
+                }
+                return COMMON::DistanceUtils::ComputeDistanceBounded(m_fComputeDistance, (const T*)pX, (const T*)pY, m_pSamples.C(), p_bound, p_abandoned);
+            }
             inline const void* GetSample(const SizeType idx) const { return (void*)m_pSamples[idx]; }
             inline bool ContainSample(const SizeType idx) const { return !m_deletedID.Contains(idx); }
+            ErrorCode SetAttribute(const SizeType idx, std::uint64_t p_attribute);
+            inline std::uint64_t GetAttribute(const SizeType idx) const { return (idx >= 0 && idx < GetNumSamples()) ? m_attributes.Get(idx) : 0; }
             inline bool NeedRefine() const { return m_deletedID.Count() > (size_t)(GetNumSamples() * m_fDeletePercentageForRefine); }
+            inline SizeType GetOriginalID(const SizeType idx) const { return (idx >= 0 && idx < m_pOriginalIDs.R()) ? *m_pOriginalIDs[idx] : idx; }
+
+            // Totals over all SearchIndex calls of the distances computed against a bound and of those abandoned early.
+            inline std::uint64_t GetNumberOfBoundedDistances() const { return m_iBoundedDistances; }
+            inline std::uint64_t GetNumberOfAbandonedDistances() const { return m_iAbandonedDistances; }
             std::shared_ptr<std::vector<std::uint64_t>> BufferSize() const
             {
                 std::shared_ptr<std::vector<std::uint64_t>> buffersize(new std::vector<std::uint64_t>);
-                buffersize->push_back(m_pSamples.BufferSize());
+                buffersize->push_back(m_pSamples.BufferSize() + (KeepsSampleNorms() ? m_pSampleNorms.BufferSize() : 0));
                 buffersize->push_back(m_pTrees.BufferSize());
                 buffersize->push_back(m_pGraph.BufferSize());
-                buffersize->push_back(m_deletedID.BufferSize());
+                buffersize->push_back(m_deletedID.BufferSize() + m_attributes.BufferSize());
+                if (m_pQuantizer != nullptr) buffersize->push_back(m_pQuantizer->BufferSize() + m_pQuantizedSamples.BufferSize());
+                if (m_bReorderVectors) buffersize->push_back(m_pOriginalIDs.BufferSize());
                 return std::move(buffersize);
             }
 
@@ -141,6 +208,10 @@ namespace SPTAG
             ErrorCode BuildIndex(const void* p_data, SizeType p_vectorNum, DimensionType p_dimension);
             ErrorCode SearchIndex(QueryResult &p_query, bool p_searchDeleted = false) const;
             ErrorCode RefineSearchIndex(QueryResult &p_query, bool p_searchDeleted = false) const;
+            ErrorCode SearchIndexWithinRadius(QueryResult &p_query, float p_radius, bool p_searchDeleted = false) const;
+            std::shared_ptr<ResultIterator> GetIterator(const void* p_target, const SearchOptions& p_options = SearchOptions()) const;
+            ErrorCode SearchIndexGroup(QueryResult** p_queries, int p_queryCount, bool p_searchDeleted = false) const;
+            ErrorCode SearchIndex(const void* p_vector, int p_vectorCount, int p_neighborCount, bool p_withMeta, BasicResult* p_results) const;
             ErrorCode AddIndex(const void* p_data, SizeType p_vectorNum, DimensionType p_dimension, std::shared_ptr<MetadataSet> p_metadataSet, bool p_withMetaIndex = false);
             ErrorCode DeleteIndex(const void* p_vectors, SizeType p_vectorNum);
             ErrorCode DeleteIndex(const SizeType& p_id);
@@ -153,7 +224,41 @@ namespace SPTAG
             ErrorCode RefineIndex(std::shared_ptr<VectorIndex>& p_newIndex);
 
         private:
-            void SearchIndex(COMMON::QueryResultSet<T> &p_query, COMMON::WorkSpace &p_space, bool p_searchDeleted, bool p_searchDuplicated) const;
+            friend class COMMON::IndexResultIterator<T, Index<T>>;
+
+            // Q is COMMON::QueryResultSet<T> for the K nearest neighbors, COMMON::RadiusResultSet<T> for range search
+            // or COMMON::DistinctResultSet<T> for the K nearest distinct metadata values.
+            template <typename Q>
+            void SearchIndex(Q &p_query, COMMON::WorkSpace &p_space, bool p_searchDeleted, bool p_searchDuplicated) const;
+            // Continues the walk of an iterator until p_results holds p_count vectors or the walk runs out.
+            void SearchIndexIterative(COMMON::IterativeResultSet<T>& p_query, COMMON::WorkSpace& p_space, bool p_isFirst, int p_count, bool p_searchDeleted, std::vector<BasicResult>& p_results) const;
+            void SearchIndexGroup(COMMON::QueryResultSet<T>** p_queries, COMMON::WorkSpace** p_spaces, int p_count, const bool* p_searchDeleted) const;
+            template <typename Q>
+            void ScanAllowedIDs(Q &p_query, COMMON::WorkSpace &p_space, bool p_searchDeleted) const;
+            void RerankCandidates(COMMON::QueryResultSet<T>& p_candidates, QueryResult& p_query) const;
+            void ResetWorkSpace(COMMON::WorkSpace& p_space, const SearchOptions& p_options, int p_maxCheck) const;
+            void FinishSearch(COMMON::WorkSpace& p_space, QueryResult& p_query) const;
+
+            // Binds the distance kernels, compiled for the feature dimension when there are such kernels.
+            inline void SelectDistanceKernels()
+            {
+                m_fComputeDistance = COMMON::DistanceCalcSelector<T>(m_iDistCalcMethod, GetFeatureDim());
+                m_fComputeDistanceBatch = COMMON::DistanceBatchCalcSelector<T>(m_iDistCalcMethod, GetFeatureDim());
+            }
+
+            inline bool KeepsSampleNorms() const { return m_iDistCalcMethod == DistCalcMethod::Cosine; }
+
+            void ComputeSampleNorms(SizeType p_begin, SizeType p_end);
+            bool LoadSampleNorms(std::ifstream& p_input);
+            bool LoadSampleNorms(const ByteArray& p_blob);
+
+            inline bool UseBoundedDistance() const { return m_bEarlyAbandon && COMMON::DistanceUtils::SupportsBoundedDistance<T>(m_iDistCalcMethod); }
+
+            std::shared_ptr<COMMON::IQuantizer<T>> CreateQuantizer() const;
+            ErrorCode TrainQuantizer();
+
+            // Applies the cluster order of m_pTrees to a freshly built index (see m_bReorderVectors).
+            ErrorCode ReorderVectors();
         };
     } // namespace BKT
 } // namespace SPTAG
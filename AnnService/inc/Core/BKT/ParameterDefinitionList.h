@@ -8,6 +8,8 @@ DefineBKTParameter(m_sBKTFilename, std::string, std::string("tree.bin"), "TreeFi
 DefineBKTParameter(m_sGraphFilename, std::string, std::string("graph.bin"), "GraphFilePath")
 DefineBKTParameter(m_sDataPointsFilename, std::string, std::string("vectors.bin"), "VectorFilePath")
 DefineBKTParameter(m_sDeleteDataPointsFilename, std::string, std::string("deletes.bin"), "DeleteVectorFilePath")
+DefineBKTParameter(m_sQuantizerFilename, std::string, std::string("quantizer.bin"), "QuantizerFilePath")
+DefineBKTParameter(m_sOriginalIDFilename, std::string, std::string("originalids.bin"), "OriginalIDFilePath")
 
 DefineBKTParameter(m_pTrees.m_iTreeNumber, int, 1L, "BKTNumber")
 DefineBKTParameter(m_pTrees.m_iBKTKmeansK, int, 32L, "BKTKmeansK")
@@ -36,5 +38,15 @@ DefineBKTParameter(m_iMaxCheck, int, 8192L, "MaxCheck")
 DefineBKTParameter(m_iThresholdOfNumberOfContinuousNoBetterPropagation, int, 3L, "ThresholdOfNumberOfContinuousNoBetterPropagation")
 DefineBKTParameter(m_iNumberOfInitialDynamicPivots, int, 50L, "NumberOfInitialDynamicPivots")
 DefineBKTParameter(m_iNumberOfOtherDynamicPivots, int, 4L, "NumberOfOtherDynamicPivots")
+DefineBKTParameter(m_bEarlyAbandon, bool, true, "EarlyAbandon")
+DefineBKTParameter(m_eVisitedTable, SPTAG::VisitedTableType, SPTAG::VisitedTableType::Hash, "VisitedTable")
+DefineBKTParameter(m_iSearchGroupSize, int, 1L, "SearchGroupSize")
+
+DefineBKTParameter(m_eQuantizerType, SPTAG::QuantizerType, SPTAG::QuantizerType::None, "Quantizer")
+DefineBKTParameter(m_iPQSubvectors, DimensionType, 0L, "PQSubvectors")
+DefineBKTParameter(m_iQuantizerSamples, int, 16384L, "QuantizerTrainSamples")
+DefineBKTParameter(m_iRerankFactor, int, 4L, "RerankFactor")
+
+DefineBKTParameter(m_bReorderVectors, bool, false, "ReorderVectors")
 
 #endif
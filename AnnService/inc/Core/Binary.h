@@ -0,0 +1,32 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _SPTAG_CORE_BINARY_H_
+#define _SPTAG_CORE_BINARY_H_
+
+#include <cstdint>
+
+namespace SPTAG
+{
+
+// Eight bits of a packed binary vector (e.g. a hash code). The dimension of a Binary vector counts
+// bytes, so a 256-bit code has dimension 32 and vector files hold the packed bytes as they are.
+// Binary vectors are compared by Hamming distance, the number of differing bits. Arithmetic through
+// the implicit conversion sees the byte as an unsigned value, which is what the space partition
+// trees split on; k-means works on the individual bits instead (see KmeansCenterTraits).
+struct Binary
+{
+    std::uint8_t bits;
+
+    Binary() = default;
+
+    Binary(std::uint8_t p_bits) : bits(p_bits) {}
+
+    operator float() const { return bits; }
+};
+
+static_assert(sizeof(Binary) == 1, "Binary must not be padded");
+
+} // namespace SPTAG
+
+#endif // _SPTAG_CORE_BINARY_H_
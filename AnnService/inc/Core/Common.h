@@ -12,6 +12,9 @@
 #include <vector>
 #include <cmath>
 
+#include "Binary.h"
+#include "Float16.h"
+
 #ifndef _MSC_VER
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -99,6 +102,28 @@ enum class DistCalcMethod : std::uint8_t
 static_assert(static_cast<std::uint8_t>(DistCalcMethod::Undefined) != 0, "Empty DistCalcMethod!");
 
 
+enum class QuantizerType : std::uint8_t
+{
+#define DefineQuantizerType(Name) Name,
+#include "DefinitionList.h"
+#undef DefineQuantizerType
+
+    Undefined
+};
+static_assert(static_cast<std::uint8_t>(QuantizerType::Undefined) != 0, "Empty QuantizerType!");
+
+
+enum class VisitedTableType : std::uint8_t
+{
+#define DefineVisitedTableType(Name) Name,
+#include "DefinitionList.h"
+#undef DefineVisitedTableType
+
+    Undefined
+};
+static_assert(static_cast<std::uint8_t>(VisitedTableType::Undefined) != 0, "Empty VisitedTableType!");
+
+
 enum class VectorValueType : std::uint8_t
 {
 #define DefineVectorValueType(Name, Type) Name,
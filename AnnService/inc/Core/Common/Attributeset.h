@@ -0,0 +1,123 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _SPTAG_COMMON_ATTRIBUTESET_H_
+#define _SPTAG_COMMON_ATTRIBUTESET_H_
+
+#include "Dataset.h"
+
+namespace SPTAG
+{
+    namespace COMMON
+    {
+        // A 64 bit attribute per vector that searches can filter on (see SearchOptions::m_attributeMask).
+        // The attributes are saved after the deleted labels, and only once one of them has been set;
+        // indexes saved without them load all attributes as 0.
+        class Attributeset
+        {
+        private:
+            bool m_used;
+            Dataset<std::uint64_t> m_data;
+
+            inline void Clear(SizeType begin, SizeType end)
+            {
+                for (SizeType i = begin; i < end; i++) *m_data[i] = 0;
+            }
+
+        public:
+            Attributeset() : m_used(false)
+            {
+                m_data.SetName("Attribute");
+            }
+
+            void Initialize(SizeType capacity)
+            {
+                m_data.Initialize(capacity, 1);
+                Clear(0, capacity);
+                m_used = false;
+            }
+
+            inline bool Used() const { return m_used; }
+
+            inline std::uint64_t Get(const SizeType& key) const
+            {
+                return *m_data[key];
+            }
+
+            inline void Set(const SizeType& key, std::uint64_t value)
+            {
+                *m_data[key] = value;
+                m_used = true;
+            }
+
+            inline bool Save(std::ostream& output) const
+            {
+                return !m_used || m_data.Save(output);
+            }
+
+            // Reads the attributes that follow the deleted labels, if the stream has any.
+            inline bool Load(std::ifstream& input, SizeType count)
+            {
+                if (input.peek() == EOF)
+                {
+                    Initialize(count);
+                    return true;
+                }
+                if (!m_data.Load(input)) return false;
+                if (m_data.R() != count || m_data.C() != 1) Initialize(count);
+                else m_used = true;
+                return true;
+            }
+
+            inline bool Load(char* pmemoryFile, std::uint64_t length, SizeType count)
+            {
+                if (length < sizeof(SizeType) + sizeof(DimensionType) + sizeof(std::uint64_t) * count)
+                {
+                    Initialize(count);
+                    return true;
+                }
+                if (!m_data.Load(pmemoryFile)) return false;
+                if (m_data.R() != count || m_data.C() != 1) Initialize(count);
+                else m_used = true;
+                return true;
+            }
+
+            inline bool Refine(const std::vector<SizeType>& indices, Attributeset& output) const
+            {
+                if (!m_data.Refine(indices, output.m_data)) return false;
+                output.m_used = m_used;
+                return true;
+            }
+
+            inline bool Refine(const std::vector<SizeType>& indices, std::ostream& output) const
+            {
+                return !m_used || m_data.Refine(indices, output);
+            }
+
+            inline bool Permute(const std::vector<SizeType>& indices)
+            {
+                return m_data.Permute(indices);
+            }
+
+            inline ErrorCode AddBatch(SizeType num)
+            {
+                SizeType begin = m_data.R();
+                ErrorCode ret = m_data.AddBatch(num);
+                if (ret == ErrorCode::Success) Clear(begin, begin + num);
+                return ret;
+            }
+
+            inline std::uint64_t BufferSize() const
+            {
+                return m_used ? m_data.BufferSize() : 0;
+            }
+
+            inline void SetR(SizeType num)
+            {
+                m_data.SetR(num);
+            }
+        };
+    }
+}
+
+#endif // _SPTAG_COMMON_ATTRIBUTESET_H_
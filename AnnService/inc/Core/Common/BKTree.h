@@ -13,6 +13,7 @@
 #include "../VectorIndex.h"
 
 #include "CommonUtils.h"
+#include "DistanceUtils.h"
 #include "QueryResultSet.h"
 #include "WorkSpace.h"
 
@@ -32,6 +33,43 @@ namespace SPTAG
             BKTNode(SizeType cid = -1) : centerid(cid), childStart(-1), childEnd(-1) {}
         };
 
+        // How k-means accumulates samples into float centers and turns the averages back into values.
+        // A Binary element holds eight bits, which are averaged separately so that a center keeps the
+        // majority value of every bit (the mean minimizing Hamming distance).
+        template <typename T>
+        struct KmeansCenterTraits {
+            static const int Width = 1;
+
+            static inline void Accumulate(float* center, const T* v, DimensionType dim) {
+                for (DimensionType j = 0; j < dim; j++) center[j] += v[j];
+            }
+
+            static inline void Assign(T* center, const float* average, DimensionType dim) {
+                for (DimensionType j = 0; j < dim; j++) center[j] = (T)(average[j]);
+            }
+        };
+
+        template <>
+        struct KmeansCenterTraits<SPTAG::Binary> {
+            static const int Width = 8;
+
+            static inline void Accumulate(float* center, const SPTAG::Binary* v, DimensionType dim) {
+                for (DimensionType j = 0; j < dim; j++) {
+                    for (int b = 0; b < Width; b++) center[j * Width + b] += (v[j].bits >> b) & 1;
+                }
+            }
+
+            static inline void Assign(SPTAG::Binary* center, const float* average, DimensionType dim) {
+                for (DimensionType j = 0; j < dim; j++) {
+                    std::uint8_t bits = 0;
+                    for (int b = 0; b < Width; b++) {
+                        if (average[j * Width + b] >= 0.5f) bits |= (std::uint8_t)(1 << b);
+                    }
+                    center[j].bits = bits;
+                }
+            }
+        };
+
         template <typename T>
         struct KmeansArgs {
             int _K;
@@ -45,16 +83,21 @@ namespace SPTAG
             SizeType* clusterIdx;
             float* clusterDist;
             T* newTCenters;
+            float(*fComputeDistance)(const T* pX, const T* pY, DimensionType length);
 
-            KmeansArgs(int k, DimensionType dim, SizeType datasize, int threadnum) : _K(k), _D(dim), _T(threadnum) {
+            KmeansArgs(int k, DimensionType dim, SizeType datasize, int threadnum, DistCalcMethod distMethod) : _K(k), _D(dim), _T(threadnum) {
                 centers = (T*)aligned_malloc(sizeof(T) * k * dim, ALIGN);
                 newTCenters = (T*)aligned_malloc(sizeof(T) * k * dim, ALIGN);
                 counts = new SizeType[k];
-                newCenters = new float[threadnum * k * dim];
+                newCenters = new float[threadnum * k * dim * KmeansCenterTraits<T>::Width];
                 newCounts = new SizeType[threadnum * k];
                 label = new int[datasize];
                 clusterIdx = new SizeType[threadnum * k];
                 clusterDist = new float[threadnum * k];
+                // Mean centers only minimize L2, and maximizing inner product would let the largest-norm
+                // center absorb everything, so InnerProduct indices cluster by L2. Queries still descend
+                // the tree by inner product to the cluster representatives.
+                fComputeDistance = DistanceCalcSelector<T>((distMethod == DistCalcMethod::InnerProduct) ? DistCalcMethod::L2 : distMethod);
             }
 
             ~KmeansArgs() {
@@ -73,7 +116,7 @@ namespace SPTAG
             }
 
             inline void ClearCenters() {
-                memset(newCenters, 0, sizeof(float) * _T * _K * _D);
+                memset(newCenters, 0, sizeof(float) * _T * _K * _D * KmeansCenterTraits<T>::Width);
             }
 
             inline void ClearDists(float dist) {
@@ -157,7 +200,7 @@ namespace SPTAG
                 else {
                     localindices.assign(indices->begin(), indices->end());
                 }
-                KmeansArgs<T> args(m_iBKTKmeansK, index->GetFeatureDim(), (SizeType)localindices.size(), numOfThreads);
+                KmeansArgs<T> args(m_iBKTKmeansK, index->GetFeatureDim(), (SizeType)localindices.size(), numOfThreads, index->GetDistCalcMethod());
 
                 m_pSampleCenterMap.clear();
                 for (char i = 0; i < m_iTreeNumber; i++)
@@ -210,6 +253,56 @@ namespace SPTAG
                 }
             }
 
+            // Lists the p_count samples in the depth-first order of the first tree, so that the samples of each
+            // cluster, down to the leaves, come one after the other. Samples missing from the tree come last.
+            void ClusterOrder(SizeType p_count, std::vector<SizeType>& p_order) const
+            {
+                std::vector<bool> listed(p_count, false);
+                p_order.clear();
+                p_order.reserve(p_count);
+
+                std::stack<SizeType> ss;
+                const BKTNode& root = m_pTreeRoots[m_pTreeStart[0]];
+                if (root.childStart < 0 && root.centerid >= 0 && root.centerid < p_count) {
+                    listed[root.centerid] = true;
+                    p_order.push_back(root.centerid);
+                }
+                for (SizeType i = root.childEnd - 1; i >= std::abs(root.childStart); i--) ss.push(i);
+                while (!ss.empty()) {
+                    const BKTNode& node = m_pTreeRoots[ss.top()]; ss.pop();
+                    if (node.centerid >= 0 && node.centerid < p_count && !listed[node.centerid]) {
+                        listed[node.centerid] = true;
+                        p_order.push_back(node.centerid);
+                    }
+                    for (SizeType i = node.childEnd - 1; i >= std::abs(node.childStart); i--) ss.push(i);
+                }
+                for (SizeType i = 0; i < p_count; i++) {
+                    if (!listed[i]) p_order.push_back(i);
+                }
+            }
+
+            // Renumbers the samples the trees point to: sample j becomes p_reverseIndices[j].
+            void Renumber(const std::vector<SizeType>& p_reverseIndices)
+            {
+                SizeType count = (SizeType)p_reverseIndices.size();
+                for (SizeType i = 0; i < m_iTreeNumber; i++) {
+                    BKTNode& root = m_pTreeRoots[m_pTreeStart[i]];
+                    if (root.childStart < 0 && root.centerid >= 0 && root.centerid < count) root.centerid = p_reverseIndices[root.centerid];
+                    SizeType end = (i + 1 < m_iTreeNumber) ? m_pTreeStart[i + 1] : (SizeType)m_pTreeRoots.size();
+                    for (SizeType j = m_pTreeStart[i] + 1; j < end; j++) {
+                        BKTNode& node = m_pTreeRoots[j];
+                        if (node.centerid >= 0 && node.centerid < count) node.centerid = p_reverseIndices[node.centerid];
+                    }
+                }
+
+                std::unordered_map<SizeType, SizeType> sampleCenterMap;
+                for (auto iter = m_pSampleCenterMap.begin(); iter != m_pSampleCenterMap.end(); iter++) {
+                    if (iter->first >= 0) sampleCenterMap[p_reverseIndices[iter->first]] = p_reverseIndices[iter->second];
+                    else sampleCenterMap[-1 - p_reverseIndices[-1 - iter->first]] = iter->second;
+                }
+                m_pSampleCenterMap.swap(sampleCenterMap);
+            }
+
             inline std::uint64_t BufferSize() const
             {
                 return sizeof(int) + sizeof(SizeType) * m_iTreeNumber +
@@ -275,8 +368,8 @@ namespace SPTAG
                 return true;
             }
 
-            template <typename T>
-            void InitSearchTrees(const VectorIndex* p_index, const COMMON::QueryResultSet<T> &p_query, COMMON::WorkSpace &p_space) const
+            template <typename Q>
+            void InitSearchTrees(const VectorIndex* p_index, const Q &p_query, COMMON::WorkSpace &p_space) const
             {
                 for (char i = 0; i < m_iTreeNumber; i++) {
                     const BKTNode& node = m_pTreeRoots[m_pTreeStart[i]];
@@ -292,8 +385,8 @@ namespace SPTAG
                 }
             }
 
-            template <typename T>
-            void SearchTrees(const VectorIndex* p_index, const COMMON::QueryResultSet<T> &p_query, 
+            template <typename Q>
+            void SearchTrees(const VectorIndex* p_index, const Q &p_query, 
                 COMMON::WorkSpace &p_space, const int p_limits) const
             {
                 while (!p_space.m_SPTQueue.empty())
@@ -311,22 +404,31 @@ namespace SPTAG
                         if (!p_space.CheckAndSet(tnode.centerid)) {
                             p_space.m_NGQueue.insert(COMMON::HeapCell(tnode.centerid, bcell.distance));
                         }
+                        // A pivot farther than the current worst result only needs a lower bound to be queued
+                        // behind the closer ones. Quantized results are on another scale, so they give no bound.
+                        float bound = (p_space.m_pQuantizedQuery == nullptr) ? p_query.worstDist() : MaxDist;
                         for (SizeType begin = tnode.childStart; begin < tnode.childEnd; begin++) {
                             SizeType index = m_pTreeRoots[begin].centerid;
-                            p_space.m_SPTQueue.insert(COMMON::HeapCell(begin, p_index->ComputeDistance((const void*)p_query.GetTarget(), p_index->GetSample(index))));
+                            bool abandoned;
+                            float dist = p_index->ComputeDistanceBounded((const void*)p_query.GetTarget(), p_index->GetSample(index), bound, abandoned);
+                            p_space.m_iNumberOfBoundedDistances++;
+                            if (abandoned) p_space.m_iNumberOfAbandonedDistances++;
+                            p_space.m_SPTQueue.insert(COMMON::HeapCell(begin, dist));
                         } 
                     }
                 }
             }
 
-        private:
-
-            template <typename T>
-            float KmeansAssign(VectorIndex* p_index,
+            // The k-means below only needs GetSample, GetFeatureDim, GetNumSamples and GetDistCalcMethod
+            // from p_index, so it also runs over sample sources other than a VectorIndex (the product
+            // quantizer trains its codebooks with it).
+            template <typename T, typename SampleSource>
+            float KmeansAssign(SampleSource* p_index,
                                std::vector<SizeType>& indices,
                                const SizeType first, const SizeType last, KmeansArgs<T>& args, const bool updateCenters) const {
                 float currDist = 0;
                 float lambda = (updateCenters) ? COMMON::Utils::GetBase<T>() * COMMON::Utils::GetBase<T>() / (100.0f * (last - first)) : 0.0f;
+                const DimensionType centerDim = p_index->GetFeatureDim() * KmeansCenterTraits<T>::Width;
                 SizeType subsize = (last - first - 1) / args._T + 1;
 
 #pragma omp parallel for num_threads(args._T) shared(indices) reduction(+:currDist)
@@ -335,7 +437,7 @@ namespace SPTAG
                     SizeType istart = first + tid * subsize;
                     SizeType iend = min(first + (tid + 1) * subsize, last);
                     SizeType *inewCounts = args.newCounts + tid * m_iBKTKmeansK;
-                    float *inewCenters = args.newCenters + tid * m_iBKTKmeansK * p_index->GetFeatureDim();
+                    float *inewCenters = args.newCenters + tid * m_iBKTKmeansK * centerDim;
                     SizeType * iclusterIdx = args.clusterIdx + tid * m_iBKTKmeansK;
                     float * iclusterDist = args.clusterDist + tid * m_iBKTKmeansK;
                     float idist = 0;
@@ -343,7 +445,7 @@ namespace SPTAG
                         int clusterid = 0;
                         float smallestDist = MaxDist;
                         for (int k = 0; k < m_iBKTKmeansK; k++) {
-                            float dist = p_index->ComputeDistance(p_index->GetSample(indices[i]), (const void*)(args.centers + k*p_index->GetFeatureDim())) + lambda*args.counts[k];
+                            float dist = args.fComputeDistance((const T*)p_index->GetSample(indices[i]), args.centers + k*p_index->GetFeatureDim(), p_index->GetFeatureDim()) + lambda*args.counts[k];
                             if (dist > -MaxDist && dist < smallestDist) {
                                 clusterid = k; smallestDist = dist;
                             }
@@ -353,8 +455,7 @@ namespace SPTAG
                         idist += smallestDist;
                         if (updateCenters) {
                             const T* v = (const T*)p_index->GetSample(indices[i]);
-                            float* center = inewCenters + clusterid*p_index->GetFeatureDim();
-                            for (DimensionType j = 0; j < p_index->GetFeatureDim(); j++) center[j] += v[j];
+                            KmeansCenterTraits<T>::Accumulate(inewCenters + clusterid*centerDim, v, p_index->GetFeatureDim());
                             if (smallestDist > iclusterDist[clusterid]) {
                                 iclusterDist[clusterid] = smallestDist;
                                 iclusterIdx[clusterid] = indices[i];
@@ -377,8 +478,8 @@ namespace SPTAG
 
                 if (updateCenters) {
                     for (int i = 1; i < args._T; i++) {
-                        float* currCenter = args.newCenters + i*m_iBKTKmeansK*p_index->GetFeatureDim();
-                        for (size_t j = 0; j < ((size_t)m_iBKTKmeansK) * p_index->GetFeatureDim(); j++) args.newCenters[j] += currCenter[j];
+                        float* currCenter = args.newCenters + i*m_iBKTKmeansK*centerDim;
+                        for (size_t j = 0; j < ((size_t)m_iBKTKmeansK) * centerDim; j++) args.newCenters[j] += currCenter[j];
 
                         for (int k = 0; k < m_iBKTKmeansK; k++) {
                             if (args.clusterIdx[i*m_iBKTKmeansK + k] != -1 && args.clusterDist[i*m_iBKTKmeansK + k] > args.clusterDist[k]) {
@@ -415,13 +516,13 @@ namespace SPTAG
                             }
                         }
                         else {
-                            float* currCenters = args.newCenters + k * p_index->GetFeatureDim();
-                            for (DimensionType j = 0; j < p_index->GetFeatureDim(); j++) currCenters[j] /= args.newCounts[k];
+                            float* currCenters = args.newCenters + k * centerDim;
+                            for (DimensionType j = 0; j < centerDim; j++) currCenters[j] /= args.newCounts[k];
 
-                            if (p_index->GetDistCalcMethod() == DistCalcMethod::Cosine) {
-                                COMMON::Utils::Normalize(currCenters, p_index->GetFeatureDim(), COMMON::Utils::GetBase<T>());
+                            if (p_index->GetDistCalcMethod() == DistCalcMethod::Cosine && !std::is_same<T, SPTAG::Binary>::value) {
+                                COMMON::Utils::Normalize(currCenters, centerDim, COMMON::Utils::GetBase<T>());
                             }
-                            for (DimensionType j = 0; j < p_index->GetFeatureDim(); j++) TCenter[j] = (T)(currCenters[j]);
+                            KmeansCenterTraits<T>::Assign(TCenter, currCenters, p_index->GetFeatureDim());
                         }
                     }
                 }
@@ -438,8 +539,8 @@ namespace SPTAG
                 return currDist;
             }
 
-            template <typename T>
-            int KmeansClustering(VectorIndex* p_index, 
+            template <typename T, typename SampleSource>
+            int KmeansClustering(SampleSource* p_index, 
                 std::vector<SizeType>& indices, const SizeType first, const SizeType last, KmeansArgs<T>& args) const {
                 int iterLimit = 100;
 
@@ -473,7 +574,7 @@ namespace SPTAG
 
                     currDiff = 0;
                     for (int k = 0; k < m_iBKTKmeansK; k++) {
-                        currDiff += p_index->ComputeDistance((const void*)(args.centers + k*p_index->GetFeatureDim()), (const void*)(args.newTCenters + k*p_index->GetFeatureDim()));
+                        currDiff += args.fComputeDistance(args.centers + k*p_index->GetFeatureDim(), args.newTCenters + k*p_index->GetFeatureDim(), p_index->GetFeatureDim());
                     }
 
                     if (currDist < minClusterDist) {
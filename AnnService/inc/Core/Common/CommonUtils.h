@@ -144,7 +144,9 @@ namespace SPTAG
 
             template<typename T>
             static inline int GetBase() {
-                if (GetEnumValueType<T>() != VectorValueType::Float) {
+                // Integer vectors are scaled to the full range of the type, floating point ones
+                // (including the 16-bit types) to unit length.
+                if (std::is_integral<T>::value) {
                     return (int)(std::numeric_limits<T>::max)();
                 }
                 return 1;
@@ -173,6 +175,10 @@ namespace SPTAG
                 }
             }
         };
+
+        // Binary vectors have no length to normalize; Hamming distance compares them as they are.
+        template <>
+        inline void Utils::Normalize<SPTAG::Binary>(SPTAG::Binary* arr, DimensionType col, int base) {}
     }
 }
 
@@ -215,6 +215,19 @@ namespace SPTAG
                 return true;
             }
 
+            // Moves row indices[i] to row i; indices is a permutation of all the rows.
+            bool Permute(const std::vector<SizeType>& indices)
+            {
+                if ((SizeType)(indices.size()) != R()) return false;
+
+                Dataset<T> moved;
+                Refine(indices, moved);
+                for (SizeType i = 0; i < R(); i++) {
+                    std::memcpy((void*)At(i), (void*)moved.At(i), sizeof(T) * cols);
+                }
+                return true;
+            }
+
             bool Refine(const std::vector<SizeType>& indices, std::ostream& output) const
             {
                 SizeType R = (SizeType)(indices.size());
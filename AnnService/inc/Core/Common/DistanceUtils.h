@@ -8,584 +8,301 @@
 #include <functional>
 
 #include "CommonUtils.h"
-
-#if defined(__AVX2__)
-#define AVX2
-#elif defined(__SSE2__)
-#define SSE2
-#endif
-
-#if defined(__AVX__)
-#define AVX
-#elif defined(__SSE__)
-#define SSE
-#endif
-
-#ifndef _MSC_VER
-#define DIFF128 diff128
-#define DIFF256 diff256
-#else
-#define DIFF128 diff128.m128_f32
-#define DIFF256 diff256.m256_f32
-#endif
+#include "InstructionUtils.h"
 
 namespace SPTAG
 {
     namespace COMMON
     {
+        template<typename T>
+        float (*DistanceCalcSelector(SPTAG::DistCalcMethod p_method)) (const T*, const T*, DimensionType);
+
+        template<typename T>
+        void (*DistanceBatchCalcSelector(SPTAG::DistCalcMethod p_method)) (const T*, const T* const*, int, DimensionType, float*);
+
+        template<typename T>
+        float (*DistanceCalcSelector(SPTAG::DistCalcMethod p_method, DimensionType p_dimension)) (const T*, const T*, DimensionType);
+
+        template<typename T>
+        void (*DistanceBatchCalcSelector(SPTAG::DistCalcMethod p_method, DimensionType p_dimension)) (const T*, const T* const*, int, DimensionType, float*);
+
         class DistanceUtils
         {
         public:
-#if defined(SSE2) || defined(AVX2)
-            static inline __m128 _mm_mul_epi8(__m128i X, __m128i Y)
+            // One kernel per instruction set; DistanceCalcSelector binds the widest one the CPU supports.
+            // The _AVX kernels need AVX2 for the integer and 16-bit float types (plus F16C for Float16)
+            // and only AVX for float.
+            static float ComputeL2Distance_SSE(const std::int8_t* pX, const std::int8_t* pY, DimensionType length);
+            static float ComputeL2Distance_AVX(const std::int8_t* pX, const std::int8_t* pY, DimensionType length);
+            static float ComputeL2Distance_AVX512(const std::int8_t* pX, const std::int8_t* pY, DimensionType length);
+            static float ComputeL2Distance_AVX512VNNI(const std::int8_t* pX, const std::int8_t* pY, DimensionType length);
+
+            static float ComputeL2Distance_SSE(const std::uint8_t* pX, const std::uint8_t* pY, DimensionType length);
+            static float ComputeL2Distance_AVX(const std::uint8_t* pX, const std::uint8_t* pY, DimensionType length);
+            static float ComputeL2Distance_AVX512(const std::uint8_t* pX, const std::uint8_t* pY, DimensionType length);
+            static float ComputeL2Distance_AVX512VNNI(const std::uint8_t* pX, const std::uint8_t* pY, DimensionType length);
+
+            static float ComputeL2Distance_SSE(const std::int16_t* pX, const std::int16_t* pY, DimensionType length);
+            static float ComputeL2Distance_AVX(const std::int16_t* pX, const std::int16_t* pY, DimensionType length);
+            static float ComputeL2Distance_AVX512(const std::int16_t* pX, const std::int16_t* pY, DimensionType length);
+
+            static float ComputeL2Distance_SSE(const float* pX, const float* pY, DimensionType length);
+            static float ComputeL2Distance_AVX(const float* pX, const float* pY, DimensionType length);
+            static float ComputeL2Distance_AVX512(const float* pX, const float* pY, DimensionType length);
+
+            static float ComputeL2Distance_SSE(const SPTAG::Float16* pX, const SPTAG::Float16* pY, DimensionType length);
+            static float ComputeL2Distance_AVX(const SPTAG::Float16* pX, const SPTAG::Float16* pY, DimensionType length);
+            static float ComputeL2Distance_AVX512(const SPTAG::Float16* pX, const SPTAG::Float16* pY, DimensionType length);
+
+            static float ComputeL2Distance_SSE(const SPTAG::BFloat16* pX, const SPTAG::BFloat16* pY, DimensionType length);
+            static float ComputeL2Distance_AVX(const SPTAG::BFloat16* pX, const SPTAG::BFloat16* pY, DimensionType length);
+            static float ComputeL2Distance_AVX512(const SPTAG::BFloat16* pX, const SPTAG::BFloat16* pY, DimensionType length);
+
+            static float ComputeCosineDistance_SSE(const std::int8_t* pX, const std::int8_t* pY, DimensionType length);
+            static float ComputeCosineDistance_AVX(const std::int8_t* pX, const std::int8_t* pY, DimensionType length);
+            static float ComputeCosineDistance_AVX512(const std::int8_t* pX, const std::int8_t* pY, DimensionType length);
+            static float ComputeCosineDistance_AVX512VNNI(const std::int8_t* pX, const std::int8_t* pY, DimensionType length);
+
+            static float ComputeCosineDistance_SSE(const std::uint8_t* pX, const std::uint8_t* pY, DimensionType length);
+            static float ComputeCosineDistance_AVX(const std::uint8_t* pX, const std::uint8_t* pY, DimensionType length);
+            static float ComputeCosineDistance_AVX512(const std::uint8_t* pX, const std::uint8_t* pY, DimensionType length);
+            static float ComputeCosineDistance_AVX512VNNI(const std::uint8_t* pX, const std::uint8_t* pY, DimensionType length);
+
+            static float ComputeCosineDistance_SSE(const std::int16_t* pX, const std::int16_t* pY, DimensionType length);
+            static float ComputeCosineDistance_AVX(const std::int16_t* pX, const std::int16_t* pY, DimensionType length);
+            static float ComputeCosineDistance_AVX512(const std::int16_t* pX, const std::int16_t* pY, DimensionType length);
+
+            static float ComputeCosineDistance_SSE(const float* pX, const float* pY, DimensionType length);
+            static float ComputeCosineDistance_AVX(const float* pX, const float* pY, DimensionType length);
+            static float ComputeCosineDistance_AVX512(const float* pX, const float* pY, DimensionType length);
+
+            static float ComputeCosineDistance_SSE(const SPTAG::Float16* pX, const SPTAG::Float16* pY, DimensionType length);
+            static float ComputeCosineDistance_AVX(const SPTAG::Float16* pX, const SPTAG::Float16* pY, DimensionType length);
+            static float ComputeCosineDistance_AVX512(const SPTAG::Float16* pX, const SPTAG::Float16* pY, DimensionType length);
+
+            static float ComputeCosineDistance_SSE(const SPTAG::BFloat16* pX, const SPTAG::BFloat16* pY, DimensionType length);
+            static float ComputeCosineDistance_AVX(const SPTAG::BFloat16* pX, const SPTAG::BFloat16* pY, DimensionType length);
+            static float ComputeCosineDistance_AVX512(const SPTAG::BFloat16* pX, const SPTAG::BFloat16* pY, DimensionType length);
+
+            // VNNI only helps the 8-bit kernels. Wider types never select these (see DistanceCalcSelector),
+            // they only exist so that the selector compiles for every value type.
+            template<typename T>
+            static float ComputeL2Distance_AVX512VNNI(const T* pX, const T* pY, DimensionType length)
             {
-                __m128i zero = _mm_setzero_si128();
-
-                __m128i sign_x = _mm_cmplt_epi8(X, zero);
-                __m128i sign_y = _mm_cmplt_epi8(Y, zero);
-
-                __m128i xlo = _mm_unpacklo_epi8(X, sign_x);
-                __m128i xhi = _mm_unpackhi_epi8(X, sign_x);
-                __m128i ylo = _mm_unpacklo_epi8(Y, sign_y);
-                __m128i yhi = _mm_unpackhi_epi8(Y, sign_y);
-                
-                return _mm_cvtepi32_ps(_mm_add_epi32(_mm_madd_epi16(xlo, ylo), _mm_madd_epi16(xhi, yhi)));
+                return ComputeL2Distance_AVX512(pX, pY, length);
             }
 
-            static inline __m128 _mm_sqdf_epi8(__m128i X, __m128i Y)
+            template<typename T>
+            static float ComputeCosineDistance_AVX512VNNI(const T* pX, const T* pY, DimensionType length)
             {
-                __m128i zero = _mm_setzero_si128();
-
-                __m128i sign_x = _mm_cmplt_epi8(X, zero);
-                __m128i sign_y = _mm_cmplt_epi8(Y, zero);
-
-                __m128i xlo = _mm_unpacklo_epi8(X, sign_x);
-                __m128i xhi = _mm_unpackhi_epi8(X, sign_x);
-                __m128i ylo = _mm_unpacklo_epi8(Y, sign_y);
-                __m128i yhi = _mm_unpackhi_epi8(Y, sign_y);
-                
-                __m128i dlo = _mm_sub_epi16(xlo, ylo);
-                __m128i dhi = _mm_sub_epi16(xhi, yhi);
-
-                return _mm_cvtepi32_ps(_mm_add_epi32(_mm_madd_epi16(dlo, dlo), _mm_madd_epi16(dhi, dhi)));
+                return ComputeCosineDistance_AVX512(pX, pY, length);
             }
 
-            static inline __m128 _mm_mul_epu8(__m128i X, __m128i Y)
-            {
-                __m128i zero = _mm_setzero_si128();
+            // Batched kernels score one query against up to BatchSize rows (the neighbors of one graph node)
+            // in a single pass. Rows are processed in blocks of four so that each chunk of the query is
+            // loaded once and stays in registers while it is applied to the whole block.
+            static const int BatchSize = 64;
 
-                __m128i xlo = _mm_unpacklo_epi8(X, zero);
-                __m128i xhi = _mm_unpackhi_epi8(X, zero);
-                __m128i ylo = _mm_unpacklo_epi8(Y, zero);
-                __m128i yhi = _mm_unpackhi_epi8(Y, zero);
+            static void ComputeL2DistanceBatch_AVX(const std::int8_t* pQuery, const std::int8_t* const* pRows, int count, DimensionType length, float* pResults);
+            static void ComputeL2DistanceBatch_AVX512(const std::int8_t* pQuery, const std::int8_t* const* pRows, int count, DimensionType length, float* pResults);
+            static void ComputeL2DistanceBatch_AVX512VNNI(const std::int8_t* pQuery, const std::int8_t* const* pRows, int count, DimensionType length, float* pResults);
 
-                return _mm_cvtepi32_ps(_mm_add_epi32(_mm_madd_epi16(xlo, ylo), _mm_madd_epi16(xhi, yhi)));
-            }
+            static void ComputeL2DistanceBatch_AVX(const std::uint8_t* pQuery, const std::uint8_t* const* pRows, int count, DimensionType length, float* pResults);
+            static void ComputeL2DistanceBatch_AVX512(const std::uint8_t* pQuery, const std::uint8_t* const* pRows, int count, DimensionType length, float* pResults);
+            static void ComputeL2DistanceBatch_AVX512VNNI(const std::uint8_t* pQuery, const std::uint8_t* const* pRows, int count, DimensionType length, float* pResults);
 
-            static inline __m128 _mm_sqdf_epu8(__m128i X, __m128i Y)
-            {
-                __m128i zero = _mm_setzero_si128();
+            static void ComputeL2DistanceBatch_AVX(const std::int16_t* pQuery, const std::int16_t* const* pRows, int count, DimensionType length, float* pResults);
+            static void ComputeL2DistanceBatch_AVX512(const std::int16_t* pQuery, const std::int16_t* const* pRows, int count, DimensionType length, float* pResults);
 
-                __m128i xlo = _mm_unpacklo_epi8(X, zero);
-                __m128i xhi = _mm_unpackhi_epi8(X, zero);
-                __m128i ylo = _mm_unpacklo_epi8(Y, zero);
-                __m128i yhi = _mm_unpackhi_epi8(Y, zero);
+            static void ComputeL2DistanceBatch_AVX(const float* pQuery, const float* const* pRows, int count, DimensionType length, float* pResults);
+            static void ComputeL2DistanceBatch_AVX512(const float* pQuery, const float* const* pRows, int count, DimensionType length, float* pResults);
 
-                __m128i dlo = _mm_sub_epi16(xlo, ylo);
-                __m128i dhi = _mm_sub_epi16(xhi, yhi);
+            static void ComputeL2DistanceBatch_AVX(const SPTAG::Float16* pQuery, const SPTAG::Float16* const* pRows, int count, DimensionType length, float* pResults);
+            static void ComputeL2DistanceBatch_AVX512(const SPTAG::Float16* pQuery, const SPTAG::Float16* const* pRows, int count, DimensionType length, float* pResults);
 
-                return _mm_cvtepi32_ps(_mm_add_epi32(_mm_madd_epi16(dlo, dlo), _mm_madd_epi16(dhi, dhi)));
-            }
+            static void ComputeL2DistanceBatch_AVX(const SPTAG::BFloat16* pQuery, const SPTAG::BFloat16* const* pRows, int count, DimensionType length, float* pResults);
+            static void ComputeL2DistanceBatch_AVX512(const SPTAG::BFloat16* pQuery, const SPTAG::BFloat16* const* pRows, int count, DimensionType length, float* pResults);
 
-            static inline __m128 _mm_mul_epi16(__m128i X, __m128i Y)
-            {
-                return _mm_cvtepi32_ps(_mm_madd_epi16(X, Y));
-            }
+            static void ComputeCosineDistanceBatch_AVX(const std::int8_t* pQuery, const std::int8_t* const* pRows, int count, DimensionType length, float* pResults);
+            static void ComputeCosineDistanceBatch_AVX512(const std::int8_t* pQuery, const std::int8_t* const* pRows, int count, DimensionType length, float* pResults);
+            static void ComputeCosineDistanceBatch_AVX512VNNI(const std::int8_t* pQuery, const std::int8_t* const* pRows, int count, DimensionType length, float* pResults);
 
-            static inline __m128 _mm_sqdf_epi16(__m128i X, __m128i Y)
-            {
-                __m128i zero = _mm_setzero_si128();
+            static void ComputeCosineDistanceBatch_AVX(const std::uint8_t* pQuery, const std::uint8_t* const* pRows, int count, DimensionType length, float* pResults);
+            static void ComputeCosineDistanceBatch_AVX512(const std::uint8_t* pQuery, const std::uint8_t* const* pRows, int count, DimensionType length, float* pResults);
+            static void ComputeCosineDistanceBatch_AVX512VNNI(const std::uint8_t* pQuery, const std::uint8_t* const* pRows, int count, DimensionType length, float* pResults);
 
-                __m128i sign_x = _mm_cmplt_epi16(X, zero);
-                __m128i sign_y = _mm_cmplt_epi16(Y, zero);
+            static void ComputeCosineDistanceBatch_AVX(const std::int16_t* pQuery, const std::int16_t* const* pRows, int count, DimensionType length, float* pResults);
+            static void ComputeCosineDistanceBatch_AVX512(const std::int16_t* pQuery, const std::int16_t* const* pRows, int count, DimensionType length, float* pResults);
 
-                __m128i xlo = _mm_unpacklo_epi16(X, sign_x);
-                __m128i xhi = _mm_unpackhi_epi16(X, sign_x);
-                __m128i ylo = _mm_unpacklo_epi16(Y, sign_y);
-                __m128i yhi = _mm_unpackhi_epi16(Y, sign_y);
+            static void ComputeCosineDistanceBatch_AVX(const float* pQuery, const float* const* pRows, int count, DimensionType length, float* pResults);
+            static void ComputeCosineDistanceBatch_AVX512(const float* pQuery, const float* const* pRows, int count, DimensionType length, float* pResults);
 
-                __m128 dlo = _mm_cvtepi32_ps(_mm_sub_epi32(xlo, ylo));
-                __m128 dhi = _mm_cvtepi32_ps(_mm_sub_epi32(xhi, yhi));
+            static void ComputeCosineDistanceBatch_AVX(const SPTAG::Float16* pQuery, const SPTAG::Float16* const* pRows, int count, DimensionType length, float* pResults);
+            static void ComputeCosineDistanceBatch_AVX512(const SPTAG::Float16* pQuery, const SPTAG::Float16* const* pRows, int count, DimensionType length, float* pResults);
 
-                return _mm_add_ps(_mm_mul_ps(dlo, dlo), _mm_mul_ps(dhi, dhi));
-            }
-#endif
-#if defined(SSE) || defined(AVX)
-            static inline __m128 _mm_sqdf_ps(__m128 X, __m128 Y)
+            static void ComputeCosineDistanceBatch_AVX(const SPTAG::BFloat16* pQuery, const SPTAG::BFloat16* const* pRows, int count, DimensionType length, float* pResults);
+            static void ComputeCosineDistanceBatch_AVX512(const SPTAG::BFloat16* pQuery, const SPTAG::BFloat16* const* pRows, int count, DimensionType length, float* pResults);
+
+            // SSE has too few registers for the blocked layout; score the rows one at a time.
+            template<typename T>
+            static void ComputeL2DistanceBatch_SSE(const T* pQuery, const T* const* pRows, int count, DimensionType length, float* pResults)
             {
-                __m128 d = _mm_sub_ps(X, Y);
-                return _mm_mul_ps(d, d);
+                for (int i = 0; i < count; i++) pResults[i] = ComputeL2Distance_SSE(pQuery, pRows[i], length);
             }
-#endif
-#if defined(AVX2)
-            static inline __m256 _mm256_mul_epi8(__m256i X, __m256i Y)
-            {
-                __m256i zero = _mm256_setzero_si256();
-
-                __m256i sign_x = _mm256_cmpgt_epi8(zero, X);
-                __m256i sign_y = _mm256_cmpgt_epi8(zero, Y);
 
-                __m256i xlo = _mm256_unpacklo_epi8(X, sign_x);
-                __m256i xhi = _mm256_unpackhi_epi8(X, sign_x);
-                __m256i ylo = _mm256_unpacklo_epi8(Y, sign_y);
-                __m256i yhi = _mm256_unpackhi_epi8(Y, sign_y);
-
-                return _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_madd_epi16(xlo, ylo), _mm256_madd_epi16(xhi, yhi)));
-            }
-            static inline __m256 _mm256_sqdf_epi8(__m256i X, __m256i Y)
+            template<typename T>
+            static void ComputeCosineDistanceBatch_SSE(const T* pQuery, const T* const* pRows, int count, DimensionType length, float* pResults)
             {
-                __m256i zero = _mm256_setzero_si256();
-
-                __m256i sign_x = _mm256_cmpgt_epi8(zero, X);
-                __m256i sign_y = _mm256_cmpgt_epi8(zero, Y);
-
-                __m256i xlo = _mm256_unpacklo_epi8(X, sign_x);
-                __m256i xhi = _mm256_unpackhi_epi8(X, sign_x);
-                __m256i ylo = _mm256_unpacklo_epi8(Y, sign_y);
-                __m256i yhi = _mm256_unpackhi_epi8(Y, sign_y);
-
-                __m256i dlo = _mm256_sub_epi16(xlo, ylo);
-                __m256i dhi = _mm256_sub_epi16(xhi, yhi);
-
-                return _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_madd_epi16(dlo, dlo), _mm256_madd_epi16(dhi, dhi)));
+                for (int i = 0; i < count; i++) pResults[i] = ComputeCosineDistance_SSE(pQuery, pRows[i], length);
             }
-            static inline __m256 _mm256_mul_epu8(__m256i X, __m256i Y)
-            {
-                __m256i zero = _mm256_setzero_si256();
-
-                __m256i xlo = _mm256_unpacklo_epi8(X, zero);
-                __m256i xhi = _mm256_unpackhi_epi8(X, zero);
-                __m256i ylo = _mm256_unpacklo_epi8(Y, zero);
-                __m256i yhi = _mm256_unpackhi_epi8(Y, zero);
 
-                return _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_madd_epi16(xlo, ylo), _mm256_madd_epi16(xhi, yhi)));
-            }
-            static inline __m256 _mm256_sqdf_epu8(__m256i X, __m256i Y)
+            template<typename T>
+            static void ComputeL2DistanceBatch_AVX512VNNI(const T* pQuery, const T* const* pRows, int count, DimensionType length, float* pResults)
             {
-                __m256i zero = _mm256_setzero_si256();
-
-                __m256i xlo = _mm256_unpacklo_epi8(X, zero);
-                __m256i xhi = _mm256_unpackhi_epi8(X, zero);
-                __m256i ylo = _mm256_unpacklo_epi8(Y, zero);
-                __m256i yhi = _mm256_unpackhi_epi8(Y, zero);
-
-                __m256i dlo = _mm256_sub_epi16(xlo, ylo);
-                __m256i dhi = _mm256_sub_epi16(xhi, yhi);
-
-                return _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_madd_epi16(dlo, dlo), _mm256_madd_epi16(dhi, dhi)));
+                ComputeL2DistanceBatch_AVX512(pQuery, pRows, count, length, pResults);
             }
-            static inline __m256 _mm256_mul_epi16(__m256i X, __m256i Y)
+
+            template<typename T>
+            static void ComputeCosineDistanceBatch_AVX512VNNI(const T* pQuery, const T* const* pRows, int count, DimensionType length, float* pResults)
             {
-                return _mm256_cvtepi32_ps(_mm256_madd_epi16(X, Y));
+                ComputeCosineDistanceBatch_AVX512(pQuery, pRows, count, length, pResults);
             }
-            static inline __m256 _mm256_sqdf_epi16(__m256i X, __m256i Y)
-            {
-                __m256i zero = _mm256_setzero_si256();
-
-                __m256i sign_x = _mm256_cmpgt_epi16(zero, X);
-                __m256i sign_y = _mm256_cmpgt_epi16(zero, Y);
-
-                __m256i xlo = _mm256_unpacklo_epi16(X, sign_x);
-                __m256i xhi = _mm256_unpackhi_epi16(X, sign_x);
-                __m256i ylo = _mm256_unpacklo_epi16(Y, sign_y);
-                __m256i yhi = _mm256_unpackhi_epi16(Y, sign_y);
 
-                __m256 dlo = _mm256_cvtepi32_ps(_mm256_sub_epi32(xlo, ylo));
-                __m256 dhi = _mm256_cvtepi32_ps(_mm256_sub_epi32(xhi, yhi));
+            // Hamming distance is the number of differing bits in the raw bytes of two vectors. It is
+            // meant for Binary vectors but is well defined for every value type, so the kernels work
+            // on bytes and the typed entries below only convert the length.
+            static float CountDifferingBits_SSE(const std::uint8_t* pX, const std::uint8_t* pY, std::size_t bytes);
+            static float CountDifferingBits_POPCNT(const std::uint8_t* pX, const std::uint8_t* pY, std::size_t bytes);
+            static float CountDifferingBits_AVX512VPOPCNTDQ(const std::uint8_t* pX, const std::uint8_t* pY, std::size_t bytes);
+            static void CountDifferingBitsBatch_AVX512VPOPCNTDQ(const std::uint8_t* pQuery, const std::uint8_t* const* pRows, int count, std::size_t bytes, float* pResults);
 
-                return _mm256_add_ps(_mm256_mul_ps(dlo, dlo), _mm256_mul_ps(dhi, dhi));
-            }
-#endif
-#if defined(AVX)
-            static inline __m256 _mm256_sqdf_ps(__m256 X, __m256 Y)
+            template<typename T>
+            static float ComputeHammingDistance_SSE(const T* pX, const T* pY, DimensionType length)
             {
-                __m256 d = _mm256_sub_ps(X, Y);
-                return _mm256_mul_ps(d, d);
+                return CountDifferingBits_SSE((const std::uint8_t*)pX, (const std::uint8_t*)pY, sizeof(T) * length);
             }
-#endif
-/*
+
             template<typename T>
-            static float ComputeL2Distance(const T *pX, const T *pY, DimensionType length)
+            static float ComputeHammingDistance_POPCNT(const T* pX, const T* pY, DimensionType length)
             {
-                float diff = 0;
-                const T* pEnd1 = pX + length;
-                while (pX < pEnd1) {
-                    float c1 = ((float)(*pX++) - (float)(*pY++)); diff += c1 * c1;
-                }
-                return diff;
+                return CountDifferingBits_POPCNT((const std::uint8_t*)pX, (const std::uint8_t*)pY, sizeof(T) * length);
             }
-*/
-#define REPEAT(type, ctype, delta, load, exec, acc, result) \
-            { \
-                type c1 = load((ctype *)(pX)); \
-                type c2 = load((ctype *)(pY)); \
-                pX += delta; pY += delta; \
-                result = acc(result, exec(c1, c2)); \
-            } \
-
-            static float ComputeL2Distance(const std::int8_t *pX, const std::int8_t *pY, DimensionType length)
+
+            template<typename T>
+            static float ComputeHammingDistance_AVX512VPOPCNTDQ(const T* pX, const T* pY, DimensionType length)
             {
-                const std::int8_t* pEnd32 = pX + ((length >> 5) << 5);
-                const std::int8_t* pEnd16 = pX + ((length >> 4) << 4);
-                const std::int8_t* pEnd4 = pX + ((length >> 2) << 2);
-                const std::int8_t* pEnd1 = pX + length;
-#if defined(SSE2)
-                __m128 diff128 = _mm_setzero_ps();
-                while (pX < pEnd32) {
-                    REPEAT(__m128i, __m128i, 16, _mm_loadu_si128, _mm_sqdf_epi8, _mm_add_ps, diff128)
-                    REPEAT(__m128i, __m128i, 16, _mm_loadu_si128, _mm_sqdf_epi8, _mm_add_ps, diff128)
-                }
-                while (pX < pEnd16) {
-                    REPEAT(__m128i, __m128i, 16, _mm_loadu_si128, _mm_sqdf_epi8, _mm_add_ps, diff128)
-                }
-                float diff = DIFF128[0] + DIFF128[1] + DIFF128[2] + DIFF128[3];
-#elif defined(AVX2)
-                __m256 diff256 = _mm256_setzero_ps();
-                while (pX < pEnd32) {
-                    REPEAT(__m256i, __m256i, 32, _mm256_loadu_si256, _mm256_sqdf_epi8, _mm256_add_ps, diff256)
-                }
-                __m128 diff128 = _mm_add_ps(_mm256_castps256_ps128(diff256), _mm256_extractf128_ps(diff256, 1));
-                while (pX < pEnd16) {
-                    REPEAT(__m128i, __m128i, 16, _mm_loadu_si128, _mm_sqdf_epi8, _mm_add_ps, diff128)
-                }
-                float diff = DIFF128[0] + DIFF128[1] + DIFF128[2] + DIFF128[3];
-#else
-                float diff = 0;
-#endif
-                while (pX < pEnd4) {
-                    float c1 = ((float)(*pX++) - (float)(*pY++)); diff += c1 * c1;
-                    c1 = ((float)(*pX++) - (float)(*pY++)); diff += c1 * c1;
-                    c1 = ((float)(*pX++) - (float)(*pY++)); diff += c1 * c1;
-                    c1 = ((float)(*pX++) - (float)(*pY++)); diff += c1 * c1;
-                }
-                while (pX < pEnd1) {
-                    float c1 = ((float)(*pX++) - (float)(*pY++)); diff += c1 * c1;
-                }
-                return diff;
+                return CountDifferingBits_AVX512VPOPCNTDQ((const std::uint8_t*)pX, (const std::uint8_t*)pY, sizeof(T) * length);
             }
 
-            static float ComputeL2Distance(const std::uint8_t *pX, const std::uint8_t *pY, DimensionType length)
+            template<typename T>
+            static void ComputeHammingDistanceBatch_SSE(const T* pQuery, const T* const* pRows, int count, DimensionType length, float* pResults)
             {
-                const std::uint8_t* pEnd32 = pX + ((length >> 5) << 5);
-                const std::uint8_t* pEnd16 = pX + ((length >> 4) << 4);
-                const std::uint8_t* pEnd4 = pX + ((length >> 2) << 2);
-                const std::uint8_t* pEnd1 = pX + length;
-#if defined(SSE2)
-                __m128 diff128 = _mm_setzero_ps();
-                while (pX < pEnd32) {
-                    REPEAT(__m128i, __m128i, 16, _mm_loadu_si128, _mm_sqdf_epu8, _mm_add_ps, diff128)
-                    REPEAT(__m128i, __m128i, 16, _mm_loadu_si128, _mm_sqdf_epu8, _mm_add_ps, diff128)
-                }
-                while (pX < pEnd16) {
-                    REPEAT(__m128i, __m128i, 16, _mm_loadu_si128, _mm_sqdf_epu8, _mm_add_ps, diff128)
-                }
-                float diff = DIFF128[0] + DIFF128[1] + DIFF128[2] + DIFF128[3];
-#elif defined(AVX2)
-                __m256 diff256 = _mm256_setzero_ps();
-                while (pX < pEnd32) {
-                    REPEAT(__m256i, __m256i, 32, _mm256_loadu_si256, _mm256_sqdf_epu8, _mm256_add_ps, diff256)
-                }
-                __m128 diff128 = _mm_add_ps(_mm256_castps256_ps128(diff256), _mm256_extractf128_ps(diff256, 1));
-                while (pX < pEnd16) {
-                    REPEAT(__m128i, __m128i, 16, _mm_loadu_si128, _mm_sqdf_epu8, _mm_add_ps, diff128)
-                }
-                float diff = DIFF128[0] + DIFF128[1] + DIFF128[2] + DIFF128[3];
-#else
-                float diff = 0;
-#endif
-                while (pX < pEnd4) {
-                    float c1 = ((float)(*pX++) - (float)(*pY++)); diff += c1 * c1;
-                    c1 = ((float)(*pX++) - (float)(*pY++)); diff += c1 * c1;
-                    c1 = ((float)(*pX++) - (float)(*pY++)); diff += c1 * c1;
-                    c1 = ((float)(*pX++) - (float)(*pY++)); diff += c1 * c1;
-                }
-                while (pX < pEnd1) {
-                    float c1 = ((float)(*pX++) - (float)(*pY++)); diff += c1 * c1;
-                }
-                return diff;
+                for (int i = 0; i < count; i++) pResults[i] = ComputeHammingDistance_SSE(pQuery, pRows[i], length);
             }
 
-            static float ComputeL2Distance(const std::int16_t *pX, const std::int16_t *pY, DimensionType length)
+            template<typename T>
+            static void ComputeHammingDistanceBatch_POPCNT(const T* pQuery, const T* const* pRows, int count, DimensionType length, float* pResults)
             {
-                const std::int16_t* pEnd16 = pX + ((length >> 4) << 4);
-                const std::int16_t* pEnd8 = pX + ((length >> 3) << 3);
-                const std::int16_t* pEnd4 = pX + ((length >> 2) << 2);
-                const std::int16_t* pEnd1 = pX + length;
-#if defined(SSE2)
-                __m128 diff128 = _mm_setzero_ps();
-                while (pX < pEnd16) {
-                    REPEAT(__m128i, __m128i, 8, _mm_loadu_si128, _mm_sqdf_epi16, _mm_add_ps, diff128)
-                    REPEAT(__m128i, __m128i, 8, _mm_loadu_si128, _mm_sqdf_epi16, _mm_add_ps, diff128)
-                }
-                while (pX < pEnd8) {
-                    REPEAT(__m128i, __m128i, 8, _mm_loadu_si128, _mm_sqdf_epi16, _mm_add_ps, diff128)
-                }
-                float diff = DIFF128[0] + DIFF128[1] + DIFF128[2] + DIFF128[3];
-#elif defined(AVX2)
-                __m256 diff256 = _mm256_setzero_ps();
-                while (pX < pEnd16) {
-                    REPEAT(__m256i, __m256i, 16, _mm256_loadu_si256, _mm256_sqdf_epi16, _mm256_add_ps, diff256)
-                }
-                __m128 diff128 = _mm_add_ps(_mm256_castps256_ps128(diff256), _mm256_extractf128_ps(diff256, 1));
-                while (pX < pEnd8) {
-                    REPEAT(__m128i, __m128i, 8, _mm_loadu_si128, _mm_sqdf_epi16, _mm_add_ps, diff128)
-                }
-                float diff = DIFF128[0] + DIFF128[1] + DIFF128[2] + DIFF128[3];
-#else
-                float diff = 0;
-#endif
-                while (pX < pEnd4) {
-                    float c1 = ((float)(*pX++) - (float)(*pY++)); diff += c1 * c1;
-                    c1 = ((float)(*pX++) - (float)(*pY++)); diff += c1 * c1;
-                    c1 = ((float)(*pX++) - (float)(*pY++)); diff += c1 * c1;
-                    c1 = ((float)(*pX++) - (float)(*pY++)); diff += c1 * c1;
-                }
-
-                while (pX < pEnd1) {
-                    float c1 = ((float)(*pX++) - (float)(*pY++)); diff += c1 * c1;
-                }
-                return diff;
+                for (int i = 0; i < count; i++) pResults[i] = ComputeHammingDistance_POPCNT(pQuery, pRows[i], length);
             }
 
-            static float ComputeL2Distance(const float *pX, const float *pY, DimensionType length)
+            template<typename T>
+            static void ComputeHammingDistanceBatch_AVX512VPOPCNTDQ(const T* pQuery, const T* const* pRows, int count, DimensionType length, float* pResults)
             {
-                const float* pEnd16 = pX + ((length >> 4) << 4);
-                const float* pEnd4 = pX + ((length >> 2) << 2);
-                const float* pEnd1 = pX + length;
-#if defined(SSE)
-                __m128 diff128 = _mm_setzero_ps();
-                while (pX < pEnd16)
-                {
-                    REPEAT(__m128, const float, 4, _mm_loadu_ps, _mm_sqdf_ps, _mm_add_ps, diff128)
-                    REPEAT(__m128, const float, 4, _mm_loadu_ps, _mm_sqdf_ps, _mm_add_ps, diff128)
-                    REPEAT(__m128, const float, 4, _mm_loadu_ps, _mm_sqdf_ps, _mm_add_ps, diff128)
-                    REPEAT(__m128, const float, 4, _mm_loadu_ps, _mm_sqdf_ps, _mm_add_ps, diff128)
-                }
-                while (pX < pEnd4)
-                {
-                    REPEAT(__m128, const float, 4, _mm_loadu_ps, _mm_sqdf_ps, _mm_add_ps, diff128)
-                }
-                float diff = DIFF128[0] + DIFF128[1] + DIFF128[2] + DIFF128[3];
-#elif defined(AVX)
-                __m256 diff256 = _mm256_setzero_ps();
-                while (pX < pEnd16)
-                {
-                    REPEAT(__m256, const float, 8, _mm256_loadu_ps, _mm256_sqdf_ps, _mm256_add_ps, diff256)
-                    REPEAT(__m256, const float, 8, _mm256_loadu_ps, _mm256_sqdf_ps, _mm256_add_ps, diff256)
-                }
-                __m128 diff128 = _mm_add_ps(_mm256_castps256_ps128(diff256), _mm256_extractf128_ps(diff256, 1));
-                while (pX < pEnd4)
-                {
-                    REPEAT(__m128, const float, 4, _mm_loadu_ps, _mm_sqdf_ps, _mm_add_ps, diff128)
-                }
-                float diff = DIFF128[0] + DIFF128[1] + DIFF128[2] + DIFF128[3];
-#else
-                float diff = 0;
-                while (pX < pEnd4) {
-                    float c1 = (*pX++) - (*pY++); diff += c1 * c1;
-                    c1 = (*pX++) - (*pY++); diff += c1 * c1;
-                    c1 = (*pX++) - (*pY++); diff += c1 * c1;
-                    c1 = (*pX++) - (*pY++); diff += c1 * c1;
-                }
-#endif
-                while (pX < pEnd1) {
-                    float c1 = (*pX++) - (*pY++); diff += c1 * c1;
-                }
-                return diff;
+                CountDifferingBitsBatch_AVX512VPOPCNTDQ((const std::uint8_t*)pQuery, (const std::uint8_t* const*)pRows, count, sizeof(T) * length, pResults);
             }
-/*
+
+            // Bounded distances give up once the running sum exceeds p_bound, and then return that partial
+            // sum: a lower bound of the distance that is itself above p_bound. This only holds for methods
+            // whose partial sums never decrease, i.e. L2 and Hamming. The regular kernels are run over
+            // blocks of AbandonBlockBytes, with the bound checked between blocks, so vectors that fit in
+            // one block are always scored in full.
+            static const int AbandonBlockBytes = 512;
+
             template<typename T>
-            static float ComputeCosineDistance(const T *pX, const T *pY, DimensionType length) {
-                float diff = 0;
-                const T* pEnd1 = pX + length;
-                while (pX < pEnd1) diff += (*pX++) * (*pY++);
-                return 1 - diff;
-            }
-*/
-            static float ComputeCosineDistance(const std::int8_t *pX, const std::int8_t *pY, DimensionType length) {
-                const std::int8_t* pEnd32 = pX + ((length >> 5) << 5);
-                const std::int8_t* pEnd16 = pX + ((length >> 4) << 4);
-                const std::int8_t* pEnd4 = pX + ((length >> 2) << 2);
-                const std::int8_t* pEnd1 = pX + length;
-#if defined(SSE2)
-
-                __m128 diff128 = _mm_setzero_ps();
-                while (pX < pEnd32) {
-                    REPEAT(__m128i, __m128i, 16, _mm_loadu_si128, _mm_mul_epi8, _mm_add_ps, diff128)
-                    REPEAT(__m128i, __m128i, 16, _mm_loadu_si128, _mm_mul_epi8, _mm_add_ps, diff128)
-                }
-                while (pX < pEnd16) {
-                    REPEAT(__m128i, __m128i, 16, _mm_loadu_si128, _mm_mul_epi8, _mm_add_ps, diff128)
-                }
-                float diff = DIFF128[0] + DIFF128[1] + DIFF128[2] + DIFF128[3];
-#elif defined(AVX2)
-                __m256 diff256 = _mm256_setzero_ps();
-                while (pX < pEnd32) {
-                    REPEAT(__m256i, __m256i, 32, _mm256_loadu_si256, _mm256_mul_epi8, _mm256_add_ps, diff256)
-                }
-                __m128 diff128 = _mm_add_ps(_mm256_castps256_ps128(diff256), _mm256_extractf128_ps(diff256, 1));
-                while (pX < pEnd16) {
-                    REPEAT(__m128i, __m128i, 16, _mm_loadu_si128, _mm_mul_epi8, _mm_add_ps, diff128)
-                }
-                float diff = DIFF128[0] + DIFF128[1] + DIFF128[2] + DIFF128[3];
-#else
-                float diff = 0;
-#endif
-                while (pX < pEnd4)
-                {
-                    float c1 = ((float)(*pX++) * (float)(*pY++)); diff += c1;
-                    c1 = ((float)(*pX++) * (float)(*pY++)); diff += c1;
-                    c1 = ((float)(*pX++) * (float)(*pY++)); diff += c1;
-                    c1 = ((float)(*pX++) * (float)(*pY++)); diff += c1;
-                }
-                while (pX < pEnd1) diff += ((float)(*pX++) * (float)(*pY++));
-                return 16129 - diff;
+            static float ComputeDistanceBounded(float(*fComputeDistance)(const T*, const T*, DimensionType), const T* pX, const T* pY, DimensionType length, float p_bound, bool& p_abandoned)
+            {
+                const DimensionType block = AbandonBlockBytes / sizeof(T);
+                p_abandoned = false;
+                if (length <= block) return fComputeDistance(pX, pY, length);
+
+                float dist = 0;
+                for (DimensionType d = 0; d < length; d += block) {
+                    dist += fComputeDistance(pX + d, pY + d, min(block, length - d));
+                    if (dist > p_bound && d + block < length) {
+                        p_abandoned = true;
+                        break;
+                    }
+                }
+                return dist;
             }
 
-            static float ComputeCosineDistance(const std::uint8_t *pX, const std::uint8_t *pY, DimensionType length) {
-                const std::uint8_t* pEnd32 = pX + ((length >> 5) << 5);
-                const std::uint8_t* pEnd16 = pX + ((length >> 4) << 4);
-                const std::uint8_t* pEnd4 = pX + ((length >> 2) << 2);
-                const std::uint8_t* pEnd1 = pX + length;
-#if defined(SSE2)
-
-                __m128 diff128 = _mm_setzero_ps();
-                while (pX < pEnd32) {
-                    REPEAT(__m128i, __m128i, 16, _mm_loadu_si128, _mm_mul_epu8, _mm_add_ps, diff128)
-                    REPEAT(__m128i, __m128i, 16, _mm_loadu_si128, _mm_mul_epu8, _mm_add_ps, diff128)
-                }
-                while (pX < pEnd16) {
-                    REPEAT(__m128i, __m128i, 16, _mm_loadu_si128, _mm_mul_epu8, _mm_add_ps, diff128)
-                }
-                float diff = DIFF128[0] + DIFF128[1] + DIFF128[2] + DIFF128[3];
-#elif defined(AVX2)
-                __m256 diff256 = _mm256_setzero_ps();
-                while (pX < pEnd32) {
-                    REPEAT(__m256i, __m256i, 32, _mm256_loadu_si256, _mm256_mul_epu8, _mm256_add_ps, diff256)
-                }
-                __m128 diff128 = _mm_add_ps(_mm256_castps256_ps128(diff256), _mm256_extractf128_ps(diff256, 1));
-                while (pX < pEnd16) {
-                    REPEAT(__m128i, __m128i, 16, _mm_loadu_si128, _mm_mul_epu8, _mm_add_ps, diff128)
-                }
-                float diff = DIFF128[0] + DIFF128[1] + DIFF128[2] + DIFF128[3];
-#else
-                float diff = 0;
-#endif
-                while (pX < pEnd4)
-                {
-                    float c1 = ((float)(*pX++) * (float)(*pY++)); diff += c1;
-                    c1 = ((float)(*pX++) * (float)(*pY++)); diff += c1;
-                    c1 = ((float)(*pX++) * (float)(*pY++)); diff += c1;
-                    c1 = ((float)(*pX++) * (float)(*pY++)); diff += c1;
-                }
-                while (pX < pEnd1) diff += ((float)(*pX++) * (float)(*pY++));
-                return 65025 - diff;
+            // Batched form for at most BatchSize rows: rows leave the batch as soon as they pass p_bound.
+            // Returns the number of abandoned rows.
+            template<typename T>
+            static int ComputeDistanceBatchBounded(void(*fComputeDistanceBatch)(const T*, const T* const*, int, DimensionType, float*), const T* pQuery, const T* const* pRows, int count, DimensionType length, float p_bound, float* pResults)
+            {
+                const DimensionType block = AbandonBlockBytes / sizeof(T);
+                if (length <= block) {
+                    fComputeDistanceBatch(pQuery, pRows, count, length, pResults);
+                    return 0;
+                }
+
+                const T* rows[BatchSize];
+                int live[BatchSize];
+                float partial[BatchSize];
+                int liveCount = count, abandoned = 0;
+                for (int i = 0; i < count; i++) {
+                    live[i] = i;
+                    pResults[i] = 0;
+                }
+                for (DimensionType d = 0; d < length && liveCount > 0; d += block) {
+                    for (int i = 0; i < liveCount; i++) rows[i] = pRows[live[i]] + d;
+                    fComputeDistanceBatch(pQuery + d, rows, liveCount, min(block, length - d), partial);
+
+                    const bool last = (d + block >= length);
+                    int next = 0;
+                    for (int i = 0; i < liveCount; i++) {
+                        pResults[live[i]] += partial[i];
+                        if (!last && pResults[live[i]] > p_bound) abandoned++;
+                        else live[next++] = live[i];
+                    }
+                    liveCount = next;
+                }
+                return abandoned;
             }
 
-    static float ComputeCosineDistance(const std::int16_t *pX, const std::int16_t *pY, DimensionType length) {
-                const std::int16_t* pEnd16 = pX + ((length >> 4) << 4);
-                const std::int16_t* pEnd8 = pX + ((length >> 3) << 3);
-                const std::int16_t* pEnd4 = pX + ((length >> 2) << 2);
-                const std::int16_t* pEnd1 = pX + length;
-#if defined(SSE2)
-                __m128 diff128 = _mm_setzero_ps();
-                while (pX < pEnd16) {
-                    REPEAT(__m128i, __m128i, 8, _mm_loadu_si128, _mm_mul_epi16, _mm_add_ps, diff128)
-                    REPEAT(__m128i, __m128i, 8, _mm_loadu_si128, _mm_mul_epi16, _mm_add_ps, diff128)
-                }
-                while (pX < pEnd8) {
-                    REPEAT(__m128i, __m128i, 8, _mm_loadu_si128, _mm_mul_epi16, _mm_add_ps, diff128)
-                }
-                float diff = DIFF128[0] + DIFF128[1] + DIFF128[2] + DIFF128[3];
+            // Kernels compiled for one (value type, method, dimension), looked up in the table in
+            // DistanceUtils.cpp: float, Int8 and UInt8 vectors of 96, 128, 256 or 768 dimensions under
+            // L2, Cosine or InnerProduct. They still accept any length and defer to the generic kernel
+            // for other lengths. Returns false, leaving the outputs alone, when none fits this CPU.
+            template<typename T>
+            static bool SelectFixedDimensionKernels(SPTAG::DistCalcMethod p_method, DimensionType p_dimension,
+                float(*&p_pair)(const T*, const T*, DimensionType), void(*&p_batch)(const T*, const T* const*, int, DimensionType, float*));
 
-#elif defined(AVX2)
-                __m256 diff256 = _mm256_setzero_ps();
-                while (pX < pEnd16) {
-                    REPEAT(__m256i, __m256i, 16, _mm256_loadu_si256, _mm256_mul_epi16, _mm256_add_ps, diff256)
-                }
-                __m128 diff128 = _mm_add_ps(_mm256_castps256_ps128(diff256), _mm256_extractf128_ps(diff256, 1));
-                while (pX < pEnd8) {
-                    REPEAT(__m128i, __m128i, 8, _mm_loadu_si128, _mm_mul_epi16, _mm_add_ps, diff128)
-                }
-                float diff = DIFF128[0] + DIFF128[1] + DIFF128[2] + DIFF128[3];
-#else
-                float diff = 0;
-#endif
-                while (pX < pEnd4)
-                {
-                    float c1 = ((float)(*pX++) * (float)(*pY++)); diff += c1;
-                    c1 = ((float)(*pX++) * (float)(*pY++)); diff += c1;
-                    c1 = ((float)(*pX++) * (float)(*pY++)); diff += c1;
-                    c1 = ((float)(*pX++) * (float)(*pY++)); diff += c1;
-                }
+            // Whether the bounded distances above are valid for a method on value type T.
+            template<typename T>
+            static inline bool SupportsBoundedDistance(SPTAG::DistCalcMethod p_method)
+            {
+                return p_method == SPTAG::DistCalcMethod::L2 || p_method == SPTAG::DistCalcMethod::Hamming || std::is_same<T, SPTAG::Binary>::value;
+            }
 
-                while (pX < pEnd1) diff += ((float)(*pX++) * (float)(*pY++));
-                return  1073676289 - diff;
+            template<typename T>
+            static inline float ComputeL2Distance(const T *pX, const T *pY, DimensionType length)
+            {
+                return DistanceCalcSelector<T>(SPTAG::DistCalcMethod::L2)(pX, pY, length);
             }
 
-            static float ComputeCosineDistance(const float *pX, const float *pY, DimensionType length) {
-                const float* pEnd16 = pX + ((length >> 4) << 4);
-                const float* pEnd4 = pX + ((length >> 2) << 2);
-                const float* pEnd1 = pX + length;
-#if defined(SSE)
-                __m128 diff128 = _mm_setzero_ps();
-                while (pX < pEnd16)
-                {
-                    REPEAT(__m128, const float, 4, _mm_loadu_ps, _mm_mul_ps, _mm_add_ps, diff128)
-                    REPEAT(__m128, const float, 4, _mm_loadu_ps, _mm_mul_ps, _mm_add_ps, diff128)
-                    REPEAT(__m128, const float, 4, _mm_loadu_ps, _mm_mul_ps, _mm_add_ps, diff128)
-                    REPEAT(__m128, const float, 4, _mm_loadu_ps, _mm_mul_ps, _mm_add_ps, diff128)
-                }
-                while (pX < pEnd4)
-                {
-                    REPEAT(__m128, const float, 4, _mm_loadu_ps, _mm_mul_ps, _mm_add_ps, diff128)
-                }
-                float diff = DIFF128[0] + DIFF128[1] + DIFF128[2] + DIFF128[3];
-
-#elif defined(AVX)
-                __m256 diff256 = _mm256_setzero_ps();
-                while (pX < pEnd16)
-                {
-                    REPEAT(__m256, const float, 8, _mm256_loadu_ps, _mm256_mul_ps, _mm256_add_ps, diff256)
-                    REPEAT(__m256, const float, 8, _mm256_loadu_ps, _mm256_mul_ps, _mm256_add_ps, diff256)
-                }
-                __m128 diff128 = _mm_add_ps(_mm256_castps256_ps128(diff256), _mm256_extractf128_ps(diff256, 1));
-                while (pX < pEnd4)
-                {
-                    REPEAT(__m128, const float, 4, _mm_loadu_ps, _mm_mul_ps, _mm_add_ps, diff128)
-                }
-                float diff = DIFF128[0] + DIFF128[1] + DIFF128[2] + DIFF128[3];
-#else
-                float diff = 0;
-                while (pX < pEnd4)
-                {
-                    float c1 = (*pX++) * (*pY++); diff += c1;
-                    c1 = (*pX++) * (*pY++); diff += c1;
-                    c1 = (*pX++) * (*pY++); diff += c1;
-                    c1 = (*pX++) * (*pY++); diff += c1;
-                }
-#endif
-                while (pX < pEnd1) diff += (*pX++) * (*pY++);
-                return 1 - diff;
+            template<typename T>
+            static inline float ComputeCosineDistance(const T *pX, const T *pY, DimensionType length)
+            {
+                return DistanceCalcSelector<T>(SPTAG::DistCalcMethod::Cosine)(pX, pY, length);
             }
 
             template<typename T>
             static inline float ComputeDistance(const T *p1, const T *p2, DimensionType length, SPTAG::DistCalcMethod distCalcMethod)
             {
-                if (distCalcMethod == SPTAG::DistCalcMethod::L2)
-                    return ComputeL2Distance(p1, p2, length);
-
-                return ComputeCosineDistance(p1, p2, length);
+                return DistanceCalcSelector<T>(distCalcMethod)(p1, p2, length);
             }
 
             static inline float ConvertCosineSimilarityToDistance(float cs)
@@ -603,16 +320,96 @@ namespace SPTAG
         };
 
 
+        template<typename T>
+        float (*HammingDistanceCalcSelector()) (const T*, const T*, DimensionType)
+        {
+            if (InstructionSet::AVX512VPOPCNTDQ())
+                return &(DistanceUtils::ComputeHammingDistance_AVX512VPOPCNTDQ);
+            if (InstructionSet::POPCNT())
+                return &(DistanceUtils::ComputeHammingDistance_POPCNT);
+            return &(DistanceUtils::ComputeHammingDistance_SSE);
+        }
+
+        template<typename T>
+        void (*HammingDistanceBatchCalcSelector()) (const T*, const T* const*, int, DimensionType, float*)
+        {
+            if (InstructionSet::AVX512VPOPCNTDQ())
+                return &(DistanceUtils::ComputeHammingDistanceBatch_AVX512VPOPCNTDQ);
+            if (InstructionSet::POPCNT())
+                return &(DistanceUtils::ComputeHammingDistanceBatch_POPCNT);
+            return &(DistanceUtils::ComputeHammingDistanceBatch_SSE);
+        }
+
         template<typename T>
         float (*DistanceCalcSelector(SPTAG::DistCalcMethod p_method)) (const T*, const T*, DimensionType)
         {
+            bool isSize1 = (sizeof(T) == 1);
+            bool isSize4 = (sizeof(T) == 4);
+            bool useAVX = (InstructionSet::AVX2() && (!std::is_same<T, SPTAG::Float16>::value || InstructionSet::F16C()))
+                || (isSize4 && InstructionSet::AVX());
+            switch (p_method)
+            {
+            // Cosine and InnerProduct share the dot-product kernels (base^2 - x.y); they only differ in
+            // whether the vectors are normalized when they enter the index.
+            case SPTAG::DistCalcMethod::InnerProduct:
+            case SPTAG::DistCalcMethod::Cosine:
+                if (isSize1 && InstructionSet::AVX512VNNI())
+                    return &(DistanceUtils::ComputeCosineDistance_AVX512VNNI);
+                if (InstructionSet::AVX512())
+                    return &(DistanceUtils::ComputeCosineDistance_AVX512);
+                if (useAVX)
+                    return &(DistanceUtils::ComputeCosineDistance_AVX);
+                return &(DistanceUtils::ComputeCosineDistance_SSE);
+
+            case SPTAG::DistCalcMethod::L2:
+                if (isSize1 && InstructionSet::AVX512VNNI())
+                    return &(DistanceUtils::ComputeL2Distance_AVX512VNNI);
+                if (InstructionSet::AVX512())
+                    return &(DistanceUtils::ComputeL2Distance_AVX512);
+                if (useAVX)
+                    return &(DistanceUtils::ComputeL2Distance_AVX);
+                return &(DistanceUtils::ComputeL2Distance_SSE);
+
+            case SPTAG::DistCalcMethod::Hamming:
+                return HammingDistanceCalcSelector<T>();
+
+            default:
+                break;
+            }
+
+            return nullptr;
+        }
+
+        template<typename T>
+        void (*DistanceBatchCalcSelector(SPTAG::DistCalcMethod p_method)) (const T*, const T* const*, int, DimensionType, float*)
+        {
+            bool isSize1 = (sizeof(T) == 1);
+            bool isSize4 = (sizeof(T) == 4);
+            bool useAVX = (InstructionSet::AVX2() && (!std::is_same<T, SPTAG::Float16>::value || InstructionSet::F16C()))
+                || (isSize4 && InstructionSet::AVX());
             switch (p_method)
             {
+            case SPTAG::DistCalcMethod::InnerProduct:
             case SPTAG::DistCalcMethod::Cosine:
-                return &(DistanceUtils::ComputeCosineDistance);
+                if (isSize1 && InstructionSet::AVX512VNNI())
+                    return &(DistanceUtils::ComputeCosineDistanceBatch_AVX512VNNI);
+                if (InstructionSet::AVX512())
+                    return &(DistanceUtils::ComputeCosineDistanceBatch_AVX512);
+                if (useAVX)
+                    return &(DistanceUtils::ComputeCosineDistanceBatch_AVX);
+                return &(DistanceUtils::ComputeCosineDistanceBatch_SSE);
 
             case SPTAG::DistCalcMethod::L2:
-                return &(DistanceUtils::ComputeL2Distance);
+                if (isSize1 && InstructionSet::AVX512VNNI())
+                    return &(DistanceUtils::ComputeL2DistanceBatch_AVX512VNNI);
+                if (InstructionSet::AVX512())
+                    return &(DistanceUtils::ComputeL2DistanceBatch_AVX512);
+                if (useAVX)
+                    return &(DistanceUtils::ComputeL2DistanceBatch_AVX);
+                return &(DistanceUtils::ComputeL2DistanceBatch_SSE);
+
+            case SPTAG::DistCalcMethod::Hamming:
+                return HammingDistanceBatchCalcSelector<T>();
 
             default:
                 break;
@@ -620,6 +417,39 @@ namespace SPTAG
 
             return nullptr;
         }
+
+        // Squared L2 between bit vectors is their Hamming distance, and the byte kernels of the other
+        // methods would treat packed bits as numbers, so Binary vectors use Hamming for every method.
+        template<>
+        inline float (*DistanceCalcSelector<SPTAG::Binary>(SPTAG::DistCalcMethod p_method)) (const SPTAG::Binary*, const SPTAG::Binary*, DimensionType)
+        {
+            return HammingDistanceCalcSelector<SPTAG::Binary>();
+        }
+
+        template<>
+        inline void (*DistanceBatchCalcSelector<SPTAG::Binary>(SPTAG::DistCalcMethod p_method)) (const SPTAG::Binary*, const SPTAG::Binary* const*, int, DimensionType, float*)
+        {
+            return HammingDistanceBatchCalcSelector<SPTAG::Binary>();
+        }
+
+        // Kernels for vectors of p_dimension: the fixed dimension ones when there are any, else the generic ones.
+        template<typename T>
+        float (*DistanceCalcSelector(SPTAG::DistCalcMethod p_method, DimensionType p_dimension)) (const T*, const T*, DimensionType)
+        {
+            float(*pair)(const T*, const T*, DimensionType) = nullptr;
+            void(*batch)(const T*, const T* const*, int, DimensionType, float*) = nullptr;
+            if (DistanceUtils::SelectFixedDimensionKernels<T>(p_method, p_dimension, pair, batch)) return pair;
+            return DistanceCalcSelector<T>(p_method);
+        }
+
+        template<typename T>
+        void (*DistanceBatchCalcSelector(SPTAG::DistCalcMethod p_method, DimensionType p_dimension)) (const T*, const T* const*, int, DimensionType, float*)
+        {
+            float(*pair)(const T*, const T*, DimensionType) = nullptr;
+            void(*batch)(const T*, const T* const*, int, DimensionType, float*) = nullptr;
+            if (DistanceUtils::SelectFixedDimensionKernels<T>(p_method, p_dimension, pair, batch)) return batch;
+            return DistanceBatchCalcSelector<T>(p_method);
+        }
     }
 }
 
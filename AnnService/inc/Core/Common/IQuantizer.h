@@ -0,0 +1,57 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _SPTAG_COMMON_IQUANTIZER_H_
+#define _SPTAG_COMMON_IQUANTIZER_H_
+
+#include <fstream>
+#include <iostream>
+
+#include "../Common.h"
+#include "Dataset.h"
+
+namespace SPTAG
+{
+    namespace COMMON
+    {
+        // Lossy compression of the index vectors used to score candidates during graph traversal.
+        // Every vector is encoded into GetCodeSize() bytes. A query is turned into a table once per
+        // search and codes are scored against that table; the index re-ranks the final candidates
+        // with full precision distances, so quantized distances only need to preserve the ordering.
+        template <typename T>
+        class IQuantizer
+        {
+        public:
+            virtual ~IQuantizer() {}
+
+            virtual QuantizerType GetQuantizerType() const = 0;
+
+            // Bytes per encoded vector.
+            virtual DimensionType GetCodeSize() const = 0;
+
+            // Bytes of the per-query table filled by BuildQueryTable.
+            virtual std::size_t GetQueryTableSize() const = 0;
+
+            // Learns the quantizer parameters from at most p_sampleNum vectors of p_data.
+            virtual ErrorCode Train(const Dataset<T>& p_data, SizeType p_sampleNum, int p_threadNum) = 0;
+
+            virtual void Encode(const T* p_vector, std::uint8_t* p_code) const = 0;
+
+            virtual void BuildQueryTable(const T* p_query, std::uint8_t* p_table) const = 0;
+
+            // Approximates the index distance between the query behind p_table and each of p_count codes.
+            virtual void ComputeDistanceBatch(const std::uint8_t* p_table, const std::uint8_t* const* p_codes, int p_count, float* p_results) const = 0;
+
+            virtual std::uint64_t BufferSize() const = 0;
+
+            virtual bool Save(std::ostream& p_outstream) const = 0;
+
+            virtual bool Load(std::ifstream& p_instream) = 0;
+
+            // Reads BufferSize() bytes from a memory blob; the blob must outlive the quantizer.
+            virtual bool Load(char* p_mem) = 0;
+        };
+    }
+}
+
+#endif // _SPTAG_COMMON_IQUANTIZER_H_
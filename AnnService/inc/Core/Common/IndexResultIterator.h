@@ -0,0 +1,88 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _SPTAG_COMMON_INDEXRESULTITERATOR_H_
+#define _SPTAG_COMMON_INDEXRESULTITERATOR_H_
+
+#include "../ResultIterator.h"
+#include "QueryResultSet.h"
+#include "WorkSpacePool.h"
+
+#include <vector>
+
+namespace SPTAG
+{
+namespace COMMON
+{
+
+// The ResultIterator of BKT and KDT. It keeps the work space of the query rented between calls, with the
+// queues and visited nodes of the walk, and lets Index::SearchIndexIterative continue the walk for each page.
+template <typename T, typename Index>
+class IndexResultIterator : public ResultIterator
+{
+public:
+    IndexResultIterator(const Index* p_index, COMMON::WorkSpacePool* p_workSpacePool, std::shared_ptr<WorkSpace> p_space,
+        const T* p_target, bool p_searchDeleted)
+        : m_index(p_index),
+          m_workSpacePool(p_workSpacePool),
+          m_space(std::move(p_space)),
+          m_target(p_target, p_target + p_index->GetFeatureDim()),
+          m_results(m_target.data()),
+          m_searchDeleted(p_searchDeleted),
+          m_first(true)
+    {
+    }
+
+    ~IndexResultIterator()
+    {
+        Close();
+    }
+
+    ErrorCode Next(QueryResult& p_results)
+    {
+        if (m_space == nullptr) return ErrorCode::Fail;
+
+        std::vector<BasicResult> page;
+        page.reserve(p_results.GetResultNum());
+        m_index->SearchIndexIterative(m_results, *m_space, m_first, p_results.GetResultNum(), m_searchDeleted, page);
+        m_first = false;
+
+        for (int i = 0; i < p_results.GetResultNum(); i++)
+        {
+            SizeType vid = (i < static_cast<int>(page.size())) ? page[i].VID : -1;
+            p_results.SetResult(i, vid, (vid < 0) ? MaxDist : page[i].Dist);
+            if (p_results.WithMeta()) p_results.SetMetadata(i, (vid < 0) ? ByteArray::c_empty : m_index->GetMetadata(vid));
+        }
+        p_results.SetCutShort(m_space->m_bCutShort);
+        return ErrorCode::Success;
+    }
+
+    void Close()
+    {
+        if (m_space == nullptr) return;
+
+        m_workSpacePool->Return(m_space);
+        m_space.reset();
+    }
+
+private:
+    const Index* m_index;
+
+    COMMON::WorkSpacePool* m_workSpacePool;
+
+    std::shared_ptr<WorkSpace> m_space;
+
+    // The caller's query may be gone by the time the next page is asked for.
+    std::vector<T> m_target;
+
+    IterativeResultSet<T> m_results;
+
+    bool m_searchDeleted;
+
+    bool m_first;
+};
+
+}
+}
+
+#endif // _SPTAG_COMMON_INDEXRESULTITERATOR_H_
@@ -0,0 +1,74 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _SPTAG_COMMON_INSTRUCTIONUTILS_H_
+#define _SPTAG_COMMON_INSTRUCTIONUTILS_H_
+
+// Kernels for instruction sets above the build baseline are compiled with per-function
+// target attributes so that a single binary can carry all of them. MSVC allows any
+// intrinsic without a target flag, so the attributes expand to nothing there.
+#ifndef _MSC_VER
+#define SPTAG_TARGET_POPCNT __attribute__((target("popcnt")))
+#define SPTAG_TARGET_AVX __attribute__((target("avx")))
+#define SPTAG_TARGET_AVX2 __attribute__((target("avx2")))
+#define SPTAG_TARGET_F16C __attribute__((target("avx2,f16c")))
+#define SPTAG_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx512vl,avx512dq")))
+#define SPTAG_TARGET_AVX512VNNI __attribute__((target("avx512f,avx512bw,avx512vl,avx512dq,avx512vnni")))
+#define SPTAG_TARGET_AVX512VPOPCNTDQ __attribute__((target("avx512f,avx512bw,avx512vl,avx512dq,avx512vpopcntdq")))
+#else
+#define SPTAG_TARGET_POPCNT
+#define SPTAG_TARGET_AVX
+#define SPTAG_TARGET_AVX2
+#define SPTAG_TARGET_F16C
+#define SPTAG_TARGET_AVX512
+#define SPTAG_TARGET_AVX512VNNI
+#define SPTAG_TARGET_AVX512VPOPCNTDQ
+#endif
+
+namespace SPTAG
+{
+    namespace COMMON
+    {
+        class InstructionSet
+        {
+        public:
+            static bool SSE();
+            static bool SSE2();
+            // Scalar population count, used by the Hamming kernels below AVX-512.
+            static bool POPCNT();
+            static bool AVX();
+            static bool AVX2();
+            // Half precision conversions, needed by the Float16 kernels below AVX-512.
+            static bool F16C();
+            // AVX512F + BW + VL + DQ, the subset the distance kernels are written against.
+            static bool AVX512();
+            static bool AVX512VNNI();
+            static bool AVX512VPOPCNTDQ();
+
+            // Name of the widest instruction set the distance kernels will use on this machine.
+            static const char* Best();
+
+        private:
+            class InstructionSet_Internal
+            {
+            public:
+                InstructionSet_Internal();
+
+                bool HW_SSE;
+                bool HW_SSE2;
+                bool HW_POPCNT;
+                bool HW_AVX;
+                bool HW_AVX2;
+                bool HW_F16C;
+                bool HW_AVX512;
+                bool HW_AVX512VNNI;
+                bool HW_AVX512VPOPCNTDQ;
+            };
+
+            // Probed once on first use so that callers running during static initialization are safe.
+            static const InstructionSet_Internal& CPU_Rep();
+        };
+    }
+}
+
+#endif // _SPTAG_COMMON_INSTRUCTIONUTILS_H_
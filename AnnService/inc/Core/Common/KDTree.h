@@ -154,16 +154,16 @@ namespace SPTAG
                 return true;
             }
 
-            template <typename T>
-            void InitSearchTrees(const VectorIndex* p_index, const COMMON::QueryResultSet<T> &p_query, COMMON::WorkSpace &p_space) const
+            template <typename Q>
+            void InitSearchTrees(const VectorIndex* p_index, const Q &p_query, COMMON::WorkSpace &p_space) const
             {
                 for (int i = 0; i < m_iTreeNumber; i++) {
                     KDTSearch(p_index, p_query, p_space, m_pTreeStart[i], 0);
                 }
             }
 
-            template <typename T>
-            void SearchTrees(const VectorIndex* p_index, const COMMON::QueryResultSet<T> &p_query, COMMON::WorkSpace &p_space, const int p_limits) const
+            template <typename Q>
+            void SearchTrees(const VectorIndex* p_index, const Q &p_query, COMMON::WorkSpace &p_space, const int p_limits) const
             {
                 while (!p_space.m_SPTQueue.empty() && p_space.m_iNumberOfCheckedLeaves < p_limits)
                 {
@@ -174,8 +174,8 @@ namespace SPTAG
 
         private:
 
-            template <typename T>
-            void KDTSearch(const VectorIndex* p_index, const COMMON::QueryResultSet<T> &p_query,
+            template <typename Q>
+            void KDTSearch(const VectorIndex* p_index, const Q &p_query,
                            COMMON::WorkSpace& p_space, const SizeType node, const float distBound) const {
                 if (node < 0)
                 {
@@ -183,6 +183,24 @@ namespace SPTAG
             }
 
 
+            // Renumbers the nodes: the neighbors of node indices[i] become those of node i, and every neighbor
+            // id j becomes reverseIndices[j]. indices is a permutation of all the nodes.
+            bool Permute(const std::vector<SizeType>& indices, const std::vector<SizeType>& reverseIndices)
+            {
+                if (!m_pNeighborhoodGraph.Permute(indices)) return false;
+
+#pragma omp parallel for
+                for (SizeType i = 0; i < m_iGraphSize; i++)
+                {
+                    SizeType *nodes = m_pNeighborhoodGraph[i];
+                    for (DimensionType j = 0; j < m_iNeighborhoodSize; j++)
+                    {
+                        if (nodes[j] >= 0) nodes[j] = reverseIndices[nodes[j]];
+                    }
+                }
+                return true;
+            }
+
             template <typename T>
             void RefineNode(VectorIndex* index, const SizeType node, bool updateNeighbors, bool searchDeleted, int CEF)
             {
@@ -0,0 +1,153 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _SPTAG_COMMON_NODERECORDS_H_
+#define _SPTAG_COMMON_NODERECORDS_H_
+
+#include "Dataset.h"
+#include "NeighborhoodGraph.h"
+
+namespace SPTAG
+{
+    namespace COMMON
+    {
+        // Keeps the vector and the neighbor list of every node in one record, so that expanding a node in the
+        // graph search reads one stretch of memory rather than a graph row and a vector row far apart.
+        // A record holds the vector, then the neighbor list, padded with zeros to whole cache lines, and every
+        // record starts on a cache line. The samples and the graph of the index are views of the records;
+        // nodes added later live apart, in the blocks of those datasets, until the next build or refine.
+        // Saved in place of the samples: rows, dimension and neighborhood size, then the records.
+        template <typename T>
+        class NodeRecords
+        {
+        private:
+            static const std::uint64_t RecordAlign = 64;
+
+            std::uint8_t* m_data;
+            SizeType m_rows;
+            DimensionType m_dimension;
+            DimensionType m_neighborhoodSize;
+
+            bool Allocate(SizeType p_rows, DimensionType p_dimension, DimensionType p_neighborhoodSize)
+            {
+                if (m_data != nullptr) aligned_free(m_data);
+
+                m_rows = p_rows;
+                m_dimension = p_dimension;
+                m_neighborhoodSize = p_neighborhoodSize;
+                std::uint64_t size = RecordSize(p_dimension, p_neighborhoodSize) * p_rows;
+                m_data = (std::uint8_t*)aligned_malloc(max(size, RecordAlign), RecordAlign);
+                if (m_data == nullptr) return false;
+
+                std::memset(m_data, 0, size);
+                return true;
+            }
+
+        public:
+            NodeRecords() : m_data(nullptr), m_rows(0), m_dimension(0), m_neighborhoodSize(0) {}
+
+            ~NodeRecords()
+            {
+                if (m_data != nullptr) aligned_free(m_data);
+            }
+
+            // Byte offset of the neighbor list in a record.
+            static std::uint64_t GraphOffset(DimensionType p_dimension)
+            {
+                return (sizeof(T) * p_dimension + sizeof(SizeType) - 1) / sizeof(SizeType) * sizeof(SizeType);
+            }
+
+            static std::uint64_t RecordSize(DimensionType p_dimension, DimensionType p_neighborhoodSize)
+            {
+                return (GraphOffset(p_dimension) + sizeof(SizeType) * p_neighborhoodSize + RecordAlign - 1) / RecordAlign * RecordAlign;
+            }
+
+            static std::uint64_t BufferSize(SizeType p_rows, DimensionType p_dimension, DimensionType p_neighborhoodSize)
+            {
+                return sizeof(SizeType) + sizeof(DimensionType) * 2 + RecordSize(p_dimension, p_neighborhoodSize) * p_rows;
+            }
+
+            // Copies the vectors and neighbor lists into records and makes p_samples and p_graph views of them.
+            bool Colocate(Dataset<T>& p_samples, NeighborhoodGraph& p_graph)
+            {
+                if (!Allocate(p_samples.R(), p_samples.C(), p_graph.m_iNeighborhoodSize)) return false;
+
+                std::uint64_t recordSize = RecordSize(m_dimension, m_neighborhoodSize);
+                std::uint64_t graphOffset = GraphOffset(m_dimension);
+#pragma omp parallel for
+                for (SizeType i = 0; i < m_rows; i++) {
+                    std::uint8_t* record = m_data + recordSize * i;
+                    std::memcpy(record, p_samples[i], sizeof(T) * m_dimension);
+                    std::memcpy(record + graphOffset, p_graph[i], sizeof(SizeType) * m_neighborhoodSize);
+                }
+                AttachSamples(p_samples);
+                AttachGraph(p_graph);
+                return true;
+            }
+
+            void AttachSamples(Dataset<T>& p_samples) const
+            {
+                p_samples.InitializeView(m_rows, m_dimension, (T*)m_data, RecordSize(m_dimension, m_neighborhoodSize) / sizeof(T));
+            }
+
+            void AttachGraph(NeighborhoodGraph& p_graph) const
+            {
+                p_graph.Attach((SizeType*)(m_data + GraphOffset(m_dimension)), m_rows, m_neighborhoodSize, RecordSize(m_dimension, m_neighborhoodSize) / sizeof(SizeType));
+            }
+
+            // Writes the records of p_samples and p_graph, whatever their layout in memory. As with
+            // Dataset::Refine, record i takes the vector of sample p_indices[i] when p_indices is given.
+            static bool Save(std::ostream& p_output, const Dataset<T>& p_samples, const NeighborhoodGraph& p_graph, const std::vector<SizeType>* p_indices = nullptr)
+            {
+                SizeType rows = (p_indices == nullptr) ? p_samples.R() : (SizeType)p_indices->size();
+                DimensionType dimension = p_samples.C();
+                DimensionType neighborhoodSize = p_graph.m_iNeighborhoodSize;
+                p_output.write((char*)&rows, sizeof(SizeType));
+                p_output.write((char*)&dimension, sizeof(DimensionType));
+                p_output.write((char*)&neighborhoodSize, sizeof(DimensionType));
+
+                std::uint64_t graphOffset = GraphOffset(dimension);
+                std::vector<std::uint8_t> record(RecordSize(dimension, neighborhoodSize), 0);
+                for (SizeType i = 0; i < rows; i++) {
+                    std::memcpy(record.data(), p_samples[(p_indices == nullptr) ? i : p_indices->at(i)], sizeof(T) * dimension);
+                    std::memcpy(record.data() + graphOffset, p_graph[i], sizeof(SizeType) * neighborhoodSize);
+                    p_output.write((char*)record.data(), record.size());
+                }
+                std::cout << "Save NodeRecords (" << rows << ", " << dimension << ", " << neighborhoodSize << ") Finish!" << std::endl;
+                return true;
+            }
+
+            bool Load(std::ifstream& p_input)
+            {
+                SizeType rows;
+                DimensionType dimension, neighborhoodSize;
+                p_input.read((char*)&rows, sizeof(SizeType));
+                p_input.read((char*)&dimension, sizeof(DimensionType));
+                p_input.read((char*)&neighborhoodSize, sizeof(DimensionType));
+                if (p_input.fail() || !Allocate(rows, dimension, neighborhoodSize)) return false;
+
+                p_input.read((char*)m_data, RecordSize(dimension, neighborhoodSize) * rows);
+                std::cout << "Load NodeRecords (" << rows << ", " << dimension << ", " << neighborhoodSize << ") Finish!" << std::endl;
+                return !p_input.fail();
+            }
+
+            // The records are copied out of the blob, which gives no alignment guarantee.
+            bool Load(char* p_memFile)
+            {
+                SizeType rows = *((SizeType*)p_memFile);
+                p_memFile += sizeof(SizeType);
+                DimensionType dimension = *((DimensionType*)p_memFile);
+                p_memFile += sizeof(DimensionType);
+                DimensionType neighborhoodSize = *((DimensionType*)p_memFile);
+                p_memFile += sizeof(DimensionType);
+                if (!Allocate(rows, dimension, neighborhoodSize)) return false;
+
+                std::memcpy(m_data, p_memFile, RecordSize(dimension, neighborhoodSize) * rows);
+                std::cout << "Load NodeRecords (" << rows << ", " << dimension << ", " << neighborhoodSize << ") Finish!" << std::endl;
+                return true;
+            }
+        };
+    }
+}
+
+#endif // _SPTAG_COMMON_NODERECORDS_H_
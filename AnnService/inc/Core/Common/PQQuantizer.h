@@ -0,0 +1,227 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _SPTAG_COMMON_PQQUANTIZER_H_
+#define _SPTAG_COMMON_PQQUANTIZER_H_
+
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+#include "IQuantizer.h"
+#include "BKTree.h"
+#include "CommonUtils.h"
+#include "DistanceUtils.h"
+#include "InstructionUtils.h"
+
+namespace SPTAG
+{
+    namespace COMMON
+    {
+        class PQUtils
+        {
+        public:
+            // Centroids per subspace, so that every subvector is coded in one byte.
+            static const int CentroidNum = 256;
+
+            // Asymmetric distance of each code: the sum over subvectors m of pTable[m * CentroidNum + code[m]].
+            // Eight bit codes make the per-subspace tables 256 floats wide, too large to keep in registers
+            // for byte shuffles, so the SIMD kernels fetch table entries with gathers instead.
+            static void ComputeADCDistanceBatch_SSE(const float* pTable, const std::uint8_t* const* pCodes, int count, DimensionType subvectors, float* pResults);
+            static void ComputeADCDistanceBatch_AVX2(const float* pTable, const std::uint8_t* const* pCodes, int count, DimensionType subvectors, float* pResults);
+            static void ComputeADCDistanceBatch_AVX512(const float* pTable, const std::uint8_t* const* pCodes, int count, DimensionType subvectors, float* pResults);
+        };
+
+        inline void (*ADCDistanceBatchSelector()) (const float*, const std::uint8_t* const*, int, DimensionType, float*)
+        {
+            if (InstructionSet::AVX512()) return &(PQUtils::ComputeADCDistanceBatch_AVX512);
+            if (InstructionSet::AVX2()) return &(PQUtils::ComputeADCDistanceBatch_AVX2);
+            return &(PQUtils::ComputeADCDistanceBatch_SSE);
+        }
+
+        // Product quantizer: the dimensions are split into M contiguous subvectors and every subvector
+        // is replaced by the id of its nearest centroid among the 256 that k-means learnt on that subspace.
+        // A query table holds the partial distance from each query subvector to each centroid, so
+        // scoring a code takes M table lookups.
+        template <typename T>
+        class PQQuantizer : public IQuantizer<T>
+        {
+        private:
+            // Presents one subspace of the training vectors to the BKTree k-means.
+            struct SubspaceSamples
+            {
+                Dataset<float> m_data;
+
+                inline const void* GetSample(const SizeType idx) const { return m_data[idx]; }
+                inline DimensionType GetFeatureDim() const { return m_data.C(); }
+                inline SizeType GetNumSamples() const { return m_data.R(); }
+                inline DistCalcMethod GetDistCalcMethod() const { return DistCalcMethod::L2; }
+            };
+
+        public:
+            // p_subvectors <= 0 picks one subvector per four dimensions. The count is lowered to the
+            // nearest divisor of the dimension so that all subvectors have the same length.
+            PQQuantizer(DistCalcMethod p_distMethod, DimensionType p_dimension, DimensionType p_subvectors) : m_iDimension(p_dimension)
+            {
+                if (p_subvectors <= 0) p_subvectors = max(p_dimension / 4, 1);
+                m_iSubvectors = min(p_subvectors, p_dimension);
+                while (p_dimension % m_iSubvectors != 0) m_iSubvectors--;
+                m_iSubDim = p_dimension / m_iSubvectors;
+
+                m_bDotProduct = (p_distMethod == DistCalcMethod::Cosine || p_distMethod == DistCalcMethod::InnerProduct);
+                m_fBaseSquare = m_bDotProduct ? (float)Utils::GetBase<T>() * Utils::GetBase<T>() : 0.0f;
+
+                m_codebooks.SetName("PQCodebook");
+                m_fComputeL2 = DistanceCalcSelector<float>(DistCalcMethod::L2);
+                m_fComputeCosine = DistanceCalcSelector<float>(DistCalcMethod::Cosine);
+                m_fComputeADCBatch = ADCDistanceBatchSelector();
+            }
+
+            ~PQQuantizer() {}
+
+            inline QuantizerType GetQuantizerType() const { return QuantizerType::PQ; }
+            inline DimensionType GetCodeSize() const { return m_iSubvectors; }
+            inline std::size_t GetQueryTableSize() const { return sizeof(float) * m_iSubvectors * PQUtils::CentroidNum; }
+
+            ErrorCode Train(const Dataset<T>& p_data, SizeType p_sampleNum, int p_threadNum)
+            {
+                if (p_data.C() != m_iDimension) return ErrorCode::DimensionSizeMismatch;
+                if (p_data.R() == 0) return ErrorCode::EmptyData;
+
+                std::vector<SizeType> samples(p_data.R());
+                for (SizeType i = 0; i < p_data.R(); i++) samples[i] = i;
+                if (p_sampleNum > 0 && p_sampleNum < p_data.R())
+                {
+                    std::random_shuffle(samples.begin(), samples.end());
+                    samples.resize(p_sampleNum);
+                }
+                SizeType sampleNum = (SizeType)samples.size();
+                std::cout << "Train PQ (" << m_iSubvectors << " subvectors of " << m_iSubDim << " dims) with " << sampleNum << " samples" << std::endl;
+
+                BKTree trainer;
+                trainer.m_iBKTKmeansK = PQUtils::CentroidNum;
+                trainer.m_iSamples = sampleNum;
+                KmeansArgs<float> args(PQUtils::CentroidNum, m_iSubDim, sampleNum, p_threadNum, DistCalcMethod::L2);
+
+                SubspaceSamples subspace;
+                subspace.m_data.Initialize(sampleNum, m_iSubDim);
+                std::vector<SizeType> indices(sampleNum);
+                m_codebooks.Initialize(m_iSubvectors * PQUtils::CentroidNum, m_iSubDim);
+                for (DimensionType m = 0; m < m_iSubvectors; m++)
+                {
+                    for (SizeType i = 0; i < sampleNum; i++)
+                    {
+                        const T* v = p_data[samples[i]] + m * m_iSubDim;
+                        float* s = subspace.m_data[i];
+                        for (DimensionType j = 0; j < m_iSubDim; j++) s[j] = (float)v[j];
+                        indices[i] = i;
+                    }
+                    trainer.KmeansClustering(&subspace, indices, 0, sampleNum, args);
+                    std::memcpy(m_codebooks[m * PQUtils::CentroidNum], args.centers, sizeof(float) * PQUtils::CentroidNum * m_iSubDim);
+                }
+                return ErrorCode::Success;
+            }
+
+            void Encode(const T* p_vector, std::uint8_t* p_code) const
+            {
+                std::vector<float> sub(m_iSubDim);
+                for (DimensionType m = 0; m < m_iSubvectors; m++)
+                {
+                    const T* v = p_vector + m * m_iSubDim;
+                    for (DimensionType j = 0; j < m_iSubDim; j++) sub[j] = (float)v[j];
+
+                    int best = 0;
+                    float bestDist = MaxDist;
+                    for (int k = 0; k < PQUtils::CentroidNum; k++)
+                    {
+                        float dist = m_fComputeL2(sub.data(), m_codebooks[m * PQUtils::CentroidNum + k], m_iSubDim);
+                        if (dist < bestDist)
+                        {
+                            best = k;
+                            bestDist = dist;
+                        }
+                    }
+                    p_code[m] = (std::uint8_t)best;
+                }
+            }
+
+            // L2 tables hold squared partial distances. Cosine and InnerProduct tables hold negated
+            // partial dot products, with the base square folded into the first subspace, which keeps
+            // the sum on the same scale as the index distance (base^2 - x.y).
+            void BuildQueryTable(const T* p_query, std::uint8_t* p_table) const
+            {
+                float* table = (float*)p_table;
+                std::vector<float> sub(m_iSubDim);
+                for (DimensionType m = 0; m < m_iSubvectors; m++)
+                {
+                    const T* q = p_query + m * m_iSubDim;
+                    for (DimensionType j = 0; j < m_iSubDim; j++) sub[j] = (float)q[j];
+
+                    float* subTable = table + m * PQUtils::CentroidNum;
+                    for (int k = 0; k < PQUtils::CentroidNum; k++)
+                    {
+                        const float* center = m_codebooks[m * PQUtils::CentroidNum + k];
+                        // The float cosine kernel returns 1 - x.y.
+                        subTable[k] = m_bDotProduct ? m_fComputeCosine(sub.data(), center, m_iSubDim) - 1.0f : m_fComputeL2(sub.data(), center, m_iSubDim);
+                    }
+                }
+                if (m_bDotProduct)
+                {
+                    for (int k = 0; k < PQUtils::CentroidNum; k++) table[k] += m_fBaseSquare;
+                }
+            }
+
+            inline void ComputeDistanceBatch(const std::uint8_t* p_table, const std::uint8_t* const* p_codes, int p_count, float* p_results) const
+            {
+                m_fComputeADCBatch((const float*)p_table, p_codes, p_count, m_iSubvectors, p_results);
+            }
+
+            inline std::uint64_t BufferSize() const { return m_codebooks.BufferSize(); }
+
+            bool Save(std::ostream& p_outstream) const
+            {
+                return m_codebooks.Save(p_outstream);
+            }
+
+            bool Load(std::ifstream& p_instream)
+            {
+                if (!m_codebooks.Load(p_instream)) return false;
+                return CheckCodebooks();
+            }
+
+            bool Load(char* p_mem)
+            {
+                if (!m_codebooks.Load(p_mem)) return false;
+                return CheckCodebooks();
+            }
+
+        private:
+            bool CheckCodebooks() const
+            {
+                if (m_codebooks.R() != m_iSubvectors * PQUtils::CentroidNum || m_codebooks.C() != m_iSubDim)
+                {
+                    std::cerr << "Error: PQ codebook (" << m_codebooks.R() << ", " << m_codebooks.C() << ") does not match "
+                        << m_iSubvectors << " subvectors of " << m_iSubDim << " dims." << std::endl;
+                    return false;
+                }
+                return true;
+            }
+
+            DimensionType m_iDimension;
+            DimensionType m_iSubvectors;
+            DimensionType m_iSubDim;
+            bool m_bDotProduct;
+            float m_fBaseSquare;
+
+            // Row m * CentroidNum + k is centroid k of subspace m.
+            Dataset<float> m_codebooks;
+
+            float(*m_fComputeL2)(const float* pX, const float* pY, DimensionType length);
+            float(*m_fComputeCosine)(const float* pX, const float* pY, DimensionType length);
+            void(*m_fComputeADCBatch)(const float* pTable, const std::uint8_t* const* pCodes, int count, DimensionType subvectors, float* pResults);
+        };
+    }
+}
+
+#endif // _SPTAG_COMMON_PQQUANTIZER_H_
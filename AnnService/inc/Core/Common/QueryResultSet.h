@@ -5,6 +5,11 @@
 #define _SPTAG_COMMON_QUERYRESULTSET_H_
 
 #include "../SearchQuery.h"
+#include "../MetadataSet.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
 
 namespace SPTAG
 {
@@ -90,6 +95,256 @@ private:
         if (next == maxidx && m_results[parent] < m_results[next]) std::swap(m_results[parent], m_results[next]);
     }
 };
+
+
+// Collects every vector within a radius of the target, for range search. It offers the part of the
+// QueryResultSet interface that the graph search uses, with the radius in the place of the worst result,
+// so a node counts as an improvement exactly when it lies inside the radius.
+template<typename T>
+class RadiusResultSet
+{
+public:
+    RadiusResultSet(const T* p_target, float p_radius) : m_target(p_target), m_radius(p_radius)
+    {
+    }
+
+    inline const T* GetTarget() const
+    {
+        return m_target;
+    }
+
+    inline float worstDist() const
+    {
+        return m_radius;
+    }
+
+    inline bool AddPoint(const SizeType index, float dist)
+    {
+        if (dist > m_radius) return false;
+
+        m_results.emplace_back(index, dist);
+        return true;
+    }
+
+    inline void SortResult()
+    {
+        std::sort(m_results.begin(), m_results.end(), Compare);
+    }
+
+    inline const std::vector<BasicResult>& GetResults() const
+    {
+        return m_results;
+    }
+
+private:
+    const T* m_target;
+
+    float m_radius;
+
+    std::vector<BasicResult> m_results;
+};
+
+// Keeps the nearest vector of each metadata value, for queries that must not return several vectors with
+// the same metadata. It offers the part of the QueryResultSet interface that the graph search uses; the
+// results stay sorted, and a vector replaces the result with the same metadata when it is nearer.
+template<typename T>
+class DistinctResultSet
+{
+public:
+    DistinctResultSet(const T* p_target, int p_K, const MetadataSet* p_metadata)
+        : m_target(p_target), m_K(p_K), m_metadata(p_metadata)
+    {
+        m_results.reserve(p_K + 1);
+    }
+
+    inline const T* GetTarget() const
+    {
+        return m_target;
+    }
+
+    inline float worstDist() const
+    {
+        return (static_cast<int>(m_results.size()) < m_K) ? MaxDist : m_results.back().m_result.Dist;
+    }
+
+    bool AddPoint(const SizeType index, float dist)
+    {
+        BasicResult candidate(index, dist);
+        if (m_K <= 0 || (static_cast<int>(m_results.size()) == m_K && !Compare(candidate, m_results.back().m_result))) return false;
+
+        Entry entry;
+        entry.m_result = candidate;
+        entry.m_key = m_metadata->GetMetadata(index);
+        entry.m_hash = Hash(entry.m_key);
+
+        auto same = std::find_if(m_results.begin(), m_results.end(), [&entry](const Entry& e) { return e.m_hash == entry.m_hash && SameKey(e.m_key, entry.m_key); });
+        if (same != m_results.end())
+        {
+            if (!Compare(candidate, same->m_result)) return false;
+            m_results.erase(same);
+        }
+        else if (static_cast<int>(m_results.size()) == m_K)
+        {
+            m_results.pop_back();
+        }
+
+        auto pos = std::upper_bound(m_results.begin(), m_results.end(), entry, [](const Entry& lhs, const Entry& rhs) { return Compare(lhs.m_result, rhs.m_result); });
+        m_results.insert(pos, std::move(entry));
+        return true;
+    }
+
+    inline void SortResult()
+    {
+    }
+
+    inline int GetResultNum() const
+    {
+        return static_cast<int>(m_results.size());
+    }
+
+    inline const BasicResult& GetResult(int i) const
+    {
+        return m_results[i].m_result;
+    }
+
+    // Fills the K results of p_query; slots left over when fewer values were found get VID -1.
+    void CopyTo(QueryResult& p_query) const
+    {
+        for (int i = 0; i < p_query.GetResultNum(); i++)
+        {
+            if (i < GetResultNum()) p_query.SetResult(i, m_results[i].m_result.VID, m_results[i].m_result.Dist);
+            else p_query.SetResult(i, -1, MaxDist);
+        }
+    }
+
+private:
+    struct Entry
+    {
+        BasicResult m_result;
+        std::uint64_t m_hash;
+        ByteArray m_key;
+    };
+
+    static inline std::uint64_t Hash(const ByteArray& p_key)
+    {
+        std::uint64_t hash = 14695981039346656037ULL;
+        for (std::size_t i = 0; i < p_key.Length(); i++)
+        {
+            hash = (hash ^ p_key.Data()[i]) * 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    static inline bool SameKey(const ByteArray& lhs, const ByteArray& rhs)
+    {
+        return lhs.Length() == rhs.Length() && (lhs.Length() == 0 || std::memcmp(lhs.Data(), rhs.Data(), lhs.Length()) == 0);
+    }
+
+    const T* m_target;
+
+    int m_K;
+
+    const MetadataSet* m_metadata;
+
+    std::vector<Entry> m_results;
+};
+
+// Collects the vectors an iterative search reaches, for a ResultIterator. It offers the part of the
+// QueryResultSet interface that the graph search uses, without a worst result, so every node the walk takes
+// joins it and the trees never bound a distance. The nearest p_count vectors not returned yet make up the
+// current page (StartPage, EndPage); PageWorstDist is the farthest of them, which the walk of the page uses
+// the way a K-NN search uses its worst result.
+template<typename T>
+class IterativeResultSet
+{
+public:
+    IterativeResultSet(const T* p_target) : m_target(p_target), m_pageSize(0)
+    {
+    }
+
+    inline const T* GetTarget() const
+    {
+        return m_target;
+    }
+
+    inline float worstDist() const
+    {
+        return MaxDist;
+    }
+
+    inline float PageWorstDist() const
+    {
+        return (static_cast<int>(m_page.size()) < m_pageSize) ? MaxDist : m_page.front().Dist;
+    }
+
+    inline bool AddPoint(const SizeType index, float dist)
+    {
+        BasicResult result(index, dist);
+        if (static_cast<int>(m_page.size()) < m_pageSize)
+        {
+            m_page.push_back(result);
+            std::push_heap(m_page.begin(), m_page.end(), Compare);
+            return true;
+        }
+        if (m_pageSize > 0 && Compare(result, m_page.front()))
+        {
+            // The farthest vector of the page is left for a later one.
+            std::pop_heap(m_page.begin(), m_page.end(), Compare);
+            PushRest(m_page.back());
+            m_page.back() = result;
+            std::push_heap(m_page.begin(), m_page.end(), Compare);
+            return true;
+        }
+        PushRest(result);
+        return true;
+    }
+
+    inline void SortResult()
+    {
+    }
+
+    // Starts a page of p_count vectors with the nearest ones that earlier pages left over.
+    void StartPage(int p_count)
+    {
+        m_pageSize = p_count;
+        while (static_cast<int>(m_page.size()) < m_pageSize && !m_rest.empty())
+        {
+            std::pop_heap(m_rest.begin(), m_rest.end(), Farther);
+            m_page.push_back(m_rest.back());
+            std::push_heap(m_page.begin(), m_page.end(), Compare);
+            m_rest.pop_back();
+        }
+    }
+
+    // Appends the vectors of the page to p_results, nearest first.
+    void EndPage(std::vector<BasicResult>& p_results)
+    {
+        std::sort_heap(m_page.begin(), m_page.end(), Compare);
+        p_results.insert(p_results.end(), m_page.begin(), m_page.end());
+        m_page.clear();
+    }
+
+private:
+    static inline bool Farther(const BasicResult& lhs, const BasicResult& rhs)
+    {
+        return Compare(rhs, lhs);
+    }
+
+    inline void PushRest(const BasicResult& p_result)
+    {
+        m_rest.push_back(p_result);
+        std::push_heap(m_rest.begin(), m_rest.end(), Farther);
+    }
+
+    const T* m_target;
+
+    int m_pageSize;
+
+    // A max-heap of the current page and a min-heap of the vectors found beyond it.
+    std::vector<BasicResult> m_page;
+
+    std::vector<BasicResult> m_rest;
+};
 }
 }
 
@@ -0,0 +1,173 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _SPTAG_COMMON_SQ8QUANTIZER_H_
+#define _SPTAG_COMMON_SQ8QUANTIZER_H_
+
+#include <cmath>
+#include <iostream>
+
+#include "IQuantizer.h"
+#include "CommonUtils.h"
+#include "DistanceUtils.h"
+
+namespace SPTAG
+{
+    namespace COMMON
+    {
+        // Scalar quantizer: one byte per dimension, scored with the 8-bit distance kernels. The per-dimension
+        // min/max learnt from the data set the code range. All dimensions share one step size so that
+        // distances between codes stay proportional to distances between the vectors:
+        // L2 codes are unsigned offsets from the dimension minimum, and Cosine/InnerProduct codes are
+        // signed multiples of the step (an offset would not cancel out of a dot product).
+        template <typename T>
+        class SQ8Quantizer : public IQuantizer<T>
+        {
+        public:
+            SQ8Quantizer(DistCalcMethod p_distMethod, DimensionType p_dimension) : m_iDimension(p_dimension), m_fStep(1.0f)
+            {
+                m_bDotProduct = (p_distMethod == DistCalcMethod::Cosine || p_distMethod == DistCalcMethod::InnerProduct);
+                m_fBaseSquare = m_bDotProduct ? (float)Utils::GetBase<T>() * Utils::GetBase<T>() : 0.0f;
+
+                m_range.SetName("SQ8Range");
+                m_fComputeL2Batch = DistanceBatchCalcSelector<std::uint8_t>(DistCalcMethod::L2);
+                m_fComputeDotBatch = DistanceBatchCalcSelector<std::int8_t>(DistCalcMethod::Cosine);
+            }
+
+            ~SQ8Quantizer() {}
+
+            inline QuantizerType GetQuantizerType() const { return QuantizerType::SQ8; }
+            inline DimensionType GetCodeSize() const { return m_iDimension; }
+            inline std::size_t GetQueryTableSize() const { return m_iDimension; }
+
+            // The range is cheap to collect, so every vector is used and p_sampleNum is ignored.
+            ErrorCode Train(const Dataset<T>& p_data, SizeType p_sampleNum, int p_threadNum)
+            {
+                if (p_data.C() != m_iDimension) return ErrorCode::DimensionSizeMismatch;
+                if (p_data.R() == 0) return ErrorCode::EmptyData;
+
+                m_range.Initialize(2, m_iDimension);
+                float* minValues = m_range[0];
+                float* maxValues = m_range[1];
+                for (DimensionType j = 0; j < m_iDimension; j++)
+                {
+                    minValues[j] = MaxDist;
+                    maxValues[j] = -MaxDist;
+                }
+                for (SizeType i = 0; i < p_data.R(); i++)
+                {
+                    const T* v = p_data[i];
+                    for (DimensionType j = 0; j < m_iDimension; j++)
+                    {
+                        float value = (float)v[j];
+                        if (value < minValues[j]) minValues[j] = value;
+                        if (value > maxValues[j]) maxValues[j] = value;
+                    }
+                }
+                std::cout << "Train SQ8 on " << p_data.R() << " vectors" << std::endl;
+                UpdateStep();
+                return ErrorCode::Success;
+            }
+
+            void Encode(const T* p_vector, std::uint8_t* p_code) const
+            {
+                const float* minValues = m_range[0];
+                for (DimensionType j = 0; j < m_iDimension; j++)
+                {
+                    if (m_bDotProduct)
+                    {
+                        float code = std::round((float)p_vector[j] / m_fStep);
+                        p_code[j] = (std::uint8_t)(std::int8_t)max(min(code, 127.0f), -127.0f);
+                    }
+                    else
+                    {
+                        float code = std::round(((float)p_vector[j] - minValues[j]) / m_fStep);
+                        p_code[j] = (std::uint8_t)max(min(code, 255.0f), 0.0f);
+                    }
+                }
+            }
+
+            // The query table is the query encoded like any other vector.
+            void BuildQueryTable(const T* p_query, std::uint8_t* p_table) const
+            {
+                Encode(p_query, p_table);
+            }
+
+            // Scales the 8-bit kernel results back to the index distance so that they compare with
+            // the full precision distances of the tree pivots: L2 is step^2 * |a - b|^2 and the dot
+            // product kernel returns 127^2 - a.b.
+            void ComputeDistanceBatch(const std::uint8_t* p_table, const std::uint8_t* const* p_codes, int p_count, float* p_results) const
+            {
+                float stepSquare = m_fStep * m_fStep;
+                if (m_bDotProduct)
+                {
+                    m_fComputeDotBatch((const std::int8_t*)p_table, (const std::int8_t* const*)p_codes, p_count, m_iDimension, p_results);
+                    float base = (float)Utils::GetBase<std::int8_t>() * Utils::GetBase<std::int8_t>();
+                    for (int i = 0; i < p_count; i++) p_results[i] = m_fBaseSquare - stepSquare * (base - p_results[i]);
+                }
+                else
+                {
+                    m_fComputeL2Batch(p_table, p_codes, p_count, m_iDimension, p_results);
+                    for (int i = 0; i < p_count; i++) p_results[i] *= stepSquare;
+                }
+            }
+
+            inline std::uint64_t BufferSize() const { return m_range.BufferSize(); }
+
+            bool Save(std::ostream& p_outstream) const
+            {
+                return m_range.Save(p_outstream);
+            }
+
+            bool Load(std::ifstream& p_instream)
+            {
+                if (!m_range.Load(p_instream)) return false;
+                return CheckRange();
+            }
+
+            bool Load(char* p_mem)
+            {
+                if (!m_range.Load(p_mem)) return false;
+                return CheckRange();
+            }
+
+        private:
+            bool CheckRange()
+            {
+                if (m_range.R() != 2 || m_range.C() != m_iDimension)
+                {
+                    std::cerr << "Error: SQ8 range (" << m_range.R() << ", " << m_range.C() << ") does not match dimension " << m_iDimension << "." << std::endl;
+                    return false;
+                }
+                UpdateStep();
+                return true;
+            }
+
+            void UpdateStep()
+            {
+                const float* minValues = m_range[0];
+                const float* maxValues = m_range[1];
+                float width = 0;
+                for (DimensionType j = 0; j < m_iDimension; j++)
+                {
+                    if (m_bDotProduct) width = max(width, max(std::fabs(minValues[j]), std::fabs(maxValues[j])) / 127.0f);
+                    else width = max(width, (maxValues[j] - minValues[j]) / 255.0f);
+                }
+                m_fStep = (width > 0) ? width : 1.0f;
+            }
+
+            DimensionType m_iDimension;
+            bool m_bDotProduct;
+            float m_fBaseSquare;
+            float m_fStep;
+
+            // Row 0 holds the minimum and row 1 the maximum of every dimension.
+            Dataset<float> m_range;
+
+            void(*m_fComputeL2Batch)(const std::uint8_t* pQuery, const std::uint8_t* const* pRows, int count, DimensionType length, float* pResults);
+            void(*m_fComputeDotBatch)(const std::int8_t* pQuery, const std::int8_t* const* pRows, int count, DimensionType length, float* pResults);
+        };
+    }
+}
+
+#endif // _SPTAG_COMMON_SQ8QUANTIZER_H_
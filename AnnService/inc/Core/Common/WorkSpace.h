@@ -7,6 +7,9 @@
 #include "CommonUtils.h"
 #include "Heap.h"
 
+#include <chrono>
+#include <unordered_set>
+
 namespace SPTAG
 {
     namespace COMMON
@@ -133,6 +136,55 @@ namespace SPTAG
                 return -1;
             }
         };
+
+        // Visited set that stamps each vector id with the number of the query that last reached it.
+        // Starting a query only bumps the number, and a lookup is one array access whatever the MaxCheck,
+        // at the cost of two bytes per vector in the index for every work space. The stamps are cleared
+        // once every 65535 queries, when the number wraps around.
+        class EpochVisitedTable
+        {
+        public:
+            EpochVisitedTable() : m_epoch(0) {}
+
+            ~EpochVisitedTable() {}
+
+            void Init(SizeType size)
+            {
+                m_epochs.assign(size, 0);
+                m_epoch = 0;
+            }
+
+            inline bool Initialized() const { return !m_epochs.empty(); }
+
+            void clear()
+            {
+                if (++m_epoch == 0)
+                {
+                    std::fill(m_epochs.begin(), m_epochs.end(), (std::uint16_t)0);
+                    m_epoch = 1;
+                }
+            }
+
+            inline bool Contains(SizeType idx) const
+            {
+                return (std::size_t)idx < m_epochs.size() && m_epochs[idx] == m_epoch;
+            }
+
+            inline bool CheckAndSet(SizeType idx)
+            {
+                // Vectors added after the work space was created
+                if ((std::size_t)idx >= m_epochs.size()) m_epochs.resize(max((std::size_t)idx + 1, m_epochs.size() * 2), 0);
+
+                if (m_epochs[idx] == m_epoch) return true;
+                m_epochs[idx] = m_epoch;
+                return false;
+            }
+
+        private:
+            std::vector<std::uint16_t> m_epochs;
+
+            std::uint16_t m_epoch;
+        };
 /*
         class DistPriorityQueue {
             float* data;
@@ -179,9 +231,15 @@ namespace SPTAG
         // Variables for each single NN search
         struct WorkSpace
         {
+            // Hops between two looks at the clock when the query has a deadline
+            static const int DeadlineCheckInterval = 16;
+
             void Initialize(int maxCheck, SizeType dataSize)
             {
                 nodeCheckStatus.Init(maxCheck);
+                m_iMaxCheckCapacity = maxCheck;
+                m_iDataSize = dataSize;
+                m_bEpochVisited = false;
                 m_SPTQueue.Resize(maxCheck * 10);
                 m_NGQueue.Resize(maxCheck * 30);
                 //m_Results.Resize(maxCheck / 16);
@@ -191,11 +249,42 @@ namespace SPTAG
                 m_iContinuousLimit = maxCheck / 64;
                 m_iMaxCheck = maxCheck;
                 m_iNumOfContinuousNoBetterPropagation = 0;
+                m_iNumberOfInitialDynamicPivots = 0;
+                m_iNumberOfOtherDynamicPivots = 0;
+                m_iNumberOfBoundedDistances = 0;
+                m_iNumberOfAbandonedDistances = 0;
+                m_pQuantizedQuery = nullptr;
+                m_bHasDeadline = false;
+                m_bCutShort = false;
+                m_iHopsToDeadlineCheck = 0;
+                m_bFiltered = false;
+                m_iAttributeMask = 0;
+                m_iAttributeValue = 0;
+                m_pAllowedIDs = nullptr;
+                m_pExcludedIDs = nullptr;
             }
 
-            void Reset(int maxCheck)
+            // The epoch table is allocated by the first query that asks for it.
+            void Reset(int maxCheck, VisitedTableType visitedTable)
             {
-                nodeCheckStatus.clear();
+                // A query may ask for more checks than the pool was created for.
+                if (maxCheck > m_iMaxCheckCapacity)
+                {
+                    nodeCheckStatus.Init(maxCheck);
+                    m_SPTQueue.Resize(maxCheck * 10);
+                    m_NGQueue.Resize(maxCheck * 30);
+                    m_iMaxCheckCapacity = maxCheck;
+                }
+
+                m_bEpochVisited = false;
+                if (VisitedTableType::Epoch == visitedTable)
+                {
+                    UseEpochVisitedTable();
+                }
+                else
+                {
+                    nodeCheckStatus.clear();
+                }
                 m_SPTQueue.clear();
                 m_NGQueue.clear();
                 //m_Results.clear(maxCheck / 16);
@@ -205,21 +294,131 @@ namespace SPTAG
                 m_iNumberOfTreeCheckedLeaves = 0;
                 m_iNumberOfCheckedLeaves = 0;
                 m_iMaxCheck = maxCheck;
+                m_iNumberOfBoundedDistances = 0;
+                m_iNumberOfAbandonedDistances = 0;
+                m_pQuantizedQuery = nullptr;
+                m_bHasDeadline = false;
+                m_bCutShort = false;
+                m_bFiltered = false;
+                m_pAllowedIDs = nullptr;
+                m_pExcludedIDs = nullptr;
+            }
+
+            // Switches the current query to the epoch table, which unlike the hash table never fills up.
+            inline void UseEpochVisitedTable()
+            {
+                if (m_bEpochVisited) return;
+
+                if (!m_epochVisited.Initialized()) m_epochVisited.Init(max(m_iDataSize, (SizeType)1));
+                m_epochVisited.clear();
+                m_bEpochVisited = true;
+            }
+
+            inline void SetDeadline(std::chrono::steady_clock::time_point p_deadline)
+            {
+                m_bHasDeadline = (p_deadline != std::chrono::steady_clock::time_point::max());
+                m_deadline = p_deadline;
+                m_iHopsToDeadlineCheck = 1;
+            }
+
+            // Called once per hop; reads the clock on the first hop and then every DeadlineCheckInterval hops.
+            inline bool DeadlinePassed()
+            {
+                if (!m_bHasDeadline || --m_iHopsToDeadlineCheck > 0) return false;
+
+                m_iHopsToDeadlineCheck = DeadlineCheckInterval;
+                m_bCutShort = (std::chrono::steady_clock::now() >= m_deadline);
+                return m_bCutShort;
+            }
+
+            // Call after Reset. The allowed IDs are marked in m_allowedTable, unless the list is short enough
+            // to be scanned instead of searching the graph (ScanAllowedIDs); IDs from p_numSamples on are ignored.
+            inline void SetFilter(std::uint64_t p_attributeMask, std::uint64_t p_attributeValue, const std::vector<SizeType>* p_allowedIDs,
+                const std::unordered_set<SizeType>* p_excludedIDs, SizeType p_numSamples)
+            {
+                m_iAttributeMask = p_attributeMask;
+                m_iAttributeValue = p_attributeValue & p_attributeMask;
+                m_pAllowedIDs = p_allowedIDs;
+                m_pExcludedIDs = (p_excludedIDs != nullptr && !p_excludedIDs->empty()) ? p_excludedIDs : nullptr;
+                m_bFiltered = (p_attributeMask != 0 || p_allowedIDs != nullptr || m_pExcludedIDs != nullptr);
+                if (p_allowedIDs == nullptr || ScanAllowedIDs()) return;
+
+                if (!m_allowedTable.Initialized()) m_allowedTable.Init(max(m_iDataSize, (SizeType)1));
+                m_allowedTable.clear();
+                for (SizeType id : *p_allowedIDs)
+                {
+                    if (id >= 0 && id < p_numSamples) m_allowedTable.CheckAndSet(id);
+                }
+            }
+
+            inline bool ScanAllowedIDs() const
+            {
+                return m_pAllowedIDs != nullptr && m_pAllowedIDs->size() <= (std::size_t)max(m_iMaxCheck, 0);
+            }
+
+            inline bool MatchesAttribute(std::uint64_t p_attribute) const
+            {
+                return (p_attribute & m_iAttributeMask) == m_iAttributeValue;
+            }
+
+            inline bool IsExcluded(SizeType idx) const
+            {
+                return m_pExcludedIDs != nullptr && m_pExcludedIDs->find(idx) != m_pExcludedIDs->end();
+            }
+
+            inline bool PassesFilter(SizeType idx, std::uint64_t p_attribute) const
+            {
+                return MatchesAttribute(p_attribute) && (m_pAllowedIDs == nullptr || m_allowedTable.Contains(idx)) && !IsExcluded(idx);
             }
 
             inline bool CheckAndSet(SizeType idx)
             {
-                return nodeCheckStatus.CheckAndSet(idx);
+                return m_bEpochVisited ? m_epochVisited.CheckAndSet(idx) : nodeCheckStatus.CheckAndSet(idx);
+            }
+
+            // Hands out the buffer for the quantizer table of the current query; the graph traversal
+            // scores compressed codes against it until the next Reset.
+            inline std::uint8_t* PrepareQuantizedQuery(std::size_t size)
+            {
+                if (m_quantizedQueryBuffer.size() < size) m_quantizedQueryBuffer.resize(size);
+                m_pQuantizedQuery = m_quantizedQueryBuffer.data();
+                return m_quantizedQueryBuffer.data();
             }
 
             OptHashPosVector nodeCheckStatus;
 
+            // Used instead of nodeCheckStatus when the query asks for the Epoch visited table
+            EpochVisitedTable m_epochVisited;
+            bool m_bEpochVisited;
+            SizeType m_iDataSize;
+
             // counter for dynamic pivoting
             int m_iNumOfContinuousNoBetterPropagation;
             int m_iContinuousLimit;
             int m_iNumberOfTreeCheckedLeaves;
             int m_iNumberOfCheckedLeaves;
             int m_iMaxCheck;
+            int m_iMaxCheckCapacity;
+            int m_iNumberOfInitialDynamicPivots;
+            int m_iNumberOfOtherDynamicPivots;
+
+            // Distances computed against an upper bound, and how many of them were abandoned early
+            int m_iNumberOfBoundedDistances;
+            int m_iNumberOfAbandonedDistances;
+
+            // Deadline of the current query, and whether the search stopped because of it
+            std::chrono::steady_clock::time_point m_deadline;
+            bool m_bHasDeadline;
+            bool m_bCutShort;
+            int m_iHopsToDeadlineCheck;
+
+            // Filter of the current query; only vectors that pass it join the results
+            bool m_bFiltered;
+            std::uint64_t m_iAttributeMask;
+            std::uint64_t m_iAttributeValue;
+            const std::vector<SizeType>* m_pAllowedIDs;
+            const std::unordered_set<SizeType>* m_pExcludedIDs;
+            EpochVisitedTable m_allowedTable;
 
             // Prioriy queue used for neighborhood graph
             Heap<HeapCell> m_NGQueue;
@@ -228,6 +427,10 @@ namespace SPTAG
             Heap<HeapCell> m_SPTQueue;
 
             //DistPriorityQueue m_Results;
+
+            // Quantizer table of the current query, nullptr for full precision traversal
+            const std::uint8_t* m_pQuantizedQuery;
+            std::vector<std::uint8_t> m_quantizedQueryBuffer;
         };
     }
 }
@@ -7,6 +7,9 @@ DefineVectorValueType(Int8, std::int8_t)
 DefineVectorValueType(UInt8, std::uint8_t)
 DefineVectorValueType(Int16, std::int16_t)
 DefineVectorValueType(Float, float)
+DefineVectorValueType(Float16, SPTAG::Float16)
+DefineVectorValueType(BFloat16, SPTAG::BFloat16)
+DefineVectorValueType(Binary, SPTAG::Binary)
 
 #endif // DefineVectorValueType
 
@@ -15,10 +18,29 @@ DefineVectorValueType(Float, float)
 
 DefineDistCalcMethod(L2)
 DefineDistCalcMethod(Cosine)
+DefineDistCalcMethod(InnerProduct)
+DefineDistCalcMethod(Hamming)
 
 #endif // DefineDistCalcMethod
 
 
+#ifdef DefineQuantizerType
+
+DefineQuantizerType(None)
+DefineQuantizerType(PQ)
+DefineQuantizerType(SQ8)
+
+#endif // DefineQuantizerType
+
+
+#ifdef DefineVisitedTableType
+
+DefineVisitedTableType(Hash)
+DefineVisitedTableType(Epoch)
+
+#endif // DefineVisitedTableType
+
+
 #ifdef DefineErrorCode
 
 // 0x0000 ~ 0x0FFF  General Status
@@ -59,5 +81,6 @@ DefineErrorCode(Socket_FailedConnectToEndPoint, 0x4001)
 
 DefineIndexAlgo(BKT)
 DefineIndexAlgo(KDT)
+DefineIndexAlgo(Flat)
 
 #endif // DefineIndexAlgo
@@ -0,0 +1,181 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _SPTAG_FLAT_INDEX_H_
+#define _SPTAG_FLAT_INDEX_H_
+
+#include "../Common.h"
+#include "../VectorIndex.h"
+
+#include "../Common/CommonUtils.h"
+#include "../Common/DistanceUtils.h"
+#include "../Common/QueryResultSet.h"
+#include "../Common/Dataset.h"
+#include "../Common/Labelset.h"
+#include "../Common/Attributeset.h"
+#include "inc/Helper/SimpleIniReader.h"
+#include "inc/Helper/StringConvert.h"
+
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+
+namespace SPTAG
+{
+
+    namespace Helper
+    {
+        class IniReader;
+    }
+
+    namespace Flat
+    {
+        // Exact search by scanning all vectors, for small collections, ground truth and recall checks.
+        // The vectors are scanned in blocks small enough to stay in the L2 cache, and a group of queries
+        // scores each block in turn before the scan moves on, so every vector is read from memory once
+        // per group rather than once per query.
+        template<typename T>
+        class Index : public VectorIndex
+        {
+            class ScanIterator;
+
+        private:
+            // data points
+            COMMON::Dataset<T> m_pSamples;
+
+            std::string m_sDataPointsFilename;
+            std::string m_sDeleteDataPointsFilename;
+
+            float m_fDeletePercentageForRefine;
+            std::mutex m_dataAddLock; // protect data
+            std::shared_timed_mutex m_dataDeleteLock;
+            COMMON::Labelset m_deletedID;
+            COMMON::Attributeset m_attributes;
+
+            int m_iNumberOfThreads;
+
+            DistCalcMethod m_iDistCalcMethod;
+            float(*m_fComputeDistance)(const T* pX, const T* pY, DimensionType length);
+            void(*m_fComputeDistanceBatch)(const T* pQuery, const T* const* pRows, int count, DimensionType length, float* pResults);
+            int m_iBaseSquare;
+
+            // Vectors per scan block; 0 picks as many as fit in 128KB.
+            int m_iScanBlockSize;
+
+            // How many queries of a batch search share the scan of each block.
+            int m_iSearchGroupSize;
+        public:
+            Index()
+            {
+#define DefineFlatParameter(VarName, VarType, DefaultValue, RepresentStr) \
+                VarName = DefaultValue; \
+
+#include "inc/Core/Flat/ParameterDefinitionList.h"
+#undef DefineFlatParameter
+
+                m_bReady = false;
+                m_pSamples.SetName("Vector");
+                m_fComputeDistance = COMMON::DistanceCalcSelector<T>(m_iDistCalcMethod);
+                m_fComputeDistanceBatch = COMMON::DistanceBatchCalcSelector<T>(m_iDistCalcMethod);
+                m_iBaseSquare = (m_iDistCalcMethod == DistCalcMethod::Cosine || m_iDistCalcMethod == DistCalcMethod::InnerProduct) ? COMMON::Utils::GetBase<T>() * COMMON::Utils::GetBase<T>() : 1;
+            }
+
+            ~Index() {}
+
+            inline SizeType GetNumSamples() const { return m_pSamples.R(); }
+            inline SizeType GetNumDeleted() const { return (SizeType)m_deletedID.Count(); }
+            inline DimensionType GetFeatureDim() const { return m_pSamples.C(); }
+
+            inline int GetNumThreads() const { return m_iNumberOfThreads; }
+            inline DistCalcMethod GetDistCalcMethod() const { return m_iDistCalcMethod; }
+            inline IndexAlgoType GetIndexAlgoType() const { return IndexAlgoType::Flat; }
+            inline VectorValueType GetVectorValueType() const { return GetEnumValueType<T>(); }
+
+            inline float AccurateDistance(const void* pX, const void* pY) const {
+                if (m_iDistCalcMethod != DistCalcMethod::Cosine) return m_fComputeDistance((const T*)pX, (const T*)pY, m_pSamples.C());
+
+                float xy = m_iBaseSquare - m_fComputeDistance((const T*)pX, (const T*)pY, m_pSamples.C());
+                float xx = m_iBaseSquare - m_fComputeDistance((const T*)pX, (const T*)pX, m_pSamples.C());
+                float yy = m_iBaseSquare - m_fComputeDistance((const T*)pY, (const T*)pY, m_pSamples.C());
+                return 1.0f - xy / (sqrt(xx) * sqrt(yy));
+            }
+            inline float ComputeDistance(const void* pX, const void* pY) const { return m_fComputeDistance((const T*)pX, (const T*)pY, m_pSamples.C()); }
+            inline const void* GetSample(const SizeType idx) const { return (void*)m_pSamples[idx]; }
+            inline bool ContainSample(const SizeType idx) const { return !m_deletedID.Contains(idx); }
+            ErrorCode SetAttribute(const SizeType idx, std::uint64_t p_attribute);
+            inline std::uint64_t GetAttribute(const SizeType idx) const { return (idx >= 0 && idx < GetNumSamples()) ? m_attributes.Get(idx) : 0; }
+            inline bool NeedRefine() const { return m_deletedID.Count() > (size_t)(GetNumSamples() * m_fDeletePercentageForRefine); }
+
+            std::shared_ptr<std::vector<std::uint64_t>> BufferSize() const
+            {
+                std::shared_ptr<std::vector<std::uint64_t>> buffersize(new std::vector<std::uint64_t>);
+                buffersize->push_back(m_pSamples.BufferSize());
+                buffersize->push_back(m_deletedID.BufferSize() + m_attributes.BufferSize());
+                return std::move(buffersize);
+            }
+
+            ErrorCode SaveConfig(std::ostream& p_configout) const;
+            ErrorCode SaveIndexData(const std::string& p_folderPath);
+            ErrorCode SaveIndexData(const std::vector<std::ostream*>& p_indexStreams);
+
+            ErrorCode LoadConfig(Helper::IniReader& p_reader);
+            ErrorCode LoadIndexData(const std::string& p_folderPath);
+            ErrorCode LoadIndexDataFromMemory(const std::vector<ByteArray>& p_indexBlobs);
+
+            ErrorCode BuildIndex(const void* p_data, SizeType p_vectorNum, DimensionType p_dimension);
+            ErrorCode SearchIndex(QueryResult &p_query, bool p_searchDeleted = false) const;
+            ErrorCode SearchIndex(const void* p_vector, int p_vectorCount, int p_neighborCount, bool p_withMeta, BasicResult* p_results) const;
+            ErrorCode SearchIndexGroup(QueryResult** p_queries, int p_queryCount, bool p_searchDeleted = false) const;
+            ErrorCode RefineSearchIndex(QueryResult &p_query, bool p_searchDeleted = false) const;
+            ErrorCode SearchIndexWithinRadius(QueryResult &p_query, float p_radius, bool p_searchDeleted = false) const;
+            std::shared_ptr<ResultIterator> GetIterator(const void* p_target, const SearchOptions& p_options = SearchOptions()) const;
+            ErrorCode AddIndex(const void* p_data, SizeType p_vectorNum, DimensionType p_dimension, std::shared_ptr<MetadataSet> p_metadataSet, bool p_withMetaIndex = false);
+            ErrorCode DeleteIndex(const void* p_vectors, SizeType p_vectorNum);
+            ErrorCode DeleteIndex(const SizeType& p_id);
+
+            ErrorCode SetParameter(const char* p_param, const char* p_value);
+            std::string GetParameter(const char* p_param) const;
+
+            ErrorCode RefineIndex(const std::string& p_folderPath);
+            ErrorCode RefineIndex(const std::vector<std::ostream*>& p_indexStreams);
+            ErrorCode RefineIndex(std::shared_ptr<VectorIndex>& p_newIndex);
+
+        private:
+            // Scores p_count queries against all vectors, one block at a time. Q is COMMON::QueryResultSet<T>
+            // for the K nearest neighbors, COMMON::RadiusResultSet<T> for range search or
+            // COMMON::DistinctResultSet<T> for the K nearest distinct metadata values.
+            template <typename Q>
+            void ScanBlocks(Q** p_queries, const SearchOptions* const* p_options, int p_count, const bool* p_searchDeleted, bool* p_cutShort) const;
+            // Scores a single query against its allowed vectors only (SearchOptions::m_allowedIDs).
+            template <typename Q>
+            void ScanAllowedIDs(Q& p_query, const SearchOptions& p_options, bool p_searchDeleted) const;
+            template <typename Q>
+            bool Scan(Q& p_query, const SearchOptions& p_options, bool p_searchDeleted) const;
+
+            inline bool Accepts(SizeType p_id, const SearchOptions& p_options, bool p_searchDeleted) const
+            {
+                return (p_searchDeleted || !m_deletedID.Contains(p_id)) &&
+                    (p_options.m_attributeMask == 0 || ((m_attributes.Get(p_id) ^ p_options.m_attributeValue) & p_options.m_attributeMask) == 0) &&
+                    (p_options.m_excludedIDs == nullptr || p_options.m_excludedIDs->count(p_id) == 0);
+            }
+
+            inline SizeType ScanBlockSize() const
+            {
+                if (m_iScanBlockSize > 0) return m_iScanBlockSize;
+                SizeType rows = (SizeType)((128 * 1024) / (sizeof(T) * max(GetFeatureDim(), 1)));
+                return max(rows - rows % COMMON::DistanceUtils::BatchSize, (SizeType)COMMON::DistanceUtils::BatchSize);
+            }
+
+            // Binds the distance kernels, compiled for the feature dimension when there are such kernels.
+            inline void SelectDistanceKernels()
+            {
+                m_fComputeDistance = COMMON::DistanceCalcSelector<T>(m_iDistCalcMethod, GetFeatureDim());
+                m_fComputeDistanceBatch = COMMON::DistanceBatchCalcSelector<T>(m_iDistCalcMethod, GetFeatureDim());
+            }
+
+            void FillMetadata(QueryResult& p_query) const;
+        };
+    } // namespace Flat
+} // namespace SPTAG
+
+#endif // _SPTAG_FLAT_INDEX_H_
@@ -0,0 +1,17 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifdef DefineFlatParameter
+
+// DefineFlatParameter(VarName, VarType, DefaultValue, RepresentStr)
+DefineFlatParameter(m_sDataPointsFilename, std::string, std::string("vectors.bin"), "VectorFilePath")
+DefineFlatParameter(m_sDeleteDataPointsFilename, std::string, std::string("deletes.bin"), "DeleteVectorFilePath")
+
+DefineFlatParameter(m_iNumberOfThreads, int, 1L, "NumberOfThreads")
+DefineFlatParameter(m_iDistCalcMethod, SPTAG::DistCalcMethod, SPTAG::DistCalcMethod::Cosine, "DistCalcMethod")
+
+DefineFlatParameter(m_fDeletePercentageForRefine, float, 0.4F, "DeletePercentageForRefine")
+DefineFlatParameter(m_iScanBlockSize, int, 0L, "ScanBlockSize")
+DefineFlatParameter(m_iSearchGroupSize, int, 16L, "SearchGroupSize")
+
+#endif
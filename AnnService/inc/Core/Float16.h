@@ -0,0 +1,129 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _SPTAG_CORE_FLOAT16_H_
+#define _SPTAG_CORE_FLOAT16_H_
+
+#include <cstdint>
+#include <cstring>
+
+namespace SPTAG
+{
+
+// 16-bit floating point vector elements. Both types only hold the raw bits, so vector files and
+// index samples are plain arrays of std::uint16_t; any arithmetic goes through the implicit
+// conversion to float. The distance kernels convert whole registers at a time instead.
+
+// IEEE 754 binary16: 1 sign, 5 exponent and 10 mantissa bits.
+struct Float16
+{
+    std::uint16_t bits;
+
+    Float16() = default;
+
+    Float16(float p_value) : bits(FromFloat(p_value)) {}
+
+    operator float() const { return ToFloat(bits); }
+
+    // Round to nearest even; values beyond the half range become infinity.
+    static inline std::uint16_t FromFloat(float p_value)
+    {
+        std::uint32_t f;
+        std::memcpy(&f, &p_value, sizeof(f));
+        std::uint32_t sign = f & 0x80000000u;
+        f ^= sign;
+
+        std::uint32_t h;
+        if (f >= (127u + 16u) << 23)
+        {
+            // Inf stays Inf, NaN becomes a quiet NaN.
+            h = (f > 255u << 23) ? 0x7e00 : 0x7c00;
+        }
+        else if (f < 113u << 23)
+        {
+            // Subnormal or zero: adding 0.5f lines the 10 mantissa bits up at the bottom of the
+            // float and lets the FPU do the rounding.
+            float v;
+            std::memcpy(&v, &f, sizeof(v));
+            v += 0.5f;
+            std::memcpy(&f, &v, sizeof(f));
+            h = f - (126u << 23);
+        }
+        else
+        {
+            std::uint32_t mantissaOdd = (f >> 13) & 1;
+            f += (std::uint32_t)(15 - 127) * (1u << 23) + 0xfff + mantissaOdd;
+            h = f >> 13;
+        }
+        return (std::uint16_t)(h | (sign >> 16));
+    }
+
+    static inline float ToFloat(std::uint16_t p_bits)
+    {
+        std::uint32_t f = (std::uint32_t)(p_bits & 0x7fff) << 13;
+        std::uint32_t exponent = f & (0x7c00u << 13);
+        f += (127u - 15u) << 23;
+
+        float v;
+        if (exponent == 0x7c00u << 13)
+        {
+            // Inf or NaN.
+            f += (128u - 16u) << 23;
+            std::memcpy(&v, &f, sizeof(v));
+        }
+        else if (exponent == 0)
+        {
+            // Zero or subnormal: renormalize through the FPU.
+            f += 1u << 23;
+            std::memcpy(&v, &f, sizeof(v));
+            v -= 6.103515625e-05f;
+        }
+        else
+        {
+            std::memcpy(&v, &f, sizeof(v));
+        }
+
+        if (p_bits & 0x8000) v = -v;
+        return v;
+    }
+};
+
+
+// bfloat16: the upper half of an IEEE 754 binary32, keeping the float exponent range.
+struct BFloat16
+{
+    std::uint16_t bits;
+
+    BFloat16() = default;
+
+    BFloat16(float p_value) : bits(FromFloat(p_value)) {}
+
+    operator float() const { return ToFloat(bits); }
+
+    // Round to nearest even.
+    static inline std::uint16_t FromFloat(float p_value)
+    {
+        std::uint32_t f;
+        std::memcpy(&f, &p_value, sizeof(f));
+        if ((f & 0x7fffffffu) > 0x7f800000u)
+        {
+            return (std::uint16_t)((f >> 16) | 0x40);
+        }
+        f += 0x7fff + ((f >> 16) & 1);
+        return (std::uint16_t)(f >> 16);
+    }
+
+    static inline float ToFloat(std::uint16_t p_bits)
+    {
+        std::uint32_t f = (std::uint32_t)p_bits << 16;
+        float v;
+        std::memcpy(&v, &f, sizeof(v));
+        return v;
+    }
+};
+
+static_assert(sizeof(Float16) == 2 && sizeof(BFloat16) == 2, "16-bit value types must not be padded");
+
+} // namespace SPTAG
+
+#endif // _SPTAG_CORE_FLOAT16_H_
@@ -10,16 +10,19 @@
 #include "../Common/CommonUtils.h"
 #include "../Common/DistanceUtils.h"
 #include "../Common/QueryResultSet.h"
+#include "../Common/IndexResultIterator.h"
 #include "../Common/Dataset.h"
 #include "../Common/WorkSpace.h"
 #include "../Common/WorkSpacePool.h"
 #include "../Common/RelativeNeighborhoodGraph.h"
 #include "../Common/KDTree.h"
 #include "../Common/Labelset.h"
+#include "../Common/Attributeset.h"
 #include "inc/Helper/SimpleIniReader.h"
 #include "inc/Helper/StringConvert.h"
 #include "inc/Helper/ThreadPool.h"
 
+#include <atomic>
 #include <functional>
 #include <shared_mutex>
 
@@ -68,6 +71,7 @@ namespace SPTAG
             std::mutex m_dataAddLock; // protect data and graph
             std::shared_timed_mutex m_dataDeleteLock;
             COMMON::Labelset m_deletedID;
+            COMMON::Attributeset m_attributes;
             
             std::unique_ptr<COMMON::WorkSpacePool> m_workSpacePool;
             Helper::ThreadPool m_threadPool;
@@ -75,12 +79,21 @@ namespace SPTAG
 
             DistCalcMethod m_iDistCalcMethod;
             float(*m_fComputeDistance)(const T* pX, const T* pY, DimensionType length);
+            void(*m_fComputeDistanceBatch)(const T* pQuery, const T* const* pRows, int count, DimensionType length, float* pResults);
             int m_iBaseSquare;
  
             int m_iMaxCheck;
             int m_iThresholdOfNumberOfContinuousNoBetterPropagation;
             int m_iNumberOfInitialDynamicPivots;
             int m_iNumberOfOtherDynamicPivots;
+
+            // How a query remembers the nodes it has already visited.
+            VisitedTableType m_eVisitedTable;
+
+            // Stop scoring a neighbor once it is farther than the current worst result.
+            bool m_bEarlyAbandon;
+            mutable std::atomic<std::uint64_t> m_iBoundedDistances;
+            mutable std::atomic<std::uint64_t> m_iAbandonedDistances;
         public:
             Index()
             {
@@ -91,9 +104,12 @@ namespace SPTAG
 #undef DefineKDTParameter
 
                 m_bReady = false;
+                m_iBoundedDistances = 0;
+                m_iAbandonedDistances = 0;
                 m_pSamples.SetName("Vector");
                 m_fComputeDistance = COMMON::DistanceCalcSelector<T>(m_iDistCalcMethod);
-                m_iBaseSquare = (m_iDistCalcMethod == DistCalcMethod::Cosine) ? COMMON::Utils::GetBase<T>() * COMMON::Utils::GetBase<T>() : 1;
+                m_fComputeDistanceBatch = COMMON::DistanceBatchCalcSelector<T>(m_iDistCalcMethod);
+                m_iBaseSquare = (m_iDistCalcMethod == DistCalcMethod::Cosine || m_iDistCalcMethod == DistCalcMethod::InnerProduct) ? COMMON::Utils::GetBase<T>() * COMMON::Utils::GetBase<T>() : 1;
             }
 
             ~Index() {}
@@ -109,7 +125,7 @@ namespace SPTAG
             inline VectorValueType GetVectorValueType() const { return GetEnumValueType<T>(); }
             
             inline float AccurateDistance(const void* pX, const void* pY) const {
-                if (m_iDistCalcMethod == DistCalcMethod::L2) return m_fComputeDistance((const T*)pX, (const T*)pY, m_pSamples.C());
+                if (m_iDistCalcMethod != DistCalcMethod::Cosine) return m_fComputeDistance((const T*)pX, (const T*)pY, m_pSamples.C());
 
                 float xy = m_iBaseSquare - m_fComputeDistance((const T*)pX, (const T*)pY, m_pSamples.C());
                 float xx = m_iBaseSquare - m_fComputeDistance((const T*)pX, (const T*)pX, m_pSamples.C());
@@ -119,14 +135,20 @@ namespace SPTAG
             inline float ComputeDistance(const void* pX, const void* pY) const { return m_fComputeDistance((const T*)pX, (const T*)pY, m_pSamples.C()); }
             inline const void* GetSample(const SizeType idx) const { return (void*)m_pSamples[idx]; }
             inline bool ContainSample(const SizeType idx) const { return !m_deletedID.Contains(idx); }
+            ErrorCode SetAttribute(const SizeType idx, std::uint64_t p_attribute);
+            inline std::uint64_t GetAttribute(const SizeType idx) const { return (idx >= 0 && idx < GetNumSamples()) ? m_attributes.Get(idx) : 0; }
             inline bool NeedRefine() const { return m_deletedID.Count() > (size_t)(GetNumSamples() * m_fDeletePercentageForRefine); }
+
+            // Totals over all SearchIndex calls of the distances computed against a bound and of those abandoned early.
+            inline std::uint64_t GetNumberOfBoundedDistances() const { return m_iBoundedDistances; }
+            inline std::uint64_t GetNumberOfAbandonedDistances() const { return m_iAbandonedDistances; }
             std::shared_ptr<std::vector<std::uint64_t>> BufferSize() const
             {
                 std::shared_ptr<std::vector<std::uint64_t>> buffersize(new std::vector<std::uint64_t>);
                 buffersize->push_back(m_pSamples.BufferSize());
                 buffersize->push_back(m_pTrees.BufferSize());
                 buffersize->push_back(m_pGraph.BufferSize());
-                buffersize->push_back(m_deletedID.BufferSize());
+                buffersize->push_back(m_deletedID.BufferSize() + m_attributes.BufferSize());
                 return std::move(buffersize);
             }
 
@@ -141,6 +163,8 @@ namespace SPTAG
             ErrorCode BuildIndex(const void* p_data, SizeType p_vectorNum, DimensionType p_dimension);
             ErrorCode SearchIndex(QueryResult &p_query, bool p_searchDeleted = false) const;
             ErrorCode RefineSearchIndex(QueryResult &p_query, bool p_searchDeleted = false) const;
+            ErrorCode SearchIndexWithinRadius(QueryResult &p_query, float p_radius, bool p_searchDeleted = false) const;
+            std::shared_ptr<ResultIterator> GetIterator(const void* p_target, const SearchOptions& p_options = SearchOptions()) const;
             ErrorCode AddIndex(const void* p_data, SizeType p_vectorNum, DimensionType p_dimension, std::shared_ptr<MetadataSet> p_metadataSet, bool p_withMetaIndex = false);
             ErrorCode DeleteIndex(const void* p_vectors, SizeType p_vectorNum);
             ErrorCode DeleteIndex(const SizeType& p_id);
@@ -153,8 +177,25 @@ namespace SPTAG
             ErrorCode RefineIndex(std::shared_ptr<VectorIndex>& p_newIndex);
 
         private:
-            void SearchIndexWithDeleted(COMMON::QueryResultSet<T> &p_query, COMMON::WorkSpace &p_space) const;
-            void SearchIndexWithoutDeleted(COMMON::QueryResultSet<T> &p_query, COMMON::WorkSpace &p_space) const;
+            friend class COMMON::IndexResultIterator<T, Index<T>>;
+
+            // Q is COMMON::QueryResultSet<T> for the K nearest neighbors, COMMON::RadiusResultSet<T> for range search
+            // or COMMON::DistinctResultSet<T> for the K nearest distinct metadata values.
+            template <typename Q>
+            void SearchIndexWithDeleted(Q &p_query, COMMON::WorkSpace &p_space) const;
+            template <typename Q>
+            void SearchIndexWithoutDeleted(Q &p_query, COMMON::WorkSpace &p_space) const;
+            template <typename Q>
+            void SearchIndex(Q &p_query, COMMON::WorkSpace &p_space, bool p_searchDeleted) const;
+            template <typename Q>
+            void SearchIndexWithFilter(Q &p_query, COMMON::WorkSpace &p_space, bool p_searchDeleted) const;
+            template <typename Q>
+            void ScanAllowedIDs(Q &p_query, COMMON::WorkSpace &p_space, bool p_searchDeleted) const;
+            // Continues the walk of an iterator until p_results holds p_count vectors or the walk runs out.
+            void SearchIndexIterative(COMMON::IterativeResultSet<T>& p_query, COMMON::WorkSpace& p_space, bool p_isFirst, int p_count, bool p_searchDeleted, std::vector<BasicResult>& p_results) const;
+            void ResetWorkSpace(COMMON::WorkSpace& p_space, const SearchOptions& p_options, int p_maxCheck) const;
+
+            inline bool UseBoundedDistance() const { return m_bEarlyAbandon && COMMON::DistanceUtils::SupportsBoundedDistance<T>(m_iDistCalcMethod); }
         };
     } // namespace KDT
 } // namespace SPTAG
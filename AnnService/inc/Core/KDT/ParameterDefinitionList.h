@@ -34,5 +34,7 @@ DefineKDTParameter(m_iMaxCheck, int, 8192L, "MaxCheck")
 DefineKDTParameter(m_iThresholdOfNumberOfContinuousNoBetterPropagation, int, 3L, "ThresholdOfNumberOfContinuousNoBetterPropagation")
 DefineKDTParameter(m_iNumberOfInitialDynamicPivots, int, 50L, "NumberOfInitialDynamicPivots")
 DefineKDTParameter(m_iNumberOfOtherDynamicPivots, int, 4L, "NumberOfOtherDynamicPivots")
+DefineKDTParameter(m_bEarlyAbandon, bool, true, "EarlyAbandon")
+DefineKDTParameter(m_eVisitedTable, SPTAG::VisitedTableType, SPTAG::VisitedTableType::Hash, "VisitedTable")
 
 #endif
@@ -0,0 +1,31 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _SPTAG_RESULTITERATOR_H_
+#define _SPTAG_RESULTITERATOR_H_
+
+#include "SearchQuery.h"
+
+namespace SPTAG
+{
+
+// Pages through the nearest neighbors of one query (VectorIndex::GetIterator). Each call to Next continues
+// the search where the previous one stopped, so asking for the next page does not repeat the work done for
+// the earlier ones. The iterator holds a work space of the index until it is closed, and must not outlive
+// the index.
+class ResultIterator
+{
+public:
+    virtual ~ResultIterator() {}
+
+    // Fills p_results with the next p_results.GetResultNum() vectors, nearest first. Each call checks at most
+    // MaxCheck more vectors; once the search has run out of vectors, the remaining results get VID -1.
+    virtual ErrorCode Next(QueryResult& p_results) = 0;
+
+    // Hands the work space back to the index; Next fails afterwards. The destructor closes the iterator too.
+    virtual void Close() = 0;
+};
+
+} // namespace SPTAG
+
+#endif // _SPTAG_RESULTITERATOR_H_
@@ -6,11 +6,78 @@
 
 #include "SearchResult.h"
 
+#include <chrono>
 #include <cstring>
+#include <memory>
+#include <unordered_set>
+#include <vector>
 
 namespace SPTAG
 {
 
+// Search parameters of a single query. A value below zero keeps the setting of the index, so queries with
+// different recall/latency needs can share one index without changing it through SetParameter.
+struct SearchOptions
+{
+    // Nodes a query may visit (MaxCheck).
+    int m_maxCheck;
+
+    // Visited nodes in a row that may fail to improve the results before the search stops.
+    int m_continuousLimit;
+
+    // Tree leaves taken before the graph walk starts (NumberOfInitialDynamicPivots).
+    int m_initialDynamicPivots;
+
+    // Tree leaves taken each time the graph walk falls back to the trees (NumberOfOtherDynamicPivots).
+    int m_otherDynamicPivots;
+
+    // Also return vectors that have been deleted.
+    bool m_searchDeleted;
+
+    // The search stops at this time and returns the best results found so far (see QueryResult::IsCutShort).
+    std::chrono::steady_clock::time_point m_deadline;
+
+    // Only vectors whose attribute (VectorIndex::SetAttribute) matches m_attributeValue in the bits of
+    // m_attributeMask are returned; the search still passes through the others. A zero mask matches all.
+    std::uint64_t m_attributeMask;
+    std::uint64_t m_attributeValue;
+
+    // Only these vectors are returned, unless it is nullptr. Lists no longer than MaxCheck are scanned
+    // directly instead of searching the graph.
+    std::shared_ptr<const std::vector<SizeType>> m_allowedIDs;
+
+    // These vectors are never returned, e.g. the items a user has already seen. Checked only for the
+    // vectors that would join the results.
+    std::shared_ptr<const std::unordered_set<SizeType>> m_excludedIDs;
+
+    // Return at most one vector per metadata value, the nearest one, so that near duplicates sharing a
+    // metadata key take a single result slot. Needs an index with metadata.
+    bool m_distinctByMetadata;
+
+    SearchOptions()
+        : m_maxCheck(-1),
+          m_continuousLimit(-1),
+          m_initialDynamicPivots(-1),
+          m_otherDynamicPivots(-1),
+          m_searchDeleted(false),
+          m_deadline(std::chrono::steady_clock::time_point::max()),
+          m_attributeMask(0),
+          m_attributeValue(0),
+          m_distinctByMetadata(false)
+    {
+    }
+
+    inline void SetTimeBudget(std::chrono::nanoseconds p_budget)
+    {
+        m_deadline = std::chrono::steady_clock::now() + p_budget;
+    }
+
+    inline bool HasFilter() const
+    {
+        return m_attributeMask != 0 || m_allowedIDs != nullptr || m_excludedIDs != nullptr;
+    }
+};
+
 // Space to save temporary answer, similar with TopKCache
 class QueryResult
 {
@@ -21,7 +88,8 @@ public:
     QueryResult()
         : m_target(nullptr),
           m_resultNum(0),
-          m_withMeta(false)
+          m_withMeta(false),
+          m_cutShort(false)
     {
     }
 
@@ -35,7 +103,8 @@ public:
     QueryResult(const void* p_target, int p_resultNum, bool p_withMeta, BasicResult* p_results)
         : m_target(p_target),
           m_resultNum(p_resultNum),
-          m_withMeta(p_withMeta)
+          m_withMeta(p_withMeta),
+          m_cutShort(false)
     {
         m_results.Set(p_results, p_resultNum, false);
     }
@@ -44,6 +113,8 @@ public:
     QueryResult(const QueryResult& p_other)
     {
         Init(p_other.m_target, p_other.m_resultNum, p_other.m_withMeta);
+        m_options = p_other.m_options;
+        m_cutShort = p_other.m_cutShort;
         if (m_resultNum > 0)
         {
             std::copy(p_other.m_results.Data(), p_other.m_results.Data() + m_resultNum, m_results.Data());
@@ -54,6 +125,8 @@ public:
     QueryResult& operator=(const QueryResult& p_other)
     {
         Init(p_other.m_target, p_other.m_resultNum, p_other.m_withMeta);
+        m_options = p_other.m_options;
+        m_cutShort = p_other.m_cutShort;
         if (m_resultNum > 0)
         {
             std::copy(p_other.m_results.Data(), p_other.m_results.Data() + m_resultNum, m_results.Data());
@@ -73,6 +146,7 @@ public:
         m_target = p_target;
         m_resultNum = p_resultNum;
         m_withMeta = p_withMeta;
+        m_cutShort = false;
 
         m_results = Array<BasicResult>::Alloc(p_resultNum);
     }
@@ -124,6 +198,31 @@ public:
     }
 
 
+    inline const SearchOptions& GetOptions() const
+    {
+        return m_options;
+    }
+
+
+    inline void SetOptions(const SearchOptions& p_options)
+    {
+        m_options = p_options;
+    }
+
+
+    // True when the search reached the deadline of its options and the results are the best found by then.
+    inline bool IsCutShort() const
+    {
+        return m_cutShort;
+    }
+
+
+    inline void SetCutShort(bool p_cutShort)
+    {
+        m_cutShort = p_cutShort;
+    }
+
+
     inline const ByteArray& GetMetadata(int p_index) const
     {
         if (p_index < m_resultNum && m_withMeta)
@@ -152,6 +251,7 @@ public:
             m_results[i].Dist = MaxDist;
             m_results[i].Meta.Clear();
         }
+        m_cutShort = false;
     }
 
 
@@ -187,6 +287,10 @@ protected:
     bool m_withMeta;
 
     Array<BasicResult> m_results;
+
+    SearchOptions m_options;
+
+    bool m_cutShort;
 };
 } // namespace SPTAG
 
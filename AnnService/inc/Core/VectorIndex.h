@@ -6,6 +6,7 @@
 
 #include "Common.h"
 #include "SearchQuery.h"
+#include "ResultIterator.h"
 #include "VectorSet.h"
 #include "MetadataSet.h"
 #include "inc/Helper/SimpleIniReader.h"
@@ -32,13 +33,40 @@ public:
     
     virtual ErrorCode RefineSearchIndex(QueryResult &p_query, bool p_searchDeleted = false) const = 0;
 
+    // Finds the vectors within p_radius of the query, in the distance units of the index, nearest first.
+    // The query is re-initialized to hold as many results as were found; its result number is ignored.
+    virtual ErrorCode SearchIndexWithinRadius(QueryResult& p_query, float p_radius, bool p_searchDeleted = false) const = 0;
+
+    // Starts a search that returns the nearest neighbors of p_target page by page (see ResultIterator).
+    // MaxCheck of the options bounds each page; the other options apply as for SearchIndex, apart from
+    // m_distinctByMetadata. Returns nullptr for an empty index.
+    virtual std::shared_ptr<ResultIterator> GetIterator(const void* p_target, const SearchOptions& p_options = SearchOptions()) const = 0;
+
     virtual ErrorCode RefineIndex(std::shared_ptr<VectorIndex>& p_newIndex) = 0;
 
     virtual float AccurateDistance(const void* pX, const void* pY) const = 0;
+    // Exact distance from pX to sample idx; indexes may reuse what they keep per sample, such as its norm.
+    virtual float AccurateDistance(const void* pX, const SizeType idx) const
+    {
+        return AccurateDistance(pX, GetSample(idx));
+    }
     virtual float ComputeDistance(const void* pX, const void* pY) const = 0;
+    // May stop once the distance exceeds p_bound and return the partial value instead, flagging p_abandoned
+    // (see DistanceUtils::ComputeDistanceBounded). Indexes that do not abandon compute the full distance.
+    virtual float ComputeDistanceBounded(const void* pX, const void* pY, float p_bound, bool& p_abandoned) const
+    {
+        p_abandoned = false;
+        return ComputeDistance(pX, pY);
+    }
     virtual const void* GetSample(const SizeType idx) const = 0;
     virtual bool ContainSample(const SizeType idx) const = 0;
+    // Attribute of a vector that filtered searches match (see SearchOptions::m_attributeMask); 0 until set.
+    virtual ErrorCode SetAttribute(const SizeType idx, std::uint64_t p_attribute) = 0;
+    virtual std::uint64_t GetAttribute(const SizeType idx) const = 0;
     virtual bool NeedRefine() const = 0;
+    // Id that vector idx would have if the index had not renumbered its vectors for locality (BKT with
+    // ReorderVectors), e.g. its position in the input of BuildIndex; idx itself for other indexes.
+    virtual SizeType GetOriginalID(const SizeType idx) const { return idx; }
    
     virtual DimensionType GetFeatureDim() const = 0;
     virtual SizeType GetNumSamples() const = 0;
@@ -69,6 +97,10 @@ public:
 
     virtual ErrorCode SearchIndex(const void* p_vector, int p_vectorCount, int p_neighborCount, bool p_withMeta, BasicResult* p_results) const;
 
+    // Searches several queries on the calling thread. Indexes that can interleave the queries to hide
+    // memory latency override this; by default they are searched one after another.
+    virtual ErrorCode SearchIndexGroup(QueryResult** p_queries, int p_queryCount, bool p_searchDeleted = false) const;
+
     virtual std::string GetParameter(const std::string& p_param) const;
     virtual ErrorCode SetParameter(const std::string& p_param, const std::string& p_value);
 
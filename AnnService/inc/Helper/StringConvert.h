@@ -148,6 +148,42 @@ inline bool ConvertStringTo<double>(const char* p_str, double& p_value)
 }
 
 
+template <>
+inline bool ConvertStringTo<Float16>(const char* p_str, Float16& p_value)
+{
+    float value;
+    if (!ConvertStringTo<float>(p_str, value))
+    {
+        return false;
+    }
+
+    p_value = value;
+    return true;
+}
+
+
+template <>
+inline bool ConvertStringTo<BFloat16>(const char* p_str, BFloat16& p_value)
+{
+    float value;
+    if (!ConvertStringTo<float>(p_str, value))
+    {
+        return false;
+    }
+
+    p_value = value;
+    return true;
+}
+
+
+// A Binary element is written as the unsigned value of its byte (0 to 255).
+template <>
+inline bool ConvertStringTo<Binary>(const char* p_str, Binary& p_value)
+{
+    return ConvertStringToUnsignedInt(p_str, p_value.bits);
+}
+
+
 template <>
 inline bool ConvertStringTo<std::int8_t>(const char* p_str, std::int8_t& p_value)
 {
@@ -269,6 +305,50 @@ inline bool ConvertStringTo<DistCalcMethod>(const char* p_str, DistCalcMethod& p
 }
 
 
+template <>
+inline bool ConvertStringTo<QuantizerType>(const char* p_str, QuantizerType& p_value)
+{
+    if (nullptr == p_str)
+    {
+        return false;
+    }
+
+#define DefineQuantizerType(Name) \
+    else if (StrUtils::StrEqualIgnoreCase(p_str, #Name)) \
+    { \
+        p_value = QuantizerType::Name; \
+        return true; \
+    } \
+
+#include "inc/Core/DefinitionList.h"
+#undef DefineQuantizerType
+
+    return false;
+}
+
+
+template <>
+inline bool ConvertStringTo<VisitedTableType>(const char* p_str, VisitedTableType& p_value)
+{
+    if (nullptr == p_str)
+    {
+        return false;
+    }
+
+#define DefineVisitedTableType(Name) \
+    else if (StrUtils::StrEqualIgnoreCase(p_str, #Name)) \
+    { \
+        p_value = VisitedTableType::Name; \
+        return true; \
+    } \
+
+#include "inc/Core/DefinitionList.h"
+#undef DefineVisitedTableType
+
+    return false;
+}
+
+
 template <>
 inline bool ConvertStringTo<VectorValueType>(const char* p_str, VectorValueType& p_value)
 {
@@ -347,6 +427,46 @@ inline std::string ConvertToString<DistCalcMethod>(const DistCalcMethod& p_value
 }
 
 
+template <>
+inline std::string ConvertToString<QuantizerType>(const QuantizerType& p_value)
+{
+    switch (p_value)
+    {
+#define DefineQuantizerType(Name) \
+    case QuantizerType::Name: \
+        return #Name; \
+
+#include "inc/Core/DefinitionList.h"
+#undef DefineQuantizerType
+
+    default:
+        break;
+    }
+
+    return "Undefined";
+}
+
+
+template <>
+inline std::string ConvertToString<VisitedTableType>(const VisitedTableType& p_value)
+{
+    switch (p_value)
+    {
+#define DefineVisitedTableType(Name) \
+    case VisitedTableType::Name: \
+        return #Name; \
+
+#include "inc/Core/DefinitionList.h"
+#undef DefineVisitedTableType
+
+    default:
+        break;
+    }
+
+    return "Undefined";
+}
+
+
 template <>
 inline std::string ConvertToString<VectorValueType>(const VectorValueType& p_value)
 {
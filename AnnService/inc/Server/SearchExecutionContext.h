@@ -53,6 +53,13 @@ public:
 
     const bool GetExtractMetadata() const;
 
+    const SearchOptions& GetSearchOptions() const;
+
+    // True when the query asks for all vectors within GetRadius() instead of the nearest GetResultNum().
+    const bool IsRadiusSearch() const;
+
+    const float GetRadius() const;
+
 private:
     const std::shared_ptr<const ServiceSettings> c_serviceSettings;
 
@@ -71,6 +78,12 @@ private:
     bool m_extractMetadata;
 
     SizeType m_resultNum;
+
+    SearchOptions m_searchOptions;
+
+    bool m_radiusSearch;
+
+    float m_radius;
 };
 
 } // namespace Server
@@ -31,9 +31,20 @@ public:
 
     void Execute();
 
+    // Executes several requests together: the requests that select the same index are searched as one
+    // group (see VectorIndex::SearchIndexGroup), radius searches one by one. The callbacks run once all
+    // searches are done.
+    static void ExecuteGroup(const std::vector<std::unique_ptr<SearchExecutor>>& p_executors);
+
 private:
+    // Parses the query and selects the indexes that match its vector; false if there is nothing to search.
+    bool Prepare();
+
     void ExecuteInternal();
 
+    // Searches the selected indexes for the prepared query, one after another.
+    void SearchSelectedIndexes();
+
     void SelectIndex();
 
 private:
@@ -9,7 +9,9 @@
 
 #include <boost/asio.hpp>
 
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <vector>
 #include <thread>
 #include <condition_variable>
@@ -37,7 +39,8 @@ private:
 
     void RunInteractiveMode();
 
-    void SearchHanlder(Socket::ConnectionID p_localConnectionID, Socket::Packet p_packet);
+    // Executes the oldest pending requests, at most SearchGroupSize of them, as one group.
+    void SearchHanlder();
 
     void SearchHanlderCallback(std::shared_ptr<SearchExecutionContext> p_exeContext,
                                Socket::Packet p_srcPacket);
@@ -63,6 +66,12 @@ private:
     boost::asio::io_context m_ioContext;
 
     boost::asio::signal_set m_shutdownSignals;
+
+    // Search requests waiting for a worker. Every request posts one SearchHanlder job, and a job takes
+    // whatever is pending when it runs, so requests are only grouped when the workers are busy.
+    std::deque<std::pair<Socket::ConnectionID, Socket::Packet>> m_pendingSearches;
+
+    std::mutex m_pendingSearchesMutex;
 };
 
 
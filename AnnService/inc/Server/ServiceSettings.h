@@ -28,6 +28,8 @@ struct ServiceSettings
     SizeType m_threadNum;
 
     SizeType m_socketThreadNum;
+
+    SizeType m_searchGroupSize;
 };
 
 
@@ -53,10 +53,11 @@ struct IndexSearchResult
 };
 
 
+// Mirror version 1 appends whether each index search was cut short by its deadline.
 struct RemoteSearchResult
 {
     static constexpr std::uint16_t MajorVersion() { return 1; }
-    static constexpr std::uint16_t MirrorVersion() { return 0; }
+    static constexpr std::uint16_t MirrorVersion() { return 1; }
 
     enum class ResultStatus : std::uint8_t
     {
@@ -53,7 +53,12 @@ int main(int argc, char** argv)
 
         for (const auto& indexRes : result.m_allIndexResults)
         {
-            std::cout << "Index: " << indexRes.m_indexName << std::endl;
+            std::cout << "Index: " << indexRes.m_indexName;
+            if (indexRes.m_results.IsCutShort())
+            {
+                std::cout << " (cut short by the time budget)";
+            }
+            std::cout << std::endl;
 
             int idx = 0;
             for (const auto& res : indexRes.m_results)
@@ -32,9 +32,35 @@ namespace SPTAG
             if (p_indexBlobs.size() < 3) return ErrorCode::LackOfInputs;
 
             if (!m_pSamples.Load((char*)p_indexBlobs[0].Data())) return ErrorCode::FailedParseValue;
+            SelectDistanceKernels();
+            if (!LoadSampleNorms(p_indexBlobs[0])) return ErrorCode::FailedParseValue;
             if (!m_pTrees.LoadTrees((char*)p_indexBlobs[1].Data())) return ErrorCode::FailedParseValue;
             if (!m_pGraph.LoadGraph((char*)p_indexBlobs[2].Data())) return ErrorCode::FailedParseValue;
-            if (p_indexBlobs.size() > 3 && !m_deletedID.Load((char*)p_indexBlobs[3].Data())) return ErrorCode::FailedParseValue;
+            if (p_indexBlobs.size() > 3)
+            {
+                if (!m_deletedID.Load((char*)p_indexBlobs[3].Data())) return ErrorCode::FailedParseValue;
+                std::uint64_t offset = m_deletedID.BufferSize();
+                if (!m_attributes.Load((char*)p_indexBlobs[3].Data() + offset, p_indexBlobs[3].Length() - offset, GetNumSamples())) return ErrorCode::FailedParseValue;
+            }
+            else
+            {
+                m_attributes.Initialize(GetNumSamples());
+            }
+            if (m_eQuantizerType != QuantizerType::None)
+            {
+                if (p_indexBlobs.size() < 5) return ErrorCode::LackOfInputs;
+                if ((m_pQuantizer = CreateQuantizer()) == nullptr) return ErrorCode::FailedParseValue;
+
+                char* pQuantizerMemFile = (char*)p_indexBlobs[4].Data();
+                if (!m_pQuantizer->Load(pQuantizerMemFile) || !m_pQuantizedSamples.Load(pQuantizerMemFile + m_pQuantizer->BufferSize())) return ErrorCode::FailedParseValue;
+                if (m_pQuantizedSamples.R() != GetNumSamples() || m_pQuantizedSamples.C() != m_pQuantizer->GetCodeSize()) return ErrorCode::FailedParseValue;
+            }
+            if (m_bReorderVectors)
+            {
+                size_t blob = (m_eQuantizerType != QuantizerType::None) ? 5 : 4;
+                if (p_indexBlobs.size() <= blob) return ErrorCode::LackOfInputs;
+                if (!m_pOriginalIDs.Load((char*)p_indexBlobs[blob].Data())) return ErrorCode::FailedParseValue;
+            }
 
             omp_set_num_threads(m_iNumberOfThreads);
             m_workSpacePool.reset(new COMMON::WorkSpacePool(max(m_iMaxCheck, m_pGraph.m_iMaxCheckForRefineGraph), GetNumSamples()));
@@ -47,10 +73,32 @@ namespace SPTAG
         template <typename T>
         ErrorCode Index<T>::LoadIndexData(const std::string& p_folderPath)
         {
-            if (!m_pSamples.Load(p_folderPath + m_sDataPointsFilename)) return ErrorCode::Fail;
+            {
+                std::cout << "Load " << m_pSamples.Name() << " From " << p_folderPath + m_sDataPointsFilename << std::endl;
+                std::ifstream input(p_folderPath + m_sDataPointsFilename, std::ios::binary);
+                if (!input.is_open() || !m_pSamples.Load(input)) return ErrorCode::Fail;
+                SelectDistanceKernels();
+                if (!LoadSampleNorms(input)) return ErrorCode::Fail;
+                input.close();
+            }
             if (!m_pTrees.LoadTrees(p_folderPath + m_sBKTFilename)) return ErrorCode::Fail;
             if (!m_pGraph.LoadGraph(p_folderPath + m_sGraphFilename)) return ErrorCode::Fail;
-            if (!m_deletedID.Load(p_folderPath + m_sDeleteDataPointsFilename)) return ErrorCode::Fail;
+            {
+                std::cout << "Load DeleteID From " << p_folderPath + m_sDeleteDataPointsFilename << std::endl;
+                std::ifstream input(p_folderPath + m_sDeleteDataPointsFilename, std::ios::binary);
+                if (!input.is_open() || !m_deletedID.Load(input) || !m_attributes.Load(input, GetNumSamples())) return ErrorCode::Fail;
+                input.close();
+            }
+            if (m_eQuantizerType != QuantizerType::None)
+            {
+                std::cout << "Load Quantizer From " << p_folderPath + m_sQuantizerFilename << std::endl;
+                std::ifstream input(p_folderPath + m_sQuantizerFilename, std::ios::binary);
+                if (!input.is_open() || (m_pQuantizer = CreateQuantizer()) == nullptr) return ErrorCode::Fail;
+                if (!m_pQuantizer->Load(input) || !m_pQuantizedSamples.Load(input)) return ErrorCode::Fail;
+                input.close();
+                if (m_pQuantizedSamples.R() != GetNumSamples() || m_pQuantizedSamples.C() != m_pQuantizer->GetCodeSize()) return ErrorCode::Fail;
+            }
+            if (m_bReorderVectors && !m_pOriginalIDs.Load(p_folderPath + m_sOriginalIDFilename)) return ErrorCode::Fail;
 
             omp_set_num_threads(m_iNumberOfThreads);
             m_workSpacePool.reset(new COMMON::WorkSpacePool(max(m_iMaxCheck, m_pGraph.m_iMaxCheckForRefineGraph), GetNumSamples()));
@@ -79,10 +127,30 @@ namespace SPTAG
             std::lock_guard<std::mutex> lock(m_dataAddLock);
             std::unique_lock<std::shared_timed_mutex> uniquelock(m_dataDeleteLock);
 
-            if (!m_pSamples.Save(p_folderPath + m_sDataPointsFilename)) return ErrorCode::Fail;
+            {
+                std::cout << "Save " << m_pSamples.Name() << " To " << p_folderPath + m_sDataPointsFilename << std::endl;
+                std::ofstream output(p_folderPath + m_sDataPointsFilename, std::ios::binary);
+                if (!output.is_open() || !m_pSamples.Save(output)) return ErrorCode::Fail;
+                if (KeepsSampleNorms() && !m_pSampleNorms.Save(output)) return ErrorCode::Fail;
+                output.close();
+            }
             if (!m_pTrees.SaveTrees(p_folderPath + m_sBKTFilename)) return ErrorCode::Fail;
             if (!m_pGraph.SaveGraph(p_folderPath + m_sGraphFilename)) return ErrorCode::Fail;
-            if (!m_deletedID.Save(p_folderPath + m_sDeleteDataPointsFilename)) return ErrorCode::Fail;
+            {
+                std::cout << "Save DeleteID To " << p_folderPath + m_sDeleteDataPointsFilename << std::endl;
+                std::ofstream output(p_folderPath + m_sDeleteDataPointsFilename, std::ios::binary);
+                if (!output.is_open() || !m_deletedID.Save(output) || !m_attributes.Save(output)) return ErrorCode::Fail;
+                output.close();
+            }
+            if (m_pQuantizer != nullptr)
+            {
+                std::cout << "Save Quantizer To " << p_folderPath + m_sQuantizerFilename << std::endl;
+                std::ofstream output(p_folderPath + m_sQuantizerFilename, std::ios::binary);
+                if (!output.is_open()) return ErrorCode::Fail;
+                if (!m_pQuantizer->Save(output) || !m_pQuantizedSamples.Save(output)) return ErrorCode::Fail;
+                output.close();
+            }
+            if (m_bReorderVectors && !m_pOriginalIDs.Save(p_folderPath + m_sOriginalIDFilename)) return ErrorCode::Fail;
             return ErrorCode::Success;
         }
 
@@ -95,25 +163,41 @@ namespace SPTAG
             std::unique_lock<std::shared_timed_mutex> uniquelock(m_dataDeleteLock);
 
             if (!m_pSamples.Save(*p_indexStreams[0])) return ErrorCode::Fail;
+            if (KeepsSampleNorms() && !m_pSampleNorms.Save(*p_indexStreams[0])) return ErrorCode::Fail;
             if (!m_pTrees.SaveTrees(*p_indexStreams[1])) return ErrorCode::Fail;
             if (!m_pGraph.SaveGraph(*p_indexStreams[2])) return ErrorCode::Fail;
-            if (!m_deletedID.Save(*p_indexStreams[3])) return ErrorCode::Fail;
+            if (!m_deletedID.Save(*p_indexStreams[3]) || !m_attributes.Save(*p_indexStreams[3])) return ErrorCode::Fail;
+            if (m_pQuantizer != nullptr)
+            {
+                if (p_indexStreams.size() < 5) return ErrorCode::LackOfInputs;
+                if (!m_pQuantizer->Save(*p_indexStreams[4]) || !m_pQuantizedSamples.Save(*p_indexStreams[4])) return ErrorCode::Fail;
+            }
+            if (m_bReorderVectors)
+            {
+                size_t stream = (m_pQuantizer != nullptr) ? 5 : 4;
+                if (p_indexStreams.size() <= stream) return ErrorCode::LackOfInputs;
+                if (!m_pOriginalIDs.Save(*p_indexStreams[stream])) return ErrorCode::Fail;
+            }
             return ErrorCode::Success;
         }
 
 #pragma region K-NN search
-#define Search(CheckDeleted, CheckDuplicated) \
-        std::shared_lock<std::shared_timed_mutex> lock(*(m_pTrees.m_lock)); \
-        m_pTrees.InitSearchTrees(this, p_query, p_space); \
-        m_pTrees.SearchTrees(this, p_query, p_space, m_iNumberOfInitialDynamicPivots); \
-        const DimensionType checkPos = m_pGraph.m_iNeighborhoodSize - 1; \
-        while (!p_space.m_NGQueue.empty()) { \
-            COMMON::HeapCell gnode = p_space.m_NGQueue.pop(); \
-            SizeType tmpNode = gnode.node; \
-            const SizeType *node = m_pGraph[tmpNode]; \
+// Fetches the neighbor list of a popped node and the vectors (or codes) of its neighbors into the cache.
+#define PrefetchNeighbors(node, quantized) \
             _mm_prefetch((const char *)node, _MM_HINT_T0); \
             for (DimensionType i = 0; i <= checkPos; i++) { \
-                _mm_prefetch((const char *)(m_pSamples)[node[i]], _MM_HINT_T0); \
+                _mm_prefetch(quantized ? (const char *)m_pQuantizedSamples[node[i]] : (const char *)(m_pSamples)[node[i]], _MM_HINT_T0); \
+            } \
+
+// One hop of the graph search for p_query / p_space: takes the popped node gnode as a result (or as the
+// pivots of its tree node) and queues its unvisited neighbors. Stop runs when the search has converged
+// or the deadline of the query has passed.
+// With early abandon, a neighbor farther than the current worst result is queued with a partial distance.
+// That is still above the worst result, which only shrinks, so the node is handled as "no better" when it
+// is popped, exactly as with its full distance; only its order among such nodes can change.
+#define ExpandNode(CheckDeleted, CheckDuplicated, Stop) \
+            if (p_space.DeadlinePassed()) { \
+                Stop \
             } \
             if (gnode.distance <= p_query.worstDist()) { \
                 SizeType checkNode = node[checkPos]; \
@@ -139,22 +223,102 @@ namespace SPTAG
             } else { \
                 p_space.m_iNumOfContinuousNoBetterPropagation++; \
                 if (p_space.m_iNumOfContinuousNoBetterPropagation > p_space.m_iContinuousLimit || p_space.m_iNumberOfCheckedLeaves > p_space.m_iMaxCheck) { \
-                    p_query.SortResult(); return; \
+                    Stop \
                 } \
             } \
-            for (DimensionType i = 0; i <= checkPos; i++) { \
-                SizeType nn_index = node[i]; \
-                if (nn_index < 0) break; \
-                if (p_space.CheckAndSet(nn_index)) continue; \
-                float distance2leaf = m_fComputeDistance(p_query.GetTarget(), (m_pSamples)[nn_index], GetFeatureDim()); \
-                p_space.m_iNumberOfCheckedLeaves++; \
-                p_space.m_NGQueue.insert(COMMON::HeapCell(nn_index, distance2leaf)); \
+            for (DimensionType i = 0; i <= checkPos;) { \
+                SizeType batchNodes[COMMON::DistanceUtils::BatchSize]; \
+                const T* batchRows[COMMON::DistanceUtils::BatchSize]; \
+                const std::uint8_t* batchCodes[COMMON::DistanceUtils::BatchSize]; \
+                float batchDists[COMMON::DistanceUtils::BatchSize]; \
+                int batchCount = 0; \
+                for (; i <= checkPos && batchCount < COMMON::DistanceUtils::BatchSize; i++) { \
+                    SizeType nn_index = node[i]; \
+                    if (nn_index < 0) { i = checkPos + 1; break; } \
+                    if (p_space.CheckAndSet(nn_index)) continue; \
+                    batchNodes[batchCount] = nn_index; \
+                    if (quantized) batchCodes[batchCount++] = m_pQuantizedSamples[nn_index]; \
+                    else batchRows[batchCount++] = (m_pSamples)[nn_index]; \
+                } \
+                if (quantized) m_pQuantizer->ComputeDistanceBatch(p_space.m_pQuantizedQuery, batchCodes, batchCount, batchDists); \
+                else if (bounded) { \
+                    p_space.m_iNumberOfBoundedDistances += batchCount; \
+                    p_space.m_iNumberOfAbandonedDistances += COMMON::DistanceUtils::ComputeDistanceBatchBounded(m_fComputeDistanceBatch, p_query.GetTarget(), batchRows, batchCount, GetFeatureDim(), p_query.worstDist(), batchDists); \
+                } \
+                else m_fComputeDistanceBatch(p_query.GetTarget(), batchRows, batchCount, GetFeatureDim(), batchDists); \
+                p_space.m_iNumberOfCheckedLeaves += batchCount; \
+                for (int j = 0; j < batchCount; j++) { \
+                    p_space.m_NGQueue.insert(COMMON::HeapCell(batchNodes[j], batchDists[j])); \
+                } \
             } \
             if (p_space.m_NGQueue.Top().distance > p_space.m_SPTQueue.Top().distance) { \
-                m_pTrees.SearchTrees(this, p_query, p_space, m_iNumberOfOtherDynamicPivots + p_space.m_iNumberOfCheckedLeaves); \
+                m_pTrees.SearchTrees(this, p_query, p_space, p_space.m_iNumberOfOtherDynamicPivots + p_space.m_iNumberOfCheckedLeaves); \
             } \
+
+#define Search(CheckDeleted, CheckDuplicated) \
+        std::shared_lock<std::shared_timed_mutex> lock(*(m_pTrees.m_lock)); \
+        m_pTrees.InitSearchTrees(this, p_query, p_space); \
+        m_pTrees.SearchTrees(this, p_query, p_space, p_space.m_iNumberOfInitialDynamicPivots); \
+        const DimensionType checkPos = m_pGraph.m_iNeighborhoodSize - 1; \
+        const bool quantized = (p_space.m_pQuantizedQuery != nullptr); \
+        const bool bounded = !quantized && UseBoundedDistance(); \
+        while (!p_space.m_NGQueue.empty()) { \
+            COMMON::HeapCell gnode = p_space.m_NGQueue.pop(); \
+            SizeType tmpNode = gnode.node; \
+            const SizeType *node = m_pGraph[tmpNode]; \
+            PrefetchNeighbors(node, quantized) \
+            ExpandNode(CheckDeleted, CheckDuplicated, p_query.SortResult(); return;) \
         } \
         p_query.SortResult(); \
+
+// Runs the queries of a group in lockstep, one hop of each in turn. Every query takes exactly the hops
+// of a single search, but the node a query pops is prefetched right away and only expanded after the
+// other queries have taken their hop, so the cache misses of one query overlap with the distance
+// computations of the others.
+#define SearchGroup(CheckDeleted, CheckDuplicated) \
+        std::shared_lock<std::shared_timed_mutex> lock(*(m_pTrees.m_lock)); \
+        const DimensionType checkPos = m_pGraph.m_iNeighborhoodSize - 1; \
+        std::vector<COMMON::HeapCell> nextNodes(p_count); \
+        std::vector<char> active(p_count, 0); \
+        int remaining = 0; \
+        for (int q = 0; q < p_count; q++) { \
+            COMMON::QueryResultSet<T>& p_query = *p_queries[q]; \
+            COMMON::WorkSpace& p_space = *p_spaces[q]; \
+            m_pTrees.InitSearchTrees(this, p_query, p_space); \
+            m_pTrees.SearchTrees(this, p_query, p_space, p_space.m_iNumberOfInitialDynamicPivots); \
+            if (p_space.m_NGQueue.empty()) { \
+                p_query.SortResult(); \
+                continue; \
+            } \
+            nextNodes[q] = p_space.m_NGQueue.pop(); \
+            const SizeType *node = m_pGraph[nextNodes[q].node]; \
+            PrefetchNeighbors(node, p_space.m_pQuantizedQuery != nullptr) \
+            active[q] = 1; \
+            remaining++; \
+        } \
+        while (remaining > 0) { \
+            for (int q = 0; q < p_count; q++) { \
+                if (!active[q]) continue; \
+                COMMON::QueryResultSet<T>& p_query = *p_queries[q]; \
+                COMMON::WorkSpace& p_space = *p_spaces[q]; \
+                const bool quantized = (p_space.m_pQuantizedQuery != nullptr); \
+                const bool bounded = !quantized && UseBoundedDistance(); \
+                COMMON::HeapCell gnode = nextNodes[q]; \
+                SizeType tmpNode = gnode.node; \
+                const SizeType *node = m_pGraph[tmpNode]; \
+                ExpandNode(CheckDeleted, CheckDuplicated, p_query.SortResult(); active[q] = 0; remaining--; continue;) \
+                if (p_space.m_NGQueue.empty()) { \
+                    p_query.SortResult(); \
+                    active[q] = 0; \
+                    remaining--; \
+                    continue; \
+                } \
+                nextNodes[q] = p_space.m_NGQueue.pop(); \
+                node = m_pGraph[nextNodes[q].node]; \
+                PrefetchNeighbors(node, quantized) \
+            } \
+        } \
+
 /*
 #define Search(CheckDeleted, CheckDuplicated) \
         std::shared_lock<std::shared_timed_mutex> lock(*(m_pTrees.m_lock)); \
@@ -214,9 +378,26 @@ namespace SPTAG
 */
 
         template <typename T>
-        void Index<T>::SearchIndex(COMMON::QueryResultSet<T> &p_query, COMMON::WorkSpace &p_space, bool p_searchDeleted, bool p_searchDuplicated) const
+        template <typename Q>
+        void Index<T>::SearchIndex(Q &p_query, COMMON::WorkSpace &p_space, bool p_searchDeleted, bool p_searchDuplicated) const
         {
-            if (m_deletedID.Count() == 0 || p_searchDeleted)
+            if (p_space.m_bFiltered)
+            {
+                // The walk goes through every node as usual, but only the nodes that pass the filter become results.
+                if (p_space.ScanAllowedIDs())
+                {
+                    ScanAllowedIDs(p_query, p_space, p_searchDeleted);
+                }
+                else if (p_searchDuplicated)
+                {
+                    Search(if ((p_searchDeleted || !m_deletedID.Contains(tmpNode)) && p_space.PassesFilter(tmpNode, m_attributes.Get(tmpNode))), if (!p_query.AddPoint(tmpNode, gnode.distance)))
+                }
+                else
+                {
+                    Search(if ((p_searchDeleted || !m_deletedID.Contains(tmpNode)) && p_space.PassesFilter(tmpNode, m_attributes.Get(tmpNode))), p_query.AddPoint(tmpNode, gnode.distance);)
+                }
+            }
+            else if (m_deletedID.Count() == 0 || p_searchDeleted)
             {
                 if (p_searchDuplicated)
                 {
@@ -240,34 +421,286 @@ namespace SPTAG
             }
         }
 
+        template <typename T>
+        void Index<T>::SearchIndexGroup(COMMON::QueryResultSet<T>** p_queries, COMMON::WorkSpace** p_spaces, int p_count, const bool* p_searchDeleted) const
+        {
+            if (m_deletedID.Count() == 0)
+            {
+                SearchGroup(;, if (!p_query.AddPoint(tmpNode, gnode.distance)))
+            }
+            else
+            {
+                SearchGroup(if (p_searchDeleted[q] || !m_deletedID.Contains(tmpNode)), if (!p_query.AddPoint(tmpNode, gnode.distance)))
+            }
+        }
+
+        template <typename T>
+        template <typename Q>
+        void Index<T>::ScanAllowedIDs(Q &p_query, COMMON::WorkSpace &p_space, bool p_searchDeleted) const
+        {
+            for (SizeType id : *p_space.m_pAllowedIDs)
+            {
+                if (id < 0 || id >= GetNumSamples() || p_space.CheckAndSet(id)) continue;
+                if ((!p_searchDeleted && m_deletedID.Contains(id)) || !p_space.MatchesAttribute(m_attributes.Get(id)) || p_space.IsExcluded(id)) continue;
+
+                p_query.AddPoint(id, m_fComputeDistance(p_query.GetTarget(), m_pSamples[id], GetFeatureDim()));
+            }
+            p_query.SortResult();
+        }
+
+        template <typename T>
+        void Index<T>::SearchIndexIterative(COMMON::IterativeResultSet<T>& p_query, COMMON::WorkSpace& p_space, bool p_isFirst, int p_count, bool p_searchDeleted, std::vector<BasicResult>& p_results) const
+        {
+            std::shared_lock<std::shared_timed_mutex> lock(*(m_pTrees.m_lock));
+            p_query.StartPage(p_count);
+            if (p_isFirst)
+            {
+                // A short allowed list is scored up front, and there is no walk to continue.
+                if (p_space.ScanAllowedIDs())
+                {
+                    ScanAllowedIDs(p_query, p_space, p_searchDeleted);
+                }
+                else
+                {
+                    m_pTrees.InitSearchTrees(this, p_query, p_space);
+                    m_pTrees.SearchTrees(this, p_query, p_space, p_space.m_iNumberOfInitialDynamicPivots);
+                }
+            }
+
+            // Every node the walk takes joins the found vectors, for this page or a later one, and the walk runs
+            // on the full vectors. It stops like a K-NN search for the page: after ContinuousLimit nodes in a row
+            // farther than the page, or after MaxCheck more vectors. The node it stops on stays queued.
+            const DimensionType checkPos = m_pGraph.m_iNeighborhoodSize - 1;
+            const bool quantized = false;
+            const bool bounded = false;
+            const int maxCheck = p_space.m_iNumberOfCheckedLeaves + p_space.m_iMaxCheck;
+            int noBetter = 0;
+            while (!p_space.m_NGQueue.empty())
+            {
+                COMMON::HeapCell gnode = p_space.m_NGQueue.pop();
+                if (gnode.distance > p_query.PageWorstDist())
+                {
+                    if (++noBetter > p_space.m_iContinuousLimit || p_space.m_iNumberOfCheckedLeaves > maxCheck)
+                    {
+                        p_space.m_NGQueue.insert(gnode);
+                        break;
+                    }
+                }
+                else
+                {
+                    noBetter = 0;
+                }
+
+                SizeType tmpNode = gnode.node;
+                const SizeType *node = m_pGraph[tmpNode];
+                PrefetchNeighbors(node, quantized)
+                ExpandNode(if ((p_searchDeleted || !m_deletedID.Contains(tmpNode)) && (!p_space.m_bFiltered || p_space.PassesFilter(tmpNode, m_attributes.Get(tmpNode)))),
+                    if (!p_query.AddPoint(tmpNode, gnode.distance)),
+                    p_space.m_NGQueue.insert(gnode); break;)
+            }
+            p_query.EndPage(p_results);
+        }
+
+        template<typename T>
+        void Index<T>::RerankCandidates(COMMON::QueryResultSet<T>& p_candidates, QueryResult& p_query) const
+        {
+            const T* target = (const T*)p_query.GetTarget();
+            COMMON::QueryResultSet<T>& result = *((COMMON::QueryResultSet<T>*)&p_query);
+            for (int i = 0; i < p_candidates.GetResultNum(); i++)
+            {
+                SizeType vid = p_candidates.GetResult(i)->VID;
+                if (vid < 0) break;
+                result.AddPoint(vid, m_fComputeDistance(target, m_pSamples[vid], GetFeatureDim()));
+            }
+            result.SortResult();
+        }
+
+        template<typename T>
+        void Index<T>::ResetWorkSpace(COMMON::WorkSpace& p_space, const SearchOptions& p_options, int p_maxCheck) const
+        {
+            p_space.Reset((p_options.m_maxCheck >= 0) ? p_options.m_maxCheck : p_maxCheck, m_eVisitedTable);
+
+            // BKT gives up after MaxCheck / 64 visits in a row that did not improve the results.
+            if (p_options.m_continuousLimit >= 0) p_space.m_iContinuousLimit = p_options.m_continuousLimit;
+            p_space.m_iNumberOfInitialDynamicPivots = (p_options.m_initialDynamicPivots >= 0) ? p_options.m_initialDynamicPivots : m_iNumberOfInitialDynamicPivots;
+            p_space.m_iNumberOfOtherDynamicPivots = (p_options.m_otherDynamicPivots >= 0) ? p_options.m_otherDynamicPivots : m_iNumberOfOtherDynamicPivots;
+            p_space.SetDeadline(p_options.m_deadline);
+            p_space.SetFilter(p_options.m_attributeMask, p_options.m_attributeValue, p_options.m_allowedIDs.get(), p_options.m_excludedIDs.get(), GetNumSamples());
+        }
+
+        template<typename T>
+        void Index<T>::FinishSearch(COMMON::WorkSpace& p_space, QueryResult& p_query) const
+        {
+            m_iBoundedDistances += p_space.m_iNumberOfBoundedDistances;
+            m_iAbandonedDistances += p_space.m_iNumberOfAbandonedDistances;
+            p_query.SetCutShort(p_space.m_bCutShort);
+
+            if (p_query.WithMeta() && nullptr != m_pMetadata)
+            {
+                for (int i = 0; i < p_query.GetResultNum(); ++i)
+                {
+                    SizeType result = p_query.GetResult(i)->VID;
+                    p_query.SetMetadata(i, (result < 0) ? ByteArray::c_empty : m_pMetadata->GetMetadata(result));
+                }
+            }
+        }
+
         template<typename T>
         ErrorCode Index<T>::SearchIndex(QueryResult &p_query, bool p_searchDeleted) const
         {
             if (!m_bReady) return ErrorCode::EmptyIndex;
 
             auto workSpace = m_workSpacePool->Rent();
-            workSpace->Reset(m_iMaxCheck);
+            ResetWorkSpace(*workSpace, p_query.GetOptions(), m_iMaxCheck);
+            p_searchDeleted = p_searchDeleted || p_query.GetOptions().m_searchDeleted;
+
+            if (p_query.GetOptions().m_distinctByMetadata && m_pMetadata != nullptr)
+            {
+                // Near duplicates usually differ by less than the quantization error, so the quantized distances
+                // would often keep the wrong vector of a metadata value; the search runs on the full vectors.
+                COMMON::DistinctResultSet<T> results((const T*)p_query.GetTarget(), p_query.GetResultNum(), m_pMetadata.get());
+                SearchIndex(results, *workSpace, p_searchDeleted, true);
+                results.CopyTo(p_query);
+            }
+            else if (m_pQuantizer == nullptr)
+            {
+                SearchIndex(*((COMMON::QueryResultSet<T>*)&p_query), *workSpace, p_searchDeleted, true);
+            }
+            else
+            {
+                // Traverse on the quantized codes, then re-rank the candidates with full precision distances.
+                const T* target = (const T*)p_query.GetTarget();
+                m_pQuantizer->BuildQueryTable(target, workSpace->PrepareQuantizedQuery(m_pQuantizer->GetQueryTableSize()));
+
+                COMMON::QueryResultSet<T> candidates(target, p_query.GetResultNum() * max(m_iRerankFactor, 1));
+                SearchIndex(candidates, *workSpace, p_searchDeleted, true);
+                RerankCandidates(candidates, p_query);
+            }
+
+            FinishSearch(*workSpace, p_query);
+            m_workSpacePool->Return(workSpace);
+            return ErrorCode::Success;
+        }
+
+        template<typename T>
+        ErrorCode Index<T>::SearchIndexWithinRadius(QueryResult &p_query, float p_radius, bool p_searchDeleted) const
+        {
+            if (!m_bReady) return ErrorCode::EmptyIndex;
+
+            auto workSpace = m_workSpacePool->Rent();
+            ResetWorkSpace(*workSpace, p_query.GetOptions(), m_iMaxCheck);
+            p_searchDeleted = p_searchDeleted || p_query.GetOptions().m_searchDeleted;
 
-            SearchIndex(*((COMMON::QueryResultSet<T>*)&p_query), *workSpace, p_searchDeleted, true);
+            // A node joins the results as soon as it is within the radius, so the search always runs on the full
+            // vectors, even with a quantizer. It stops after MaxCheck or once it keeps popping nodes outside the radius.
+            COMMON::RadiusResultSet<T> results((const T*)p_query.GetTarget(), p_radius);
+            SearchIndex(results, *workSpace, p_searchDeleted, true);
 
+            const std::vector<BasicResult>& found = results.GetResults();
+            p_query.Init(p_query.GetTarget(), static_cast<int>(found.size()), p_query.WithMeta());
+            for (int i = 0; i < static_cast<int>(found.size()); i++) p_query.SetResult(i, found[i].VID, found[i].Dist);
+
+            FinishSearch(*workSpace, p_query);
             m_workSpacePool->Return(workSpace);
+            return ErrorCode::Success;
+        }
 
-            if (p_query.WithMeta() && nullptr != m_pMetadata)
+        template<typename T>
+        std::shared_ptr<ResultIterator> Index<T>::GetIterator(const void* p_target, const SearchOptions& p_options) const
+        {
+            if (!m_bReady) return nullptr;
+
+            auto workSpace = m_workSpacePool->Rent();
+            ResetWorkSpace(*workSpace, p_options, m_iMaxCheck);
+            // The pages together can visit far more vectors than the hash table is sized for.
+            workSpace->UseEpochVisitedTable();
+            return std::make_shared<COMMON::IndexResultIterator<T, Index<T>>>(this, m_workSpacePool.get(), workSpace, (const T*)p_target, p_options.m_searchDeleted);
+        }
+
+        template<typename T>
+        ErrorCode Index<T>::SearchIndexGroup(QueryResult** p_queries, int p_queryCount, bool p_searchDeleted) const
+        {
+            if (!m_bReady) return ErrorCode::EmptyIndex;
+
+            // The group walk does not check filters or metadata; such queries are searched one by one.
+            for (int i = 0; i < p_queryCount; i++)
             {
-                for (int i = 0; i < p_query.GetResultNum(); ++i)
+                const SearchOptions& options = p_queries[i]->GetOptions();
+                if (options.HasFilter() || options.m_distinctByMetadata) return VectorIndex::SearchIndexGroup(p_queries, p_queryCount, p_searchDeleted);
+            }
+
+            const int groupSize = max(m_iSearchGroupSize, 1);
+            std::vector<std::shared_ptr<COMMON::WorkSpace>> workSpaces(groupSize);
+            std::vector<COMMON::WorkSpace*> spaces(groupSize);
+            std::vector<COMMON::QueryResultSet<T>*> queries(groupSize);
+            std::vector<std::unique_ptr<COMMON::QueryResultSet<T>>> candidates(groupSize);
+            std::unique_ptr<bool[]> searchDeleted(new bool[groupSize]);
+            for (int begin = 0; begin < p_queryCount; begin += groupSize)
+            {
+                int count = min(groupSize, p_queryCount - begin);
+                for (int i = 0; i < count; i++)
                 {
-                    SizeType result = p_query.GetResult(i)->VID;
-                    p_query.SetMetadata(i, (result < 0) ? ByteArray::c_empty : m_pMetadata->GetMetadata(result));
+                    QueryResult& query = *p_queries[begin + i];
+                    workSpaces[i] = m_workSpacePool->Rent();
+                    ResetWorkSpace(*workSpaces[i], query.GetOptions(), m_iMaxCheck);
+                    searchDeleted[i] = p_searchDeleted || query.GetOptions().m_searchDeleted;
+                    spaces[i] = workSpaces[i].get();
+                    if (m_pQuantizer == nullptr)
+                    {
+                        queries[i] = (COMMON::QueryResultSet<T>*)&query;
+                    }
+                    else
+                    {
+                        const T* target = (const T*)query.GetTarget();
+                        m_pQuantizer->BuildQueryTable(target, workSpaces[i]->PrepareQuantizedQuery(m_pQuantizer->GetQueryTableSize()));
+                        candidates[i].reset(new COMMON::QueryResultSet<T>(target, query.GetResultNum() * max(m_iRerankFactor, 1)));
+                        queries[i] = candidates[i].get();
+                    }
+                }
+
+                SearchIndexGroup(queries.data(), spaces.data(), count, searchDeleted.get());
+
+                for (int i = 0; i < count; i++)
+                {
+                    QueryResult& query = *p_queries[begin + i];
+                    if (m_pQuantizer != nullptr) RerankCandidates(*candidates[i], query);
+                    FinishSearch(*workSpaces[i], query);
+                    m_workSpacePool->Return(workSpaces[i]);
                 }
             }
             return ErrorCode::Success;
         }
 
+        template<typename T>
+        ErrorCode Index<T>::SearchIndex(const void* p_vector, int p_vectorCount, int p_neighborCount, bool p_withMeta, BasicResult* p_results) const
+        {
+            if (!m_bReady) return ErrorCode::EmptyIndex;
+            if (m_iSearchGroupSize <= 1) return VectorIndex::SearchIndex(p_vector, p_vectorCount, p_neighborCount, p_withMeta, p_results);
+
+            const std::size_t vectorSize = sizeof(T) * GetFeatureDim();
+            const int groupCount = (p_vectorCount + m_iSearchGroupSize - 1) / m_iSearchGroupSize;
+#pragma omp parallel for schedule(dynamic)
+            for (int g = 0; g < groupCount; g++)
+            {
+                int begin = g * m_iSearchGroupSize;
+                int count = min(m_iSearchGroupSize, p_vectorCount - begin);
+                std::vector<std::unique_ptr<QueryResult>> results(count);
+                std::vector<QueryResult*> queries(count);
+                for (int i = 0; i < count; i++)
+                {
+                    results[i].reset(new QueryResult((const char*)p_vector + (begin + i) * vectorSize, p_neighborCount, p_withMeta, p_results + (begin + i) * p_neighborCount));
+                    queries[i] = results[i].get();
+                }
+                SearchIndexGroup(queries.data(), count);
+            }
+            return ErrorCode::Success;
+        }
+
         template<typename T>
         ErrorCode Index<T>::RefineSearchIndex(QueryResult &p_query, bool p_searchDeleted) const
         {
             auto workSpace = m_workSpacePool->Rent();
-            workSpace->Reset(m_pGraph.m_iMaxCheckForRefineGraph);
+            ResetWorkSpace(*workSpace, p_query.GetOptions(), m_pGraph.m_iMaxCheckForRefineGraph);
 
             SearchIndex(*((COMMON::QueryResultSet<T>*)&p_query), *workSpace, p_searchDeleted, false);
 
@@ -285,6 +718,8 @@ namespace SPTAG
 
             m_pSamples.Initialize(p_vectorNum, p_dimension, (T*)p_data, false);
             m_deletedID.Initialize(p_vectorNum);
+            m_attributes.Initialize(p_vectorNum);
+            SelectDistanceKernels();
 
             if (DistCalcMethod::Cosine == m_iDistCalcMethod)
             {
@@ -294,6 +729,11 @@ namespace SPTAG
                     COMMON::Utils::Normalize(m_pSamples[i], GetFeatureDim(), base);
                 }
             }
+            if (KeepsSampleNorms())
+            {
+                m_pSampleNorms.Initialize(p_vectorNum, 1);
+                ComputeSampleNorms(0, p_vectorNum);
+            }
 
             m_workSpacePool.reset(new COMMON::WorkSpacePool(max(m_iMaxCheck, m_pGraph.m_iMaxCheckForRefineGraph), GetNumSamples()));
             m_workSpacePool->Init(m_iNumberOfThreads);
@@ -301,10 +741,120 @@ namespace SPTAG
 
             m_pTrees.BuildTrees<T>(this);
             m_pGraph.BuildGraph<T>(this, &(m_pTrees.GetSampleMap()));
+            if (m_bReorderVectors)
+            {
+                ErrorCode ret = ReorderVectors();
+                if (ErrorCode::Success != ret) return ret;
+            }
+            if (m_eQuantizerType != QuantizerType::None)
+            {
+                ErrorCode ret = TrainQuantizer();
+                if (ErrorCode::Success != ret) return ret;
+            }
             m_bReady = true;
             return ErrorCode::Success;
         }
 
+        template <typename T>
+        void Index<T>::ComputeSampleNorms(SizeType p_begin, SizeType p_end)
+        {
+#pragma omp parallel for
+            for (SizeType i = p_begin; i < p_end; i++) {
+                const T* v = m_pSamples[i];
+                *m_pSampleNorms[i] = sqrt(m_iBaseSquare - m_fComputeDistance(v, v, GetFeatureDim()));
+            }
+        }
+
+        // Indexes saved before the norms were kept end right after the vectors; their norms are recomputed.
+        template <typename T>
+        bool Index<T>::LoadSampleNorms(std::ifstream& p_input)
+        {
+            if (!KeepsSampleNorms()) return true;
+
+            if (p_input.peek() != EOF && !m_pSampleNorms.Load(p_input)) return false;
+            if (m_pSampleNorms.R() != GetNumSamples() || m_pSampleNorms.C() != 1)
+            {
+                m_pSampleNorms.Initialize(GetNumSamples(), 1);
+                ComputeSampleNorms(0, GetNumSamples());
+            }
+            return true;
+        }
+
+        template <typename T>
+        bool Index<T>::LoadSampleNorms(const ByteArray& p_blob)
+        {
+            if (!KeepsSampleNorms()) return true;
+
+            std::uint64_t offset = m_pSamples.BufferSize();
+            std::uint64_t normSize = sizeof(SizeType) + sizeof(DimensionType) + sizeof(float) * GetNumSamples();
+            if (p_blob.Length() >= offset + normSize && !m_pSampleNorms.Load((char*)p_blob.Data() + offset)) return false;
+            if (m_pSampleNorms.R() != GetNumSamples() || m_pSampleNorms.C() != 1)
+            {
+                m_pSampleNorms.Initialize(GetNumSamples(), 1);
+                ComputeSampleNorms(0, GetNumSamples());
+            }
+            return true;
+        }
+
+        template <typename T>
+        std::shared_ptr<COMMON::IQuantizer<T>> Index<T>::CreateQuantizer() const
+        {
+            switch (m_eQuantizerType)
+            {
+            case QuantizerType::PQ:
+                return std::shared_ptr<COMMON::IQuantizer<T>>(new COMMON::PQQuantizer<T>(m_iDistCalcMethod, GetFeatureDim(), m_iPQSubvectors));
+            case QuantizerType::SQ8:
+                return std::shared_ptr<COMMON::IQuantizer<T>>(new COMMON::SQ8Quantizer<T>(m_iDistCalcMethod, GetFeatureDim()));
+            default:
+                break;
+            }
+            return nullptr;
+        }
+
+        template <typename T>
+        ErrorCode Index<T>::TrainQuantizer()
+        {
+            std::shared_ptr<COMMON::IQuantizer<T>> quantizer = CreateQuantizer();
+            if (quantizer == nullptr) return ErrorCode::Fail;
+
+            ErrorCode ret = quantizer->Train(m_pSamples, m_iQuantizerSamples, m_iNumberOfThreads);
+            if (ErrorCode::Success != ret) return ret;
+
+            m_pQuantizedSamples.Initialize(GetNumSamples(), quantizer->GetCodeSize());
+#pragma omp parallel for
+            for (SizeType i = 0; i < GetNumSamples(); i++) {
+                quantizer->Encode(m_pSamples[i], m_pQuantizedSamples[i]);
+            }
+            m_pQuantizer = quantizer;
+            return ErrorCode::Success;
+        }
+
+        // Nothing is deleted yet, so the deleted labels stay as they are.
+        template <typename T>
+        ErrorCode Index<T>::ReorderVectors()
+        {
+            std::vector<SizeType> indices;
+            m_pTrees.ClusterOrder(GetNumSamples(), indices);
+            std::vector<SizeType> reverseIndices(indices.size());
+            for (SizeType i = 0; i < (SizeType)indices.size(); i++) reverseIndices[indices[i]] = i;
+
+            if (false == m_pSamples.Permute(indices)) return ErrorCode::Fail;
+            if (KeepsSampleNorms() && false == m_pSampleNorms.Permute(indices)) return ErrorCode::Fail;
+            if (nullptr != m_pQuantizer && false == m_pQuantizedSamples.Permute(indices)) return ErrorCode::Fail;
+            if (false == m_attributes.Permute(indices)) return ErrorCode::Fail;
+            if (nullptr != m_pMetadata)
+            {
+                std::shared_ptr<MetadataSet> metadata;
+                if (ErrorCode::Success != m_pMetadata->RefineMetadata(indices, metadata)) return ErrorCode::Fail;
+                m_pMetadata = metadata;
+            }
+            m_pTrees.Renumber(reverseIndices);
+            if (false == m_pGraph.Permute(indices, reverseIndices)) return ErrorCode::Fail;
+
+            m_pOriginalIDs.Initialize((SizeType)indices.size(), 1, indices.data(), false);
+            return ErrorCode::Success;
+        }
+
         template <typename T>
         ErrorCode Index<T>::RefineIndex(std::shared_ptr<VectorIndex>& p_newIndex)
         {
@@ -345,12 +895,25 @@ namespace SPTAG
             ptr->m_threadPool.init();
 
             if (false == m_pSamples.Refine(indices, ptr->m_pSamples)) return ErrorCode::Fail;
+            ptr->SelectDistanceKernels();
+            if (KeepsSampleNorms() && false == m_pSampleNorms.Refine(indices, ptr->m_pSampleNorms)) return ErrorCode::Fail;
+            if (nullptr != m_pQuantizer)
+            {
+                ptr->m_pQuantizer = m_pQuantizer;
+                if (false == m_pQuantizedSamples.Refine(indices, ptr->m_pQuantizedSamples)) return ErrorCode::Fail;
+            }
             if (nullptr != m_pMetadata && ErrorCode::Success != m_pMetadata->RefineMetadata(indices, ptr->m_pMetadata)) return ErrorCode::Fail;
 
             ptr->m_deletedID.Initialize(newR);
+            if (false == m_attributes.Refine(indices, ptr->m_attributes)) return ErrorCode::Fail;
             COMMON::BKTree* newtree = &(ptr->m_pTrees);
             (*newtree).BuildTrees<T>(ptr);
             m_pGraph.RefineGraph<T>(this, indices, reverseIndices, nullptr, &(ptr->m_pGraph), &(ptr->m_pTrees.GetSampleMap()));
+            if (m_bReorderVectors)
+            {
+                ErrorCode ret = ptr->ReorderVectors();
+                if (ErrorCode::Success != ret) return ret;
+            }
             if (m_pMetaToVec != nullptr) ptr->BuildMetaMapping();
             ptr->m_bReady = true;
             return ErrorCode::Success;
@@ -382,11 +945,33 @@ namespace SPTAG
 
             std::cout << "Refine... from " << GetNumSamples() << "->" << newR << std::endl;
 
-            if (false == m_pSamples.Refine(indices, *p_indexStreams[0])) return ErrorCode::Fail;
-            if (nullptr != m_pMetadata && (p_indexStreams.size() < 6 || ErrorCode::Success != m_pMetadata->RefineMetadata(indices, *p_indexStreams[4], *p_indexStreams[5]))) return ErrorCode::Fail;
-
             COMMON::BKTree newTrees(m_pTrees);
             newTrees.BuildTrees<T>(this, &indices, &reverseIndices);
+
+            // The cluster order of the new trees goes on top of the refine renumbering.
+            std::vector<SizeType> order;
+            if (m_bReorderVectors)
+            {
+                newTrees.ClusterOrder(newR, order);
+                std::vector<SizeType> clusterIndices(newR), treeIndices(newR);
+                for (SizeType i = 0; i < newR; i++) {
+                    clusterIndices[i] = indices[order[i]];
+                    treeIndices[order[i]] = i;
+                    reverseIndices[clusterIndices[i]] = i;
+                }
+                newTrees.Renumber(treeIndices);
+                indices.swap(clusterIndices);
+            }
+
+            // Metadata streams always come last, after the optional quantizer and original id streams.
+            size_t originalIDStream = (nullptr != m_pQuantizer) ? 5 : 4;
+            size_t indexStreamNum = originalIDStream + (m_bReorderVectors ? 1 : 0);
+            if (p_indexStreams.size() < indexStreamNum) return ErrorCode::LackOfInputs;
+            if (false == m_pSamples.Refine(indices, *p_indexStreams[0])) return ErrorCode::Fail;
+            if (KeepsSampleNorms() && false == m_pSampleNorms.Refine(indices, *p_indexStreams[0])) return ErrorCode::Fail;
+            if (nullptr != m_pQuantizer && (p_indexStreams.size() < indexStreamNum || !m_pQuantizer->Save(*p_indexStreams[4]) || false == m_pQuantizedSamples.Refine(indices, *p_indexStreams[4]))) return ErrorCode::Fail;
+            if (nullptr != m_pMetadata && (p_indexStreams.size() < indexStreamNum + 2 || ErrorCode::Success != m_pMetadata->RefineMetadata(indices, *p_indexStreams[indexStreamNum], *p_indexStreams[indexStreamNum + 1]))) return ErrorCode::Fail;
+
             newTrees.SaveTrees(*p_indexStreams[1]);
 
             m_pGraph.RefineGraph<T>(this, indices, reverseIndices, p_indexStreams[2], nullptr, &(newTrees.GetSampleMap()));
@@ -394,6 +979,12 @@ namespace SPTAG
             COMMON::Labelset newDeletedID;
             newDeletedID.Initialize(newR);
             newDeletedID.Save(*p_indexStreams[3]);
+            if (false == m_attributes.Refine(indices, *p_indexStreams[3])) return ErrorCode::Fail;
+            if (m_bReorderVectors)
+            {
+                COMMON::Dataset<SizeType> originalIDs(newR, 1, order.data(), false);
+                if (false == originalIDs.Save(*p_indexStreams[originalIDStream])) return ErrorCode::Fail;
+            }
             return ErrorCode::Success;
         }
 
@@ -416,6 +1007,14 @@ namespace SPTAG
             streams.push_back(new std::ofstream(folderPath + m_sBKTFilename, std::ios::binary));
             streams.push_back(new std::ofstream(folderPath + m_sGraphFilename, std::ios::binary));
             streams.push_back(new std::ofstream(folderPath + m_sDeleteDataPointsFilename, std::ios::binary));
+            if (nullptr != m_pQuantizer)
+            {
+                streams.push_back(new std::ofstream(folderPath + m_sQuantizerFilename, std::ios::binary));
+            }
+            if (m_bReorderVectors)
+            {
+                streams.push_back(new std::ofstream(folderPath + m_sOriginalIDFilename, std::ios::binary));
+            }
             if (nullptr != m_pMetadata)
             {
                 streams.push_back(new std::ofstream(folderPath + m_sMetadataFile, std::ios::binary));
@@ -459,6 +1058,16 @@ namespace SPTAG
             return ErrorCode::VectorNotFound;
         }
 
+        template <typename T>
+        ErrorCode Index<T>::SetAttribute(const SizeType idx, std::uint64_t p_attribute)
+        {
+            std::lock_guard<std::mutex> lock(m_dataAddLock);
+            if (idx < 0 || idx >= GetNumSamples()) return ErrorCode::VectorNotFound;
+
+            m_attributes.Set(idx, p_attribute);
+            return ErrorCode::Success;
+        }
+
         template <typename T>
         ErrorCode Index<T>::AddIndex(const void* p_data, SizeType p_vectorNum, DimensionType p_dimension, std::shared_ptr<MetadataSet> p_metadataSet, bool p_withMetaIndex)
         {
@@ -473,8 +1082,9 @@ namespace SPTAG
                 end = begin + p_vectorNum;
 
                 if (begin == 0) {
-                    if ((ret = BuildIndex(p_data, p_vectorNum, p_dimension)) != ErrorCode::Success) return ret;
+                    // Set before the build, which may renumber the vectors along with their metadata.
                     m_pMetadata = std::move(p_metadataSet);
+                    if ((ret = BuildIndex(p_data, p_vectorNum, p_dimension)) != ErrorCode::Success) return ret;
                     if (p_withMetaIndex && m_pMetadata != nullptr)
                     {
                         BuildMetaMapping();
@@ -486,11 +1096,17 @@ namespace SPTAG
 
                 if (m_pSamples.AddBatch((const T*)p_data, p_vectorNum) != ErrorCode::Success || 
                     m_pGraph.AddBatch(p_vectorNum) != ErrorCode::Success || 
-                    m_deletedID.AddBatch(p_vectorNum) != ErrorCode::Success) {
+                    m_deletedID.AddBatch(p_vectorNum) != ErrorCode::Success ||
+                    m_attributes.AddBatch(p_vectorNum) != ErrorCode::Success ||
+                    (KeepsSampleNorms() && m_pSampleNorms.AddBatch(p_vectorNum) != ErrorCode::Success) ||
+                    (m_pQuantizer != nullptr && m_pQuantizedSamples.AddBatch(p_vectorNum) != ErrorCode::Success)) {
                     std::cout << "Memory Error: Cannot alloc space for vectors" << std::endl;
                     m_pSamples.SetR(begin);
                     m_pGraph.SetR(begin);
                     m_deletedID.SetR(begin);
+                    m_attributes.SetR(begin);
+                    if (KeepsSampleNorms()) m_pSampleNorms.SetR(begin);
+                    if (m_pQuantizer != nullptr) m_pQuantizedSamples.SetR(begin);
                     return ErrorCode::MemoryOverFlow;
                 }
                 if (DistCalcMethod::Cosine == m_iDistCalcMethod)
@@ -499,6 +1115,13 @@ namespace SPTAG
                     for (SizeType i = begin; i < end; i++) {
                         COMMON::Utils::Normalize((T*)m_pSamples[i], GetFeatureDim(), base);
                     }
+                    ComputeSampleNorms(begin, end);
+                }
+                if (m_pQuantizer != nullptr)
+                {
+                    for (SizeType i = begin; i < end; i++) {
+                        m_pQuantizer->Encode(m_pSamples[i], m_pQuantizedSamples[i]);
+                    }
                 }
 
                 if (m_pMetadata != nullptr) {
@@ -548,8 +1171,8 @@ namespace SPTAG
 #include "inc/Core/BKT/ParameterDefinitionList.h"
 #undef DefineBKTParameter
 
-            m_fComputeDistance = COMMON::DistanceCalcSelector<T>(m_iDistCalcMethod);
-            m_iBaseSquare = (m_iDistCalcMethod == DistCalcMethod::Cosine) ? COMMON::Utils::GetBase<T>() * COMMON::Utils::GetBase<T>() : 1;
+            SelectDistanceKernels();
+            m_iBaseSquare = (m_iDistCalcMethod == DistCalcMethod::Cosine || m_iDistCalcMethod == DistCalcMethod::InnerProduct) ? COMMON::Utils::GetBase<T>() * COMMON::Utils::GetBase<T>() : 1;
             return ErrorCode::Success;
         }
 
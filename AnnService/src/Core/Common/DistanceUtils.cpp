@@ -0,0 +1,1461 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "inc/Core/Common/DistanceUtils.h"
+
+#include <immintrin.h>
+#include <cstring>
+
+using namespace SPTAG;
+using namespace SPTAG::COMMON;
+
+#ifndef _MSC_VER
+#define DIFF128 diff128
+#define DIFF256 diff256
+#else
+#define DIFF128 diff128.m128_f32
+#define DIFF256 diff256.m256_f32
+#endif
+
+#define REPEAT(type, ctype, delta, load, exec, acc, result) \
+            { \
+                type c1 = load((ctype *)(pX)); \
+                type c2 = load((ctype *)(pY)); \
+                pX += delta; pY += delta; \
+                result = acc(result, exec(c1, c2)); \
+            } \
+
+namespace
+{
+    // SSE2 is part of the x86-64 baseline, so these need no target attribute.
+    inline __m128 _mm_mul_epi8(__m128i X, __m128i Y)
+    {
+        __m128i zero = _mm_setzero_si128();
+
+        __m128i sign_x = _mm_cmplt_epi8(X, zero);
+        __m128i sign_y = _mm_cmplt_epi8(Y, zero);
+
+        __m128i xlo = _mm_unpacklo_epi8(X, sign_x);
+        __m128i xhi = _mm_unpackhi_epi8(X, sign_x);
+        __m128i ylo = _mm_unpacklo_epi8(Y, sign_y);
+        __m128i yhi = _mm_unpackhi_epi8(Y, sign_y);
+
+        return _mm_cvtepi32_ps(_mm_add_epi32(_mm_madd_epi16(xlo, ylo), _mm_madd_epi16(xhi, yhi)));
+    }
+
+    inline __m128 _mm_sqdf_epi8(__m128i X, __m128i Y)
+    {
+        __m128i zero = _mm_setzero_si128();
+
+        __m128i sign_x = _mm_cmplt_epi8(X, zero);
+        __m128i sign_y = _mm_cmplt_epi8(Y, zero);
+
+        __m128i xlo = _mm_unpacklo_epi8(X, sign_x);
+        __m128i xhi = _mm_unpackhi_epi8(X, sign_x);
+        __m128i ylo = _mm_unpacklo_epi8(Y, sign_y);
+        __m128i yhi = _mm_unpackhi_epi8(Y, sign_y);
+
+        __m128i dlo = _mm_sub_epi16(xlo, ylo);
+        __m128i dhi = _mm_sub_epi16(xhi, yhi);
+
+        return _mm_cvtepi32_ps(_mm_add_epi32(_mm_madd_epi16(dlo, dlo), _mm_madd_epi16(dhi, dhi)));
+    }
+
+    inline __m128 _mm_mul_epu8(__m128i X, __m128i Y)
+    {
+        __m128i zero = _mm_setzero_si128();
+
+        __m128i xlo = _mm_unpacklo_epi8(X, zero);
+        __m128i xhi = _mm_unpackhi_epi8(X, zero);
+        __m128i ylo = _mm_unpacklo_epi8(Y, zero);
+        __m128i yhi = _mm_unpackhi_epi8(Y, zero);
+
+        return _mm_cvtepi32_ps(_mm_add_epi32(_mm_madd_epi16(xlo, ylo), _mm_madd_epi16(xhi, yhi)));
+    }
+
+    inline __m128 _mm_sqdf_epu8(__m128i X, __m128i Y)
+    {
+        __m128i zero = _mm_setzero_si128();
+
+        __m128i xlo = _mm_unpacklo_epi8(X, zero);
+        __m128i xhi = _mm_unpackhi_epi8(X, zero);
+        __m128i ylo = _mm_unpacklo_epi8(Y, zero);
+        __m128i yhi = _mm_unpackhi_epi8(Y, zero);
+
+        __m128i dlo = _mm_sub_epi16(xlo, ylo);
+        __m128i dhi = _mm_sub_epi16(xhi, yhi);
+
+        return _mm_cvtepi32_ps(_mm_add_epi32(_mm_madd_epi16(dlo, dlo), _mm_madd_epi16(dhi, dhi)));
+    }
+
+    inline __m128 _mm_mul_epi16(__m128i X, __m128i Y)
+    {
+        return _mm_cvtepi32_ps(_mm_madd_epi16(X, Y));
+    }
+
+    inline __m128 _mm_sqdf_epi16(__m128i X, __m128i Y)
+    {
+        __m128i zero = _mm_setzero_si128();
+
+        __m128i sign_x = _mm_cmplt_epi16(X, zero);
+        __m128i sign_y = _mm_cmplt_epi16(Y, zero);
+
+        __m128i xlo = _mm_unpacklo_epi16(X, sign_x);
+        __m128i xhi = _mm_unpackhi_epi16(X, sign_x);
+        __m128i ylo = _mm_unpacklo_epi16(Y, sign_y);
+        __m128i yhi = _mm_unpackhi_epi16(Y, sign_y);
+
+        __m128 dlo = _mm_cvtepi32_ps(_mm_sub_epi32(xlo, ylo));
+        __m128 dhi = _mm_cvtepi32_ps(_mm_sub_epi32(xhi, yhi));
+
+        return _mm_add_ps(_mm_mul_ps(dlo, dlo), _mm_mul_ps(dhi, dhi));
+    }
+
+    inline __m128 _mm_sqdf_ps(__m128 X, __m128 Y)
+    {
+        __m128 d = _mm_sub_ps(X, Y);
+        return _mm_mul_ps(d, d);
+    }
+
+    SPTAG_TARGET_AVX2 inline __m256 _mm256_mul_epi8(__m256i X, __m256i Y)
+    {
+        __m256i zero = _mm256_setzero_si256();
+
+        __m256i sign_x = _mm256_cmpgt_epi8(zero, X);
+        __m256i sign_y = _mm256_cmpgt_epi8(zero, Y);
+
+        __m256i xlo = _mm256_unpacklo_epi8(X, sign_x);
+        __m256i xhi = _mm256_unpackhi_epi8(X, sign_x);
+        __m256i ylo = _mm256_unpacklo_epi8(Y, sign_y);
+        __m256i yhi = _mm256_unpackhi_epi8(Y, sign_y);
+
+        return _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_madd_epi16(xlo, ylo), _mm256_madd_epi16(xhi, yhi)));
+    }
+
+    SPTAG_TARGET_AVX2 inline __m256 _mm256_sqdf_epi8(__m256i X, __m256i Y)
+    {
+        __m256i zero = _mm256_setzero_si256();
+
+        __m256i sign_x = _mm256_cmpgt_epi8(zero, X);
+        __m256i sign_y = _mm256_cmpgt_epi8(zero, Y);
+
+        __m256i xlo = _mm256_unpacklo_epi8(X, sign_x);
+        __m256i xhi = _mm256_unpackhi_epi8(X, sign_x);
+        __m256i ylo = _mm256_unpacklo_epi8(Y, sign_y);
+        __m256i yhi = _mm256_unpackhi_epi8(Y, sign_y);
+
+        __m256i dlo = _mm256_sub_epi16(xlo, ylo);
+        __m256i dhi = _mm256_sub_epi16(xhi, yhi);
+
+        return _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_madd_epi16(dlo, dlo), _mm256_madd_epi16(dhi, dhi)));
+    }
+
+    SPTAG_TARGET_AVX2 inline __m256 _mm256_mul_epu8(__m256i X, __m256i Y)
+    {
+        __m256i zero = _mm256_setzero_si256();
+
+        __m256i xlo = _mm256_unpacklo_epi8(X, zero);
+        __m256i xhi = _mm256_unpackhi_epi8(X, zero);
+        __m256i ylo = _mm256_unpacklo_epi8(Y, zero);
+        __m256i yhi = _mm256_unpackhi_epi8(Y, zero);
+
+        return _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_madd_epi16(xlo, ylo), _mm256_madd_epi16(xhi, yhi)));
+    }
+
+    SPTAG_TARGET_AVX2 inline __m256 _mm256_sqdf_epu8(__m256i X, __m256i Y)
+    {
+        __m256i zero = _mm256_setzero_si256();
+
+        __m256i xlo = _mm256_unpacklo_epi8(X, zero);
+        __m256i xhi = _mm256_unpackhi_epi8(X, zero);
+        __m256i ylo = _mm256_unpacklo_epi8(Y, zero);
+        __m256i yhi = _mm256_unpackhi_epi8(Y, zero);
+
+        __m256i dlo = _mm256_sub_epi16(xlo, ylo);
+        __m256i dhi = _mm256_sub_epi16(xhi, yhi);
+
+        return _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_madd_epi16(dlo, dlo), _mm256_madd_epi16(dhi, dhi)));
+    }
+
+    SPTAG_TARGET_AVX2 inline __m256 _mm256_mul_epi16(__m256i X, __m256i Y)
+    {
+        return _mm256_cvtepi32_ps(_mm256_madd_epi16(X, Y));
+    }
+
+    SPTAG_TARGET_AVX2 inline __m256 _mm256_sqdf_epi16(__m256i X, __m256i Y)
+    {
+        __m256i zero = _mm256_setzero_si256();
+
+        __m256i sign_x = _mm256_cmpgt_epi16(zero, X);
+        __m256i sign_y = _mm256_cmpgt_epi16(zero, Y);
+
+        __m256i xlo = _mm256_unpacklo_epi16(X, sign_x);
+        __m256i xhi = _mm256_unpackhi_epi16(X, sign_x);
+        __m256i ylo = _mm256_unpacklo_epi16(Y, sign_y);
+        __m256i yhi = _mm256_unpackhi_epi16(Y, sign_y);
+
+        __m256 dlo = _mm256_cvtepi32_ps(_mm256_sub_epi32(xlo, ylo));
+        __m256 dhi = _mm256_cvtepi32_ps(_mm256_sub_epi32(xhi, yhi));
+
+        return _mm256_add_ps(_mm256_mul_ps(dlo, dlo), _mm256_mul_ps(dhi, dhi));
+    }
+
+    SPTAG_TARGET_AVX inline __m256 _mm256_sqdf_ps(__m256 X, __m256 Y)
+    {
+        __m256 d = _mm256_sub_ps(X, Y);
+        return _mm256_mul_ps(d, d);
+    }
+
+    // The AVX-512 integer kernels widen to 16 bits and accumulate in 32-bit lanes, which is exact
+    // for any dimension the index supports; the float conversion happens once per vector.
+    SPTAG_TARGET_AVX512 inline __m512i _mm512_loadu_epi8_epi16(const __m256i* p)
+    {
+        return _mm512_cvtepi8_epi16(_mm256_loadu_si256(p));
+    }
+
+    SPTAG_TARGET_AVX512 inline __m512i _mm512_loadu_epu8_epi16(const __m256i* p)
+    {
+        return _mm512_cvtepu8_epi16(_mm256_loadu_si256(p));
+    }
+
+    SPTAG_TARGET_AVX512 inline __m512i _mm512_maskz_loadu_epi8_epi16(std::int64_t rest, const void* p)
+    {
+        return _mm512_cvtepi8_epi16(_mm256_maskz_loadu_epi8((__mmask32)((1ULL << rest) - 1), p));
+    }
+
+    SPTAG_TARGET_AVX512 inline __m512i _mm512_maskz_loadu_epu8_epi16(std::int64_t rest, const void* p)
+    {
+        return _mm512_cvtepu8_epi16(_mm256_maskz_loadu_epi8((__mmask32)((1ULL << rest) - 1), p));
+    }
+
+    SPTAG_TARGET_AVX512 inline __m512i _mm512_sqdf_epi16(__m512i X, __m512i Y)
+    {
+        __m512i d = _mm512_sub_epi16(X, Y);
+        return _mm512_madd_epi16(d, d);
+    }
+
+    SPTAG_TARGET_AVX512 inline __m512 _mm512_sqdf_epi16_ps(__m256i X, __m256i Y)
+    {
+        __m512 d = _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_cvtepi16_epi32(X), _mm512_cvtepi16_epi32(Y)));
+        return _mm512_mul_ps(d, d);
+    }
+
+    SPTAG_TARGET_AVX512 inline __m512 _mm512_mul_epi16_ps(__m512i X, __m512i Y)
+    {
+        return _mm512_cvtepi32_ps(_mm512_madd_epi16(X, Y));
+    }
+
+    SPTAG_TARGET_AVX512 inline __m512 _mm512_sqdf_ps(__m512 X, __m512 Y)
+    {
+        __m512 d = _mm512_sub_ps(X, Y);
+        return _mm512_mul_ps(d, d);
+    }
+
+    SPTAG_TARGET_AVX512VNNI inline __m512i _mm512_sqdf_epi16_vnni(__m512i acc, __m512i X, __m512i Y)
+    {
+        __m512i d = _mm512_sub_epi16(X, Y);
+        return _mm512_dpwssd_epi32(acc, d, d);
+    }
+}
+
+#define L2_TAIL(T) \
+                while (pX < pEnd4) { \
+                    float c1 = ((float)(*pX++) - (float)(*pY++)); diff += c1 * c1; \
+                    c1 = ((float)(*pX++) - (float)(*pY++)); diff += c1 * c1; \
+                    c1 = ((float)(*pX++) - (float)(*pY++)); diff += c1 * c1; \
+                    c1 = ((float)(*pX++) - (float)(*pY++)); diff += c1 * c1; \
+                } \
+                while (pX < pEnd1) { \
+                    float c1 = ((float)(*pX++) - (float)(*pY++)); diff += c1 * c1; \
+                } \
+
+#define COSINE_TAIL(T) \
+                while (pX < pEnd4) \
+                { \
+                    float c1 = ((float)(*pX++) * (float)(*pY++)); diff += c1; \
+                    c1 = ((float)(*pX++) * (float)(*pY++)); diff += c1; \
+                    c1 = ((float)(*pX++) * (float)(*pY++)); diff += c1; \
+                    c1 = ((float)(*pX++) * (float)(*pY++)); diff += c1; \
+                } \
+                while (pX < pEnd1) diff += ((float)(*pX++) * (float)(*pY++)); \
+
+// Generates the 8-bit SSE2/AVX2 kernels; the two types differ only in sign handling.
+#define DefineByteKernels(T, Base, Suffix) \
+float DistanceUtils::ComputeL2Distance_SSE(const T* pX, const T* pY, DimensionType length) \
+{ \
+    const T* pEnd32 = pX + ((length >> 5) << 5); \
+    const T* pEnd16 = pX + ((length >> 4) << 4); \
+    const T* pEnd4 = pX + ((length >> 2) << 2); \
+    const T* pEnd1 = pX + length; \
+    __m128 diff128 = _mm_setzero_ps(); \
+    while (pX < pEnd32) { \
+        REPEAT(__m128i, __m128i, 16, _mm_loadu_si128, _mm_sqdf_##Suffix, _mm_add_ps, diff128) \
+        REPEAT(__m128i, __m128i, 16, _mm_loadu_si128, _mm_sqdf_##Suffix, _mm_add_ps, diff128) \
+    } \
+    while (pX < pEnd16) { \
+        REPEAT(__m128i, __m128i, 16, _mm_loadu_si128, _mm_sqdf_##Suffix, _mm_add_ps, diff128) \
+    } \
+    float diff = DIFF128[0] + DIFF128[1] + DIFF128[2] + DIFF128[3]; \
+    L2_TAIL(T) \
+    return diff; \
+} \
+\
+SPTAG_TARGET_AVX2 float DistanceUtils::ComputeL2Distance_AVX(const T* pX, const T* pY, DimensionType length) \
+{ \
+    const T* pEnd32 = pX + ((length >> 5) << 5); \
+    const T* pEnd16 = pX + ((length >> 4) << 4); \
+    const T* pEnd4 = pX + ((length >> 2) << 2); \
+    const T* pEnd1 = pX + length; \
+    __m256 diff256 = _mm256_setzero_ps(); \
+    while (pX < pEnd32) { \
+        REPEAT(__m256i, __m256i, 32, _mm256_loadu_si256, _mm256_sqdf_##Suffix, _mm256_add_ps, diff256) \
+    } \
+    __m128 diff128 = _mm_add_ps(_mm256_castps256_ps128(diff256), _mm256_extractf128_ps(diff256, 1)); \
+    while (pX < pEnd16) { \
+        REPEAT(__m128i, __m128i, 16, _mm_loadu_si128, _mm_sqdf_##Suffix, _mm_add_ps, diff128) \
+    } \
+    float diff = DIFF128[0] + DIFF128[1] + DIFF128[2] + DIFF128[3]; \
+    L2_TAIL(T) \
+    return diff; \
+} \
+\
+float DistanceUtils::ComputeCosineDistance_SSE(const T* pX, const T* pY, DimensionType length) \
+{ \
+    const T* pEnd32 = pX + ((length >> 5) << 5); \
+    const T* pEnd16 = pX + ((length >> 4) << 4); \
+    const T* pEnd4 = pX + ((length >> 2) << 2); \
+    const T* pEnd1 = pX + length; \
+    __m128 diff128 = _mm_setzero_ps(); \
+    while (pX < pEnd32) { \
+        REPEAT(__m128i, __m128i, 16, _mm_loadu_si128, _mm_mul_##Suffix, _mm_add_ps, diff128) \
+        REPEAT(__m128i, __m128i, 16, _mm_loadu_si128, _mm_mul_##Suffix, _mm_add_ps, diff128) \
+    } \
+    while (pX < pEnd16) { \
+        REPEAT(__m128i, __m128i, 16, _mm_loadu_si128, _mm_mul_##Suffix, _mm_add_ps, diff128) \
+    } \
+    float diff = DIFF128[0] + DIFF128[1] + DIFF128[2] + DIFF128[3]; \
+    COSINE_TAIL(T) \
+    return Base - diff; \
+} \
+\
+SPTAG_TARGET_AVX2 float DistanceUtils::ComputeCosineDistance_AVX(const T* pX, const T* pY, DimensionType length) \
+{ \
+    const T* pEnd32 = pX + ((length >> 5) << 5); \
+    const T* pEnd16 = pX + ((length >> 4) << 4); \
+    const T* pEnd4 = pX + ((length >> 2) << 2); \
+    const T* pEnd1 = pX + length; \
+    __m256 diff256 = _mm256_setzero_ps(); \
+    while (pX < pEnd32) { \
+        REPEAT(__m256i, __m256i, 32, _mm256_loadu_si256, _mm256_mul_##Suffix, _mm256_add_ps, diff256) \
+    } \
+    __m128 diff128 = _mm_add_ps(_mm256_castps256_ps128(diff256), _mm256_extractf128_ps(diff256, 1)); \
+    while (pX < pEnd16) { \
+        REPEAT(__m128i, __m128i, 16, _mm_loadu_si128, _mm_mul_##Suffix, _mm_add_ps, diff128) \
+    } \
+    float diff = DIFF128[0] + DIFF128[1] + DIFF128[2] + DIFF128[3]; \
+    COSINE_TAIL(T) \
+    return Base - diff; \
+} \
+\
+SPTAG_TARGET_AVX512 float DistanceUtils::ComputeL2Distance_AVX512(const T* pX, const T* pY, DimensionType length) \
+{ \
+    const T* pEnd32 = pX + ((length >> 5) << 5); \
+    const T* pEnd1 = pX + length; \
+    __m512i diff512 = _mm512_setzero_si512(); \
+    while (pX < pEnd32) { \
+        REPEAT(__m512i, __m256i, 32, _mm512_loadu_##Suffix##_epi16, _mm512_sqdf_epi16, _mm512_add_epi32, diff512) \
+    } \
+    if (pX < pEnd1) { \
+        __m512i c1 = _mm512_maskz_loadu_##Suffix##_epi16(pEnd1 - pX, pX); \
+        __m512i c2 = _mm512_maskz_loadu_##Suffix##_epi16(pEnd1 - pX, pY); \
+        diff512 = _mm512_add_epi32(diff512, _mm512_sqdf_epi16(c1, c2)); \
+    } \
+    return (float)_mm512_reduce_add_epi32(diff512); \
+} \
+\
+SPTAG_TARGET_AVX512VNNI float DistanceUtils::ComputeL2Distance_AVX512VNNI(const T* pX, const T* pY, DimensionType length) \
+{ \
+    const T* pEnd32 = pX + ((length >> 5) << 5); \
+    const T* pEnd1 = pX + length; \
+    __m512i diff512 = _mm512_setzero_si512(); \
+    while (pX < pEnd32) { \
+        __m512i c1 = _mm512_loadu_##Suffix##_epi16((const __m256i*)pX); \
+        __m512i c2 = _mm512_loadu_##Suffix##_epi16((const __m256i*)pY); \
+        pX += 32; pY += 32; \
+        diff512 = _mm512_sqdf_epi16_vnni(diff512, c1, c2); \
+    } \
+    if (pX < pEnd1) { \
+        __m512i c1 = _mm512_maskz_loadu_##Suffix##_epi16(pEnd1 - pX, pX); \
+        __m512i c2 = _mm512_maskz_loadu_##Suffix##_epi16(pEnd1 - pX, pY); \
+        diff512 = _mm512_sqdf_epi16_vnni(diff512, c1, c2); \
+    } \
+    return (float)_mm512_reduce_add_epi32(diff512); \
+} \
+\
+SPTAG_TARGET_AVX512 float DistanceUtils::ComputeCosineDistance_AVX512(const T* pX, const T* pY, DimensionType length) \
+{ \
+    const T* pEnd32 = pX + ((length >> 5) << 5); \
+    const T* pEnd1 = pX + length; \
+    __m512i diff512 = _mm512_setzero_si512(); \
+    while (pX < pEnd32) { \
+        REPEAT(__m512i, __m256i, 32, _mm512_loadu_##Suffix##_epi16, _mm512_madd_epi16, _mm512_add_epi32, diff512) \
+    } \
+    if (pX < pEnd1) { \
+        __m512i c1 = _mm512_maskz_loadu_##Suffix##_epi16(pEnd1 - pX, pX); \
+        __m512i c2 = _mm512_maskz_loadu_##Suffix##_epi16(pEnd1 - pX, pY); \
+        diff512 = _mm512_add_epi32(diff512, _mm512_madd_epi16(c1, c2)); \
+    } \
+    return Base - (float)_mm512_reduce_add_epi32(diff512); \
+} \
+\
+SPTAG_TARGET_AVX512VNNI float DistanceUtils::ComputeCosineDistance_AVX512VNNI(const T* pX, const T* pY, DimensionType length) \
+{ \
+    const T* pEnd32 = pX + ((length >> 5) << 5); \
+    const T* pEnd1 = pX + length; \
+    __m512i diff512 = _mm512_setzero_si512(); \
+    while (pX < pEnd32) { \
+        __m512i c1 = _mm512_loadu_##Suffix##_epi16((const __m256i*)pX); \
+        __m512i c2 = _mm512_loadu_##Suffix##_epi16((const __m256i*)pY); \
+        pX += 32; pY += 32; \
+        diff512 = _mm512_dpwssd_epi32(diff512, c1, c2); \
+    } \
+    if (pX < pEnd1) { \
+        __m512i c1 = _mm512_maskz_loadu_##Suffix##_epi16(pEnd1 - pX, pX); \
+        __m512i c2 = _mm512_maskz_loadu_##Suffix##_epi16(pEnd1 - pX, pY); \
+        diff512 = _mm512_dpwssd_epi32(diff512, c1, c2); \
+    } \
+    return Base - (float)_mm512_reduce_add_epi32(diff512); \
+} \
+
+DefineByteKernels(std::int8_t, 16129, epi8)
+DefineByteKernels(std::uint8_t, 65025, epu8)
+
+#undef DefineByteKernels
+
+float DistanceUtils::ComputeL2Distance_SSE(const std::int16_t* pX, const std::int16_t* pY, DimensionType length)
+{
+    const std::int16_t* pEnd16 = pX + ((length >> 4) << 4);
+    const std::int16_t* pEnd8 = pX + ((length >> 3) << 3);
+    const std::int16_t* pEnd4 = pX + ((length >> 2) << 2);
+    const std::int16_t* pEnd1 = pX + length;
+
+    __m128 diff128 = _mm_setzero_ps();
+    while (pX < pEnd16) {
+        REPEAT(__m128i, __m128i, 8, _mm_loadu_si128, _mm_sqdf_epi16, _mm_add_ps, diff128)
+        REPEAT(__m128i, __m128i, 8, _mm_loadu_si128, _mm_sqdf_epi16, _mm_add_ps, diff128)
+    }
+    while (pX < pEnd8) {
+        REPEAT(__m128i, __m128i, 8, _mm_loadu_si128, _mm_sqdf_epi16, _mm_add_ps, diff128)
+    }
+    float diff = DIFF128[0] + DIFF128[1] + DIFF128[2] + DIFF128[3];
+    L2_TAIL(std::int16_t)
+    return diff;
+}
+
+SPTAG_TARGET_AVX2 float DistanceUtils::ComputeL2Distance_AVX(const std::int16_t* pX, const std::int16_t* pY, DimensionType length)
+{
+    const std::int16_t* pEnd16 = pX + ((length >> 4) << 4);
+    const std::int16_t* pEnd8 = pX + ((length >> 3) << 3);
+    const std::int16_t* pEnd4 = pX + ((length >> 2) << 2);
+    const std::int16_t* pEnd1 = pX + length;
+
+    __m256 diff256 = _mm256_setzero_ps();
+    while (pX < pEnd16) {
+        REPEAT(__m256i, __m256i, 16, _mm256_loadu_si256, _mm256_sqdf_epi16, _mm256_add_ps, diff256)
+    }
+    __m128 diff128 = _mm_add_ps(_mm256_castps256_ps128(diff256), _mm256_extractf128_ps(diff256, 1));
+    while (pX < pEnd8) {
+        REPEAT(__m128i, __m128i, 8, _mm_loadu_si128, _mm_sqdf_epi16, _mm_add_ps, diff128)
+    }
+    float diff = DIFF128[0] + DIFF128[1] + DIFF128[2] + DIFF128[3];
+    L2_TAIL(std::int16_t)
+    return diff;
+}
+
+SPTAG_TARGET_AVX512 float DistanceUtils::ComputeL2Distance_AVX512(const std::int16_t* pX, const std::int16_t* pY, DimensionType length)
+{
+    const std::int16_t* pEnd16 = pX + ((length >> 4) << 4);
+    const std::int16_t* pEnd1 = pX + length;
+
+    __m512 diff512 = _mm512_setzero_ps();
+    while (pX < pEnd16) {
+        REPEAT(__m256i, __m256i, 16, _mm256_loadu_si256, _mm512_sqdf_epi16_ps, _mm512_add_ps, diff512)
+    }
+    if (pX < pEnd1) {
+        __mmask16 mask = (__mmask16)((1U << (pEnd1 - pX)) - 1);
+        __m256i c1 = _mm256_maskz_loadu_epi16(mask, pX);
+        __m256i c2 = _mm256_maskz_loadu_epi16(mask, pY);
+        diff512 = _mm512_add_ps(diff512, _mm512_sqdf_epi16_ps(c1, c2));
+    }
+    return _mm512_reduce_add_ps(diff512);
+}
+
+float DistanceUtils::ComputeCosineDistance_SSE(const std::int16_t* pX, const std::int16_t* pY, DimensionType length)
+{
+    const std::int16_t* pEnd16 = pX + ((length >> 4) << 4);
+    const std::int16_t* pEnd8 = pX + ((length >> 3) << 3);
+    const std::int16_t* pEnd4 = pX + ((length >> 2) << 2);
+    const std::int16_t* pEnd1 = pX + length;
+
+    __m128 diff128 = _mm_setzero_ps();
+    while (pX < pEnd16) {
+        REPEAT(__m128i, __m128i, 8, _mm_loadu_si128, _mm_mul_epi16, _mm_add_ps, diff128)
+        REPEAT(__m128i, __m128i, 8, _mm_loadu_si128, _mm_mul_epi16, _mm_add_ps, diff128)
+    }
+    while (pX < pEnd8) {
+        REPEAT(__m128i, __m128i, 8, _mm_loadu_si128, _mm_mul_epi16, _mm_add_ps, diff128)
+    }
+    float diff = DIFF128[0] + DIFF128[1] + DIFF128[2] + DIFF128[3];
+    COSINE_TAIL(std::int16_t)
+    return 1073676289 - diff;
+}
+
+SPTAG_TARGET_AVX2 float DistanceUtils::ComputeCosineDistance_AVX(const std::int16_t* pX, const std::int16_t* pY, DimensionType length)
+{
+    const std::int16_t* pEnd16 = pX + ((length >> 4) << 4);
+    const std::int16_t* pEnd8 = pX + ((length >> 3) << 3);
+    const std::int16_t* pEnd4 = pX + ((length >> 2) << 2);
+    const std::int16_t* pEnd1 = pX + length;
+
+    __m256 diff256 = _mm256_setzero_ps();
+    while (pX < pEnd16) {
+        REPEAT(__m256i, __m256i, 16, _mm256_loadu_si256, _mm256_mul_epi16, _mm256_add_ps, diff256)
+    }
+    __m128 diff128 = _mm_add_ps(_mm256_castps256_ps128(diff256), _mm256_extractf128_ps(diff256, 1));
+    while (pX < pEnd8) {
+        REPEAT(__m128i, __m128i, 8, _mm_loadu_si128, _mm_mul_epi16, _mm_add_ps, diff128)
+    }
+    float diff = DIFF128[0] + DIFF128[1] + DIFF128[2] + DIFF128[3];
+    COSINE_TAIL(std::int16_t)
+    return 1073676289 - diff;
+}
+
+SPTAG_TARGET_AVX512 float DistanceUtils::ComputeCosineDistance_AVX512(const std::int16_t* pX, const std::int16_t* pY, DimensionType length)
+{
+    const std::int16_t* pEnd32 = pX + ((length >> 5) << 5);
+    const std::int16_t* pEnd1 = pX + length;
+
+    __m512 diff512 = _mm512_setzero_ps();
+    while (pX < pEnd32) {
+        REPEAT(__m512i, void, 32, _mm512_loadu_si512, _mm512_mul_epi16_ps, _mm512_add_ps, diff512)
+    }
+    if (pX < pEnd1) {
+        __mmask32 mask = (__mmask32)((1ULL << (pEnd1 - pX)) - 1);
+        __m512i c1 = _mm512_maskz_loadu_epi16(mask, pX);
+        __m512i c2 = _mm512_maskz_loadu_epi16(mask, pY);
+        diff512 = _mm512_add_ps(diff512, _mm512_mul_epi16_ps(c1, c2));
+    }
+    return 1073676289 - _mm512_reduce_add_ps(diff512);
+}
+
+float DistanceUtils::ComputeL2Distance_SSE(const float* pX, const float* pY, DimensionType length)
+{
+    const float* pEnd16 = pX + ((length >> 4) << 4);
+    const float* pEnd4 = pX + ((length >> 2) << 2);
+    const float* pEnd1 = pX + length;
+
+    __m128 diff128 = _mm_setzero_ps();
+    while (pX < pEnd16)
+    {
+        REPEAT(__m128, const float, 4, _mm_loadu_ps, _mm_sqdf_ps, _mm_add_ps, diff128)
+        REPEAT(__m128, const float, 4, _mm_loadu_ps, _mm_sqdf_ps, _mm_add_ps, diff128)
+        REPEAT(__m128, const float, 4, _mm_loadu_ps, _mm_sqdf_ps, _mm_add_ps, diff128)
+        REPEAT(__m128, const float, 4, _mm_loadu_ps, _mm_sqdf_ps, _mm_add_ps, diff128)
+    }
+    while (pX < pEnd4)
+    {
+        REPEAT(__m128, const float, 4, _mm_loadu_ps, _mm_sqdf_ps, _mm_add_ps, diff128)
+    }
+    float diff = DIFF128[0] + DIFF128[1] + DIFF128[2] + DIFF128[3];
+
+    while (pX < pEnd1) {
+        float c1 = (*pX++) - (*pY++); diff += c1 * c1;
+    }
+    return diff;
+}
+
+SPTAG_TARGET_AVX float DistanceUtils::ComputeL2Distance_AVX(const float* pX, const float* pY, DimensionType length)
+{
+    const float* pEnd16 = pX + ((length >> 4) << 4);
+    const float* pEnd4 = pX + ((length >> 2) << 2);
+    const float* pEnd1 = pX + length;
+
+    __m256 diff256 = _mm256_setzero_ps();
+    while (pX < pEnd16)
+    {
+        REPEAT(__m256, const float, 8, _mm256_loadu_ps, _mm256_sqdf_ps, _mm256_add_ps, diff256)
+        REPEAT(__m256, const float, 8, _mm256_loadu_ps, _mm256_sqdf_ps, _mm256_add_ps, diff256)
+    }
+    __m128 diff128 = _mm_add_ps(_mm256_castps256_ps128(diff256), _mm256_extractf128_ps(diff256, 1));
+    while (pX < pEnd4)
+    {
+        REPEAT(__m128, const float, 4, _mm_loadu_ps, _mm_sqdf_ps, _mm_add_ps, diff128)
+    }
+    float diff = DIFF128[0] + DIFF128[1] + DIFF128[2] + DIFF128[3];
+
+    while (pX < pEnd1) {
+        float c1 = (*pX++) - (*pY++); diff += c1 * c1;
+    }
+    return diff;
+}
+
+SPTAG_TARGET_AVX512 float DistanceUtils::ComputeL2Distance_AVX512(const float* pX, const float* pY, DimensionType length)
+{
+    const float* pEnd32 = pX + ((length >> 5) << 5);
+    const float* pEnd16 = pX + ((length >> 4) << 4);
+    const float* pEnd1 = pX + length;
+
+    __m512 diff512 = _mm512_setzero_ps();
+    while (pX < pEnd32)
+    {
+        REPEAT(__m512, const float, 16, _mm512_loadu_ps, _mm512_sqdf_ps, _mm512_add_ps, diff512)
+        REPEAT(__m512, const float, 16, _mm512_loadu_ps, _mm512_sqdf_ps, _mm512_add_ps, diff512)
+    }
+    while (pX < pEnd16)
+    {
+        REPEAT(__m512, const float, 16, _mm512_loadu_ps, _mm512_sqdf_ps, _mm512_add_ps, diff512)
+    }
+    if (pX < pEnd1)
+    {
+        __mmask16 mask = (__mmask16)((1U << (pEnd1 - pX)) - 1);
+        diff512 = _mm512_add_ps(diff512, _mm512_sqdf_ps(_mm512_maskz_loadu_ps(mask, pX), _mm512_maskz_loadu_ps(mask, pY)));
+    }
+    return _mm512_reduce_add_ps(diff512);
+}
+
+float DistanceUtils::ComputeCosineDistance_SSE(const float* pX, const float* pY, DimensionType length)
+{
+    const float* pEnd16 = pX + ((length >> 4) << 4);
+    const float* pEnd4 = pX + ((length >> 2) << 2);
+    const float* pEnd1 = pX + length;
+
+    __m128 diff128 = _mm_setzero_ps();
+    while (pX < pEnd16)
+    {
+        REPEAT(__m128, const float, 4, _mm_loadu_ps, _mm_mul_ps, _mm_add_ps, diff128)
+        REPEAT(__m128, const float, 4, _mm_loadu_ps, _mm_mul_ps, _mm_add_ps, diff128)
+        REPEAT(__m128, const float, 4, _mm_loadu_ps, _mm_mul_ps, _mm_add_ps, diff128)
+        REPEAT(__m128, const float, 4, _mm_loadu_ps, _mm_mul_ps, _mm_add_ps, diff128)
+    }
+    while (pX < pEnd4)
+    {
+        REPEAT(__m128, const float, 4, _mm_loadu_ps, _mm_mul_ps, _mm_add_ps, diff128)
+    }
+    float diff = DIFF128[0] + DIFF128[1] + DIFF128[2] + DIFF128[3];
+
+    while (pX < pEnd1) diff += (*pX++) * (*pY++);
+    return 1 - diff;
+}
+
+SPTAG_TARGET_AVX float DistanceUtils::ComputeCosineDistance_AVX(const float* pX, const float* pY, DimensionType length)
+{
+    const float* pEnd16 = pX + ((length >> 4) << 4);
+    const float* pEnd4 = pX + ((length >> 2) << 2);
+    const float* pEnd1 = pX + length;
+
+    __m256 diff256 = _mm256_setzero_ps();
+    while (pX < pEnd16)
+    {
+        REPEAT(__m256, const float, 8, _mm256_loadu_ps, _mm256_mul_ps, _mm256_add_ps, diff256)
+        REPEAT(__m256, const float, 8, _mm256_loadu_ps, _mm256_mul_ps, _mm256_add_ps, diff256)
+    }
+    __m128 diff128 = _mm_add_ps(_mm256_castps256_ps128(diff256), _mm256_extractf128_ps(diff256, 1));
+    while (pX < pEnd4)
+    {
+        REPEAT(__m128, const float, 4, _mm_loadu_ps, _mm_mul_ps, _mm_add_ps, diff128)
+    }
+    float diff = DIFF128[0] + DIFF128[1] + DIFF128[2] + DIFF128[3];
+
+    while (pX < pEnd1) diff += (*pX++) * (*pY++);
+    return 1 - diff;
+}
+
+SPTAG_TARGET_AVX512 float DistanceUtils::ComputeCosineDistance_AVX512(const float* pX, const float* pY, DimensionType length)
+{
+    const float* pEnd32 = pX + ((length >> 5) << 5);
+    const float* pEnd16 = pX + ((length >> 4) << 4);
+    const float* pEnd1 = pX + length;
+
+    __m512 diff512 = _mm512_setzero_ps();
+    while (pX < pEnd32)
+    {
+        REPEAT(__m512, const float, 16, _mm512_loadu_ps, _mm512_mul_ps, _mm512_add_ps, diff512)
+        REPEAT(__m512, const float, 16, _mm512_loadu_ps, _mm512_mul_ps, _mm512_add_ps, diff512)
+    }
+    while (pX < pEnd16)
+    {
+        REPEAT(__m512, const float, 16, _mm512_loadu_ps, _mm512_mul_ps, _mm512_add_ps, diff512)
+    }
+    if (pX < pEnd1)
+    {
+        __mmask16 mask = (__mmask16)((1U << (pEnd1 - pX)) - 1);
+        diff512 = _mm512_add_ps(diff512, _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, pX), _mm512_maskz_loadu_ps(mask, pY)));
+    }
+    return 1 - _mm512_reduce_add_ps(diff512);
+}
+
+namespace
+{
+    // Per-(type, method, instruction set) building blocks for the batched kernels and the 16-bit float
+    // kernels. Load widens a chunk of Width elements into the working lane type, Step folds one chunk
+    // pair into an accumulator and Finish reduces the accumulator to the final distance. Merge adds two
+    // accumulators, for the types that have fixed dimension kernels.
+    inline float _mm_hsum_ps(__m128 X)
+    {
+        X = _mm_add_ps(X, _mm_movehl_ps(X, X));
+        X = _mm_add_ss(X, _mm_shuffle_ps(X, X, 1));
+        return _mm_cvtss_f32(X);
+    }
+
+    SPTAG_TARGET_AVX inline float _mm256_hsum_ps(__m256 X)
+    {
+        return _mm_hsum_ps(_mm_add_ps(_mm256_castps256_ps128(X), _mm256_extractf128_ps(X, 1)));
+    }
+
+    SPTAG_TARGET_AVX2 inline std::int32_t _mm256_hsum_epi32(__m256i X)
+    {
+        __m128i x = _mm_add_epi32(_mm256_castsi256_si128(X), _mm256_extracti128_si256(X, 1));
+        x = _mm_add_epi32(x, _mm_unpackhi_epi64(x, x));
+        x = _mm_add_epi32(x, _mm_shuffle_epi32(x, 1));
+        return _mm_cvtsi128_si32(x);
+    }
+
+    // There is no masked load below AVX-512, so the 256-bit tails go through a zero-padded copy.
+    // Zero lanes contribute nothing to either a squared difference or a dot product.
+    template<typename T, int Width>
+    struct TailBuffer
+    {
+        T data[Width];
+
+        TailBuffer(const T* p, DimensionType rest)
+        {
+            memset(data, 0, sizeof(data));
+            memcpy(data, p, sizeof(T) * rest);
+        }
+    };
+
+    // Baseline SSE2 has no half precision conversion, so Float16 widens element by element there.
+    struct Half128
+    {
+        typedef SPTAG::Float16 ValueType;
+        typedef __m128 Vec;
+        typedef __m128 Acc;
+        static const int Width = 4;
+
+        static inline Acc Zero() { return _mm_setzero_ps(); }
+        static inline Vec Load(const SPTAG::Float16* p) { return _mm_setr_ps(p[0], p[1], p[2], p[3]); }
+        static inline Vec LoadTail(const SPTAG::Float16* p, DimensionType rest) { TailBuffer<SPTAG::Float16, Width> b(p, rest); return Load(b.data); }
+    };
+
+    struct BHalf128
+    {
+        typedef SPTAG::BFloat16 ValueType;
+        typedef __m128 Vec;
+        typedef __m128 Acc;
+        static const int Width = 4;
+
+        static inline Acc Zero() { return _mm_setzero_ps(); }
+        static inline Vec Load(const SPTAG::BFloat16* p) { return _mm_castsi128_ps(_mm_unpacklo_epi16(_mm_setzero_si128(), _mm_loadl_epi64((const __m128i*)p))); }
+        static inline Vec LoadTail(const SPTAG::BFloat16* p, DimensionType rest) { TailBuffer<SPTAG::BFloat16, Width> b(p, rest); return Load(b.data); }
+    };
+
+    template<typename Loader>
+    struct L2Ps128 : Loader
+    {
+        typedef typename Loader::Vec Vec;
+        typedef typename Loader::Acc Acc;
+
+        static inline Acc Step(Acc acc, Vec q, Vec r) { return _mm_add_ps(acc, _mm_sqdf_ps(q, r)); }
+        static inline float Finish(Acc acc) { return _mm_hsum_ps(acc); }
+    };
+
+    template<typename Loader>
+    struct CosinePs128 : Loader
+    {
+        typedef typename Loader::Vec Vec;
+        typedef typename Loader::Acc Acc;
+
+        static inline Acc Step(Acc acc, Vec q, Vec r) { return _mm_add_ps(acc, _mm_mul_ps(q, r)); }
+        static inline float Finish(Acc acc) { return 1 - _mm_hsum_ps(acc); }
+    };
+
+    struct Float256
+    {
+        typedef float ValueType;
+        typedef __m256 Vec;
+        typedef __m256 Acc;
+        static const int Width = 8;
+
+        SPTAG_TARGET_AVX static inline Acc Zero() { return _mm256_setzero_ps(); }
+        SPTAG_TARGET_AVX static inline Vec Load(const float* p) { return _mm256_loadu_ps(p); }
+        SPTAG_TARGET_AVX static inline Vec LoadTail(const float* p, DimensionType rest) { TailBuffer<float, Width> b(p, rest); return Load(b.data); }
+        SPTAG_TARGET_AVX static inline Acc Merge(Acc a, Acc b) { return _mm256_add_ps(a, b); }
+    };
+
+    struct Half256
+    {
+        typedef SPTAG::Float16 ValueType;
+        typedef __m256 Vec;
+        typedef __m256 Acc;
+        static const int Width = 8;
+
+        SPTAG_TARGET_F16C static inline Acc Zero() { return _mm256_setzero_ps(); }
+        SPTAG_TARGET_F16C static inline Vec Load(const SPTAG::Float16* p) { return _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)p)); }
+        SPTAG_TARGET_F16C static inline Vec LoadTail(const SPTAG::Float16* p, DimensionType rest) { TailBuffer<SPTAG::Float16, Width> b(p, rest); return Load(b.data); }
+    };
+
+    // bfloat16 is the upper half of a float, so widening is a zero-extend and a shift.
+    struct BHalf256
+    {
+        typedef SPTAG::BFloat16 ValueType;
+        typedef __m256 Vec;
+        typedef __m256 Acc;
+        static const int Width = 8;
+
+        SPTAG_TARGET_AVX2 static inline Acc Zero() { return _mm256_setzero_ps(); }
+        SPTAG_TARGET_AVX2 static inline Vec Load(const SPTAG::BFloat16* p) { return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)p)), 16)); }
+        SPTAG_TARGET_AVX2 static inline Vec LoadTail(const SPTAG::BFloat16* p, DimensionType rest) { TailBuffer<SPTAG::BFloat16, Width> b(p, rest); return Load(b.data); }
+    };
+
+    // Float math shared by every type whose loader widens to packed floats.
+    template<typename Loader>
+    struct L2Ps256 : Loader
+    {
+        typedef typename Loader::Vec Vec;
+        typedef typename Loader::Acc Acc;
+
+        SPTAG_TARGET_AVX static inline Acc Step(Acc acc, Vec q, Vec r) { return _mm256_add_ps(acc, _mm256_sqdf_ps(q, r)); }
+        SPTAG_TARGET_AVX static inline float Finish(Acc acc) { return _mm256_hsum_ps(acc); }
+    };
+
+    template<typename Loader>
+    struct CosinePs256 : Loader
+    {
+        typedef typename Loader::Vec Vec;
+        typedef typename Loader::Acc Acc;
+
+        SPTAG_TARGET_AVX static inline Acc Step(Acc acc, Vec q, Vec r) { return _mm256_add_ps(acc, _mm256_mul_ps(q, r)); }
+        SPTAG_TARGET_AVX static inline float Finish(Acc acc) { return 1 - _mm256_hsum_ps(acc); }
+    };
+
+    template<typename T> struct Byte256;
+
+    template<>
+    struct Byte256<std::int8_t>
+    {
+        typedef std::int8_t ValueType;
+        typedef __m256i Vec;
+        typedef __m256i Acc;
+        static const int Width = 16;
+        static const int Base = 16129;
+
+        SPTAG_TARGET_AVX2 static inline Acc Zero() { return _mm256_setzero_si256(); }
+        SPTAG_TARGET_AVX2 static inline Vec Load(const std::int8_t* p) { return _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)p)); }
+        SPTAG_TARGET_AVX2 static inline Vec LoadTail(const std::int8_t* p, DimensionType rest) { TailBuffer<std::int8_t, Width> b(p, rest); return Load(b.data); }
+        SPTAG_TARGET_AVX2 static inline Acc Merge(Acc a, Acc b) { return _mm256_add_epi32(a, b); }
+    };
+
+    template<>
+    struct Byte256<std::uint8_t>
+    {
+        typedef std::uint8_t ValueType;
+        typedef __m256i Vec;
+        typedef __m256i Acc;
+        static const int Width = 16;
+        static const int Base = 65025;
+
+        SPTAG_TARGET_AVX2 static inline Acc Zero() { return _mm256_setzero_si256(); }
+        SPTAG_TARGET_AVX2 static inline Vec Load(const std::uint8_t* p) { return _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)p)); }
+        SPTAG_TARGET_AVX2 static inline Vec LoadTail(const std::uint8_t* p, DimensionType rest) { TailBuffer<std::uint8_t, Width> b(p, rest); return Load(b.data); }
+        SPTAG_TARGET_AVX2 static inline Acc Merge(Acc a, Acc b) { return _mm256_add_epi32(a, b); }
+    };
+
+    template<typename T>
+    struct L2Byte256 : Byte256<T>
+    {
+        typedef typename Byte256<T>::Vec Vec;
+        typedef typename Byte256<T>::Acc Acc;
+
+        SPTAG_TARGET_AVX2 static inline Acc Step(Acc acc, Vec q, Vec r) { __m256i d = _mm256_sub_epi16(q, r); return _mm256_add_epi32(acc, _mm256_madd_epi16(d, d)); }
+        SPTAG_TARGET_AVX2 static inline float Finish(Acc acc) { return (float)_mm256_hsum_epi32(acc); }
+    };
+
+    template<typename T>
+    struct CosineByte256 : Byte256<T>
+    {
+        typedef typename Byte256<T>::Vec Vec;
+        typedef typename Byte256<T>::Acc Acc;
+
+        SPTAG_TARGET_AVX2 static inline Acc Step(Acc acc, Vec q, Vec r) { return _mm256_add_epi32(acc, _mm256_madd_epi16(q, r)); }
+        SPTAG_TARGET_AVX2 static inline float Finish(Acc acc) { return Byte256<T>::Base - (float)_mm256_hsum_epi32(acc); }
+    };
+
+    // Differences of 16-bit values need 17 bits, so L2 widens to 32-bit lanes and squares in float.
+    struct L2Int16_256
+    {
+        typedef std::int16_t ValueType;
+        typedef __m256i Vec;
+        typedef __m256 Acc;
+        static const int Width = 8;
+
+        SPTAG_TARGET_AVX2 static inline Acc Zero() { return _mm256_setzero_ps(); }
+        SPTAG_TARGET_AVX2 static inline Vec Load(const std::int16_t* p) { return _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)p)); }
+        SPTAG_TARGET_AVX2 static inline Vec LoadTail(const std::int16_t* p, DimensionType rest) { TailBuffer<std::int16_t, Width> b(p, rest); return Load(b.data); }
+        SPTAG_TARGET_AVX2 static inline Acc Step(Acc acc, Vec q, Vec r) { __m256 d = _mm256_cvtepi32_ps(_mm256_sub_epi32(q, r)); return _mm256_add_ps(acc, _mm256_mul_ps(d, d)); }
+        SPTAG_TARGET_AVX2 static inline float Finish(Acc acc) { return _mm256_hsum_ps(acc); }
+    };
+
+    struct CosineInt16_256
+    {
+        typedef std::int16_t ValueType;
+        typedef __m256i Vec;
+        typedef __m256 Acc;
+        static const int Width = 16;
+
+        SPTAG_TARGET_AVX2 static inline Acc Zero() { return _mm256_setzero_ps(); }
+        SPTAG_TARGET_AVX2 static inline Vec Load(const std::int16_t* p) { return _mm256_loadu_si256((const __m256i*)p); }
+        SPTAG_TARGET_AVX2 static inline Vec LoadTail(const std::int16_t* p, DimensionType rest) { TailBuffer<std::int16_t, Width> b(p, rest); return Load(b.data); }
+        SPTAG_TARGET_AVX2 static inline Acc Step(Acc acc, Vec q, Vec r) { return _mm256_add_ps(acc, _mm256_mul_epi16(q, r)); }
+        SPTAG_TARGET_AVX2 static inline float Finish(Acc acc) { return 1073676289 - _mm256_hsum_ps(acc); }
+    };
+
+    struct Float512
+    {
+        typedef float ValueType;
+        typedef __m512 Vec;
+        typedef __m512 Acc;
+        static const int Width = 16;
+
+        SPTAG_TARGET_AVX512 static inline Acc Zero() { return _mm512_setzero_ps(); }
+        SPTAG_TARGET_AVX512 static inline Vec Load(const float* p) { return _mm512_loadu_ps(p); }
+        SPTAG_TARGET_AVX512 static inline Vec LoadTail(const float* p, DimensionType rest) { return _mm512_maskz_loadu_ps((__mmask16)((1U << rest) - 1), p); }
+        SPTAG_TARGET_AVX512 static inline Acc Merge(Acc a, Acc b) { return _mm512_add_ps(a, b); }
+    };
+
+    struct Half512
+    {
+        typedef SPTAG::Float16 ValueType;
+        typedef __m512 Vec;
+        typedef __m512 Acc;
+        static const int Width = 16;
+
+        SPTAG_TARGET_AVX512 static inline Acc Zero() { return _mm512_setzero_ps(); }
+        SPTAG_TARGET_AVX512 static inline Vec Load(const SPTAG::Float16* p) { return _mm512_cvtph_ps(_mm256_loadu_si256((const __m256i*)p)); }
+        SPTAG_TARGET_AVX512 static inline Vec LoadTail(const SPTAG::Float16* p, DimensionType rest) { return _mm512_cvtph_ps(_mm256_maskz_loadu_epi16((__mmask16)((1U << rest) - 1), p)); }
+    };
+
+    struct BHalf512
+    {
+        typedef SPTAG::BFloat16 ValueType;
+        typedef __m512 Vec;
+        typedef __m512 Acc;
+        static const int Width = 16;
+
+        SPTAG_TARGET_AVX512 static inline Acc Zero() { return _mm512_setzero_ps(); }
+        SPTAG_TARGET_AVX512 static inline Vec Load(const SPTAG::BFloat16* p) { return _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i*)p)), 16)); }
+        SPTAG_TARGET_AVX512 static inline Vec LoadTail(const SPTAG::BFloat16* p, DimensionType rest) { return _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_cvtepu16_epi32(_mm256_maskz_loadu_epi16((__mmask16)((1U << rest) - 1), p)), 16)); }
+    };
+
+    template<typename Loader>
+    struct L2Ps512 : Loader
+    {
+        typedef typename Loader::Vec Vec;
+        typedef typename Loader::Acc Acc;
+
+        SPTAG_TARGET_AVX512 static inline Acc Step(Acc acc, Vec q, Vec r) { __m512 d = _mm512_sub_ps(q, r); return _mm512_fmadd_ps(d, d, acc); }
+        SPTAG_TARGET_AVX512 static inline float Finish(Acc acc) { return _mm512_reduce_add_ps(acc); }
+    };
+
+    template<typename Loader>
+    struct CosinePs512 : Loader
+    {
+        typedef typename Loader::Vec Vec;
+        typedef typename Loader::Acc Acc;
+
+        SPTAG_TARGET_AVX512 static inline Acc Step(Acc acc, Vec q, Vec r) { return _mm512_fmadd_ps(q, r, acc); }
+        SPTAG_TARGET_AVX512 static inline float Finish(Acc acc) { return 1 - _mm512_reduce_add_ps(acc); }
+    };
+
+    template<typename T> struct Byte512;
+
+    template<>
+    struct Byte512<std::int8_t>
+    {
+        typedef std::int8_t ValueType;
+        typedef __m512i Vec;
+        typedef __m512i Acc;
+        static const int Width = 32;
+        static const int Base = 16129;
+
+        SPTAG_TARGET_AVX512 static inline Acc Zero() { return _mm512_setzero_si512(); }
+        SPTAG_TARGET_AVX512 static inline Vec Load(const std::int8_t* p) { return _mm512_loadu_epi8_epi16((const __m256i*)p); }
+        SPTAG_TARGET_AVX512 static inline Vec LoadTail(const std::int8_t* p, DimensionType rest) { return _mm512_maskz_loadu_epi8_epi16(rest, p); }
+        SPTAG_TARGET_AVX512 static inline Acc Merge(Acc a, Acc b) { return _mm512_add_epi32(a, b); }
+    };
+
+    template<>
+    struct Byte512<std::uint8_t>
+    {
+        typedef std::uint8_t ValueType;
+        typedef __m512i Vec;
+        typedef __m512i Acc;
+        static const int Width = 32;
+        static const int Base = 65025;
+
+        SPTAG_TARGET_AVX512 static inline Acc Zero() { return _mm512_setzero_si512(); }
+        SPTAG_TARGET_AVX512 static inline Vec Load(const std::uint8_t* p) { return _mm512_loadu_epu8_epi16((const __m256i*)p); }
+        SPTAG_TARGET_AVX512 static inline Vec LoadTail(const std::uint8_t* p, DimensionType rest) { return _mm512_maskz_loadu_epu8_epi16(rest, p); }
+        SPTAG_TARGET_AVX512 static inline Acc Merge(Acc a, Acc b) { return _mm512_add_epi32(a, b); }
+    };
+
+    template<typename T>
+    struct L2Byte512 : Byte512<T>
+    {
+        typedef typename Byte512<T>::Vec Vec;
+        typedef typename Byte512<T>::Acc Acc;
+
+        SPTAG_TARGET_AVX512 static inline Acc Step(Acc acc, Vec q, Vec r) { return _mm512_add_epi32(acc, _mm512_sqdf_epi16(q, r)); }
+        SPTAG_TARGET_AVX512 static inline float Finish(Acc acc) { return (float)_mm512_reduce_add_epi32(acc); }
+    };
+
+    template<typename T>
+    struct CosineByte512 : Byte512<T>
+    {
+        typedef typename Byte512<T>::Vec Vec;
+        typedef typename Byte512<T>::Acc Acc;
+
+        SPTAG_TARGET_AVX512 static inline Acc Step(Acc acc, Vec q, Vec r) { return _mm512_add_epi32(acc, _mm512_madd_epi16(q, r)); }
+        SPTAG_TARGET_AVX512 static inline float Finish(Acc acc) { return Byte512<T>::Base - (float)_mm512_reduce_add_epi32(acc); }
+    };
+
+    template<typename T>
+    struct L2Byte512VNNI : Byte512<T>
+    {
+        typedef typename Byte512<T>::Vec Vec;
+        typedef typename Byte512<T>::Acc Acc;
+
+        SPTAG_TARGET_AVX512VNNI static inline Acc Step(Acc acc, Vec q, Vec r) { return _mm512_sqdf_epi16_vnni(acc, q, r); }
+        SPTAG_TARGET_AVX512VNNI static inline float Finish(Acc acc) { return (float)_mm512_reduce_add_epi32(acc); }
+    };
+
+    template<typename T>
+    struct CosineByte512VNNI : Byte512<T>
+    {
+        typedef typename Byte512<T>::Vec Vec;
+        typedef typename Byte512<T>::Acc Acc;
+
+        SPTAG_TARGET_AVX512VNNI static inline Acc Step(Acc acc, Vec q, Vec r) { return _mm512_dpwssd_epi32(acc, q, r); }
+        SPTAG_TARGET_AVX512VNNI static inline float Finish(Acc acc) { return Byte512<T>::Base - (float)_mm512_reduce_add_epi32(acc); }
+    };
+
+    struct L2Int16_512
+    {
+        typedef std::int16_t ValueType;
+        typedef __m512i Vec;
+        typedef __m512 Acc;
+        static const int Width = 16;
+
+        SPTAG_TARGET_AVX512 static inline Acc Zero() { return _mm512_setzero_ps(); }
+        SPTAG_TARGET_AVX512 static inline Vec Load(const std::int16_t* p) { return _mm512_cvtepi16_epi32(_mm256_loadu_si256((const __m256i*)p)); }
+        SPTAG_TARGET_AVX512 static inline Vec LoadTail(const std::int16_t* p, DimensionType rest) { return _mm512_cvtepi16_epi32(_mm256_maskz_loadu_epi16((__mmask16)((1U << rest) - 1), p)); }
+        SPTAG_TARGET_AVX512 static inline Acc Step(Acc acc, Vec q, Vec r) { __m512 d = _mm512_cvtepi32_ps(_mm512_sub_epi32(q, r)); return _mm512_fmadd_ps(d, d, acc); }
+        SPTAG_TARGET_AVX512 static inline float Finish(Acc acc) { return _mm512_reduce_add_ps(acc); }
+    };
+
+    struct CosineInt16_512
+    {
+        typedef std::int16_t ValueType;
+        typedef __m512i Vec;
+        typedef __m512 Acc;
+        static const int Width = 32;
+
+        SPTAG_TARGET_AVX512 static inline Acc Zero() { return _mm512_setzero_ps(); }
+        SPTAG_TARGET_AVX512 static inline Vec Load(const std::int16_t* p) { return _mm512_loadu_si512(p); }
+        SPTAG_TARGET_AVX512 static inline Vec LoadTail(const std::int16_t* p, DimensionType rest) { return _mm512_maskz_loadu_epi16((__mmask32)((1ULL << rest) - 1), p); }
+        SPTAG_TARGET_AVX512 static inline Acc Step(Acc acc, Vec q, Vec r) { return _mm512_add_ps(acc, _mm512_mul_epi16_ps(q, r)); }
+        SPTAG_TARGET_AVX512 static inline float Finish(Acc acc) { return 1073676289 - _mm512_reduce_add_ps(acc); }
+    };
+}
+
+// Scores the rows in blocks of four: each query chunk is loaded once and applied to all four rows
+// with independent accumulators, which also hides the latency of the accumulate chain.
+#define DefineBatchKernel(Target, Name) \
+template<typename Ops> \
+Target inline void Name(const typename Ops::ValueType* pQuery, const typename Ops::ValueType* const* pRows, int count, DimensionType length, float* pResults) \
+{ \
+    typedef typename Ops::ValueType T; \
+    const DimensionType full = length - length % Ops::Width; \
+    const DimensionType rest = length - full; \
+    int r = 0; \
+    for (; r + 4 <= count; r += 4) { \
+        const T* p0 = pRows[r]; const T* p1 = pRows[r + 1]; const T* p2 = pRows[r + 2]; const T* p3 = pRows[r + 3]; \
+        typename Ops::Acc a0 = Ops::Zero(), a1 = Ops::Zero(), a2 = Ops::Zero(), a3 = Ops::Zero(); \
+        for (DimensionType d = 0; d < full; d += Ops::Width) { \
+            typename Ops::Vec q = Ops::Load(pQuery + d); \
+            a0 = Ops::Step(a0, q, Ops::Load(p0 + d)); \
+            a1 = Ops::Step(a1, q, Ops::Load(p1 + d)); \
+            a2 = Ops::Step(a2, q, Ops::Load(p2 + d)); \
+            a3 = Ops::Step(a3, q, Ops::Load(p3 + d)); \
+        } \
+        if (rest > 0) { \
+            typename Ops::Vec q = Ops::LoadTail(pQuery + full, rest); \
+            a0 = Ops::Step(a0, q, Ops::LoadTail(p0 + full, rest)); \
+            a1 = Ops::Step(a1, q, Ops::LoadTail(p1 + full, rest)); \
+            a2 = Ops::Step(a2, q, Ops::LoadTail(p2 + full, rest)); \
+            a3 = Ops::Step(a3, q, Ops::LoadTail(p3 + full, rest)); \
+        } \
+        pResults[r] = Ops::Finish(a0); \
+        pResults[r + 1] = Ops::Finish(a1); \
+        pResults[r + 2] = Ops::Finish(a2); \
+        pResults[r + 3] = Ops::Finish(a3); \
+    } \
+    for (; r < count; r++) { \
+        const T* p0 = pRows[r]; \
+        typename Ops::Acc a0 = Ops::Zero(); \
+        for (DimensionType d = 0; d < full; d += Ops::Width) { \
+            a0 = Ops::Step(a0, Ops::Load(pQuery + d), Ops::Load(p0 + d)); \
+        } \
+        if (rest > 0) { \
+            a0 = Ops::Step(a0, Ops::LoadTail(pQuery + full, rest), Ops::LoadTail(p0 + full, rest)); \
+        } \
+        pResults[r] = Ops::Finish(a0); \
+    } \
+} \
+
+DefineBatchKernel(SPTAG_TARGET_AVX, ComputeBatch_AVX)
+DefineBatchKernel(SPTAG_TARGET_AVX2, ComputeBatch_AVX2)
+DefineBatchKernel(SPTAG_TARGET_F16C, ComputeBatch_F16C)
+DefineBatchKernel(SPTAG_TARGET_AVX512, ComputeBatch_AVX512)
+DefineBatchKernel(SPTAG_TARGET_AVX512VNNI, ComputeBatch_AVX512VNNI)
+
+#undef DefineBatchKernel
+
+// Single-pair form of the same building blocks, for the types without a hand-written kernel.
+#define DefinePairKernel(Target, Name) \
+template<typename Ops> \
+Target inline float Name(const typename Ops::ValueType* pX, const typename Ops::ValueType* pY, DimensionType length) \
+{ \
+    const DimensionType full = length - length % Ops::Width; \
+    typename Ops::Acc diff = Ops::Zero(); \
+    for (DimensionType d = 0; d < full; d += Ops::Width) { \
+        diff = Ops::Step(diff, Ops::Load(pX + d), Ops::Load(pY + d)); \
+    } \
+    if (full < length) { \
+        diff = Ops::Step(diff, Ops::LoadTail(pX + full, length - full), Ops::LoadTail(pY + full, length - full)); \
+    } \
+    return Ops::Finish(diff); \
+} \
+
+DefinePairKernel(, ComputePair_SSE)
+DefinePairKernel(SPTAG_TARGET_AVX2, ComputePair_AVX2)
+DefinePairKernel(SPTAG_TARGET_F16C, ComputePair_F16C)
+DefinePairKernel(SPTAG_TARGET_AVX512, ComputePair_AVX512)
+
+#undef DefinePairKernel
+
+#define DefinePairKernelEntry(Method, T, ISA, Impl, Ops) \
+float DistanceUtils::Compute##Method##Distance_##ISA(const T* pX, const T* pY, DimensionType length) \
+{ \
+    return Impl<Ops>(pX, pY, length); \
+} \
+
+DefinePairKernelEntry(L2, SPTAG::Float16, SSE, ComputePair_SSE, L2Ps128<Half128>)
+DefinePairKernelEntry(L2, SPTAG::Float16, AVX, ComputePair_F16C, L2Ps256<Half256>)
+DefinePairKernelEntry(L2, SPTAG::Float16, AVX512, ComputePair_AVX512, L2Ps512<Half512>)
+DefinePairKernelEntry(L2, SPTAG::BFloat16, SSE, ComputePair_SSE, L2Ps128<BHalf128>)
+DefinePairKernelEntry(L2, SPTAG::BFloat16, AVX, ComputePair_AVX2, L2Ps256<BHalf256>)
+DefinePairKernelEntry(L2, SPTAG::BFloat16, AVX512, ComputePair_AVX512, L2Ps512<BHalf512>)
+
+DefinePairKernelEntry(Cosine, SPTAG::Float16, SSE, ComputePair_SSE, CosinePs128<Half128>)
+DefinePairKernelEntry(Cosine, SPTAG::Float16, AVX, ComputePair_F16C, CosinePs256<Half256>)
+DefinePairKernelEntry(Cosine, SPTAG::Float16, AVX512, ComputePair_AVX512, CosinePs512<Half512>)
+DefinePairKernelEntry(Cosine, SPTAG::BFloat16, SSE, ComputePair_SSE, CosinePs128<BHalf128>)
+DefinePairKernelEntry(Cosine, SPTAG::BFloat16, AVX, ComputePair_AVX2, CosinePs256<BHalf256>)
+DefinePairKernelEntry(Cosine, SPTAG::BFloat16, AVX512, ComputePair_AVX512, CosinePs512<BHalf512>)
+
+#undef DefinePairKernelEntry
+
+#define DefineBatchKernelEntry(Method, T, ISA, Impl, Ops) \
+void DistanceUtils::Compute##Method##DistanceBatch_##ISA(const T* pQuery, const T* const* pRows, int count, DimensionType length, float* pResults) \
+{ \
+    Impl<Ops>(pQuery, pRows, count, length, pResults); \
+} \
+
+DefineBatchKernelEntry(L2, std::int8_t, AVX, ComputeBatch_AVX2, L2Byte256<std::int8_t>)
+DefineBatchKernelEntry(L2, std::int8_t, AVX512, ComputeBatch_AVX512, L2Byte512<std::int8_t>)
+DefineBatchKernelEntry(L2, std::int8_t, AVX512VNNI, ComputeBatch_AVX512VNNI, L2Byte512VNNI<std::int8_t>)
+DefineBatchKernelEntry(L2, std::uint8_t, AVX, ComputeBatch_AVX2, L2Byte256<std::uint8_t>)
+DefineBatchKernelEntry(L2, std::uint8_t, AVX512, ComputeBatch_AVX512, L2Byte512<std::uint8_t>)
+DefineBatchKernelEntry(L2, std::uint8_t, AVX512VNNI, ComputeBatch_AVX512VNNI, L2Byte512VNNI<std::uint8_t>)
+DefineBatchKernelEntry(L2, std::int16_t, AVX, ComputeBatch_AVX2, L2Int16_256)
+DefineBatchKernelEntry(L2, std::int16_t, AVX512, ComputeBatch_AVX512, L2Int16_512)
+DefineBatchKernelEntry(L2, float, AVX, ComputeBatch_AVX, L2Ps256<Float256>)
+DefineBatchKernelEntry(L2, float, AVX512, ComputeBatch_AVX512, L2Ps512<Float512>)
+DefineBatchKernelEntry(L2, SPTAG::Float16, AVX, ComputeBatch_F16C, L2Ps256<Half256>)
+DefineBatchKernelEntry(L2, SPTAG::Float16, AVX512, ComputeBatch_AVX512, L2Ps512<Half512>)
+DefineBatchKernelEntry(L2, SPTAG::BFloat16, AVX, ComputeBatch_AVX2, L2Ps256<BHalf256>)
+DefineBatchKernelEntry(L2, SPTAG::BFloat16, AVX512, ComputeBatch_AVX512, L2Ps512<BHalf512>)
+
+DefineBatchKernelEntry(Cosine, std::int8_t, AVX, ComputeBatch_AVX2, CosineByte256<std::int8_t>)
+DefineBatchKernelEntry(Cosine, std::int8_t, AVX512, ComputeBatch_AVX512, CosineByte512<std::int8_t>)
+DefineBatchKernelEntry(Cosine, std::int8_t, AVX512VNNI, ComputeBatch_AVX512VNNI, CosineByte512VNNI<std::int8_t>)
+DefineBatchKernelEntry(Cosine, std::uint8_t, AVX, ComputeBatch_AVX2, CosineByte256<std::uint8_t>)
+DefineBatchKernelEntry(Cosine, std::uint8_t, AVX512, ComputeBatch_AVX512, CosineByte512<std::uint8_t>)
+DefineBatchKernelEntry(Cosine, std::uint8_t, AVX512VNNI, ComputeBatch_AVX512VNNI, CosineByte512VNNI<std::uint8_t>)
+DefineBatchKernelEntry(Cosine, std::int16_t, AVX, ComputeBatch_AVX2, CosineInt16_256)
+DefineBatchKernelEntry(Cosine, std::int16_t, AVX512, ComputeBatch_AVX512, CosineInt16_512)
+DefineBatchKernelEntry(Cosine, float, AVX, ComputeBatch_AVX, CosinePs256<Float256>)
+DefineBatchKernelEntry(Cosine, float, AVX512, ComputeBatch_AVX512, CosinePs512<Float512>)
+DefineBatchKernelEntry(Cosine, SPTAG::Float16, AVX, ComputeBatch_F16C, CosinePs256<Half256>)
+DefineBatchKernelEntry(Cosine, SPTAG::Float16, AVX512, ComputeBatch_AVX512, CosinePs512<Half512>)
+DefineBatchKernelEntry(Cosine, SPTAG::BFloat16, AVX, ComputeBatch_AVX2, CosinePs256<BHalf256>)
+DefineBatchKernelEntry(Cosine, SPTAG::BFloat16, AVX512, ComputeBatch_AVX512, CosinePs512<BHalf512>)
+
+#undef DefineBatchKernelEntry
+
+// Kernels compiled for one dimension. The trip count is a constant, so there is no tail and the compiler
+// unrolls the loops; the pair kernel alternates two accumulators to halve the dependency chain. Called
+// with another length, e.g. on a block of ComputeDistanceBounded, they defer to the generic kernel.
+#define DefineFixedKernels(Target, Name) \
+template<typename Ops, DimensionType Dim, float(*Generic)(const typename Ops::ValueType*, const typename Ops::ValueType*, DimensionType)> \
+Target float ComputeFixedPair_##Name(const typename Ops::ValueType* pX, const typename Ops::ValueType* pY, DimensionType length) \
+{ \
+    static_assert(Dim % Ops::Width == 0, "fixed dimension kernels have no tail"); \
+    if (length != Dim) return Generic(pX, pY, length); \
+    const DimensionType paired = Dim - Dim % (2 * Ops::Width); \
+    typename Ops::Acc a0 = Ops::Zero(), a1 = Ops::Zero(); \
+    for (DimensionType d = 0; d < paired; d += 2 * Ops::Width) { \
+        a0 = Ops::Step(a0, Ops::Load(pX + d), Ops::Load(pY + d)); \
+        a1 = Ops::Step(a1, Ops::Load(pX + d + Ops::Width), Ops::Load(pY + d + Ops::Width)); \
+    } \
+    if (paired < Dim) a0 = Ops::Step(a0, Ops::Load(pX + paired), Ops::Load(pY + paired)); \
+    return Ops::Finish(Ops::Merge(a0, a1)); \
+} \
+template<typename Ops, DimensionType Dim, void(*Generic)(const typename Ops::ValueType*, const typename Ops::ValueType* const*, int, DimensionType, float*)> \
+Target void ComputeFixedBatch_##Name(const typename Ops::ValueType* pQuery, const typename Ops::ValueType* const* pRows, int count, DimensionType length, float* pResults) \
+{ \
+    typedef typename Ops::ValueType T; \
+    if (length != Dim) { Generic(pQuery, pRows, count, length, pResults); return; } \
+    int r = 0; \
+    for (; r + 4 <= count; r += 4) { \
+        const T* p0 = pRows[r]; const T* p1 = pRows[r + 1]; const T* p2 = pRows[r + 2]; const T* p3 = pRows[r + 3]; \
+        typename Ops::Acc a0 = Ops::Zero(), a1 = Ops::Zero(), a2 = Ops::Zero(), a3 = Ops::Zero(); \
+        for (DimensionType d = 0; d < Dim; d += Ops::Width) { \
+            typename Ops::Vec q = Ops::Load(pQuery + d); \
+            a0 = Ops::Step(a0, q, Ops::Load(p0 + d)); \
+            a1 = Ops::Step(a1, q, Ops::Load(p1 + d)); \
+            a2 = Ops::Step(a2, q, Ops::Load(p2 + d)); \
+            a3 = Ops::Step(a3, q, Ops::Load(p3 + d)); \
+        } \
+        pResults[r] = Ops::Finish(a0); \
+        pResults[r + 1] = Ops::Finish(a1); \
+        pResults[r + 2] = Ops::Finish(a2); \
+        pResults[r + 3] = Ops::Finish(a3); \
+    } \
+    for (; r < count; r++) { \
+        const T* p0 = pRows[r]; \
+        typename Ops::Acc a0 = Ops::Zero(); \
+        for (DimensionType d = 0; d < Dim; d += Ops::Width) { \
+            a0 = Ops::Step(a0, Ops::Load(pQuery + d), Ops::Load(p0 + d)); \
+        } \
+        pResults[r] = Ops::Finish(a0); \
+    } \
+} \
+
+DefineFixedKernels(SPTAG_TARGET_AVX, AVX)
+DefineFixedKernels(SPTAG_TARGET_AVX2, AVX2)
+DefineFixedKernels(SPTAG_TARGET_AVX512, AVX512)
+DefineFixedKernels(SPTAG_TARGET_AVX512VNNI, AVX512VNNI)
+
+#undef DefineFixedKernels
+
+namespace
+{
+    template<typename T>
+    struct FixedDimensionEntry
+    {
+        SPTAG::DistCalcMethod method;
+        DimensionType dimension;
+        bool(*supported)();
+        float(*pair)(const T*, const T*, DimensionType);
+        void(*batch)(const T*, const T* const*, int, DimensionType, float*);
+    };
+
+    // Entries of one type are listed from the widest instruction set down; the first one the CPU
+    // supports wins. Types without a table always use the generic kernels.
+    template<typename T>
+    const FixedDimensionEntry<T>* FixedDimensionTable(std::size_t& p_count)
+    {
+        p_count = 0;
+        return nullptr;
+    }
+
+#define FixedDimensionEntry(Method, Dim, Check, ISA, Impl, Ops) \
+    { SPTAG::DistCalcMethod::Method, Dim, &InstructionSet::Check, \
+      &ComputeFixedPair_##Impl<Ops, Dim, &DistanceUtils::Compute##Method##Distance_##ISA>, \
+      &ComputeFixedBatch_##Impl<Ops, Dim, &DistanceUtils::Compute##Method##DistanceBatch_##ISA> }, \
+
+#define FixedDimensionEntries(Method, Check, ISA, Impl, Ops) \
+    FixedDimensionEntry(Method, 96, Check, ISA, Impl, Ops) \
+    FixedDimensionEntry(Method, 128, Check, ISA, Impl, Ops) \
+    FixedDimensionEntry(Method, 256, Check, ISA, Impl, Ops) \
+    FixedDimensionEntry(Method, 768, Check, ISA, Impl, Ops) \
+
+    template<>
+    const FixedDimensionEntry<float>* FixedDimensionTable<float>(std::size_t& p_count)
+    {
+        static const FixedDimensionEntry<float> entries[] = {
+            FixedDimensionEntries(L2, AVX512, AVX512, AVX512, L2Ps512<Float512>)
+            FixedDimensionEntries(Cosine, AVX512, AVX512, AVX512, CosinePs512<Float512>)
+            FixedDimensionEntries(L2, AVX, AVX, AVX, L2Ps256<Float256>)
+            FixedDimensionEntries(Cosine, AVX, AVX, AVX, CosinePs256<Float256>)
+        };
+        p_count = sizeof(entries) / sizeof(entries[0]);
+        return entries;
+    }
+
+    template<>
+    const FixedDimensionEntry<std::int8_t>* FixedDimensionTable<std::int8_t>(std::size_t& p_count)
+    {
+        static const FixedDimensionEntry<std::int8_t> entries[] = {
+            FixedDimensionEntries(L2, AVX512VNNI, AVX512VNNI, AVX512VNNI, L2Byte512VNNI<std::int8_t>)
+            FixedDimensionEntries(Cosine, AVX512VNNI, AVX512VNNI, AVX512VNNI, CosineByte512VNNI<std::int8_t>)
+            FixedDimensionEntries(L2, AVX512, AVX512, AVX512, L2Byte512<std::int8_t>)
+            FixedDimensionEntries(Cosine, AVX512, AVX512, AVX512, CosineByte512<std::int8_t>)
+            FixedDimensionEntries(L2, AVX2, AVX, AVX2, L2Byte256<std::int8_t>)
+            FixedDimensionEntries(Cosine, AVX2, AVX, AVX2, CosineByte256<std::int8_t>)
+        };
+        p_count = sizeof(entries) / sizeof(entries[0]);
+        return entries;
+    }
+
+    template<>
+    const FixedDimensionEntry<std::uint8_t>* FixedDimensionTable<std::uint8_t>(std::size_t& p_count)
+    {
+        static const FixedDimensionEntry<std::uint8_t> entries[] = {
+            FixedDimensionEntries(L2, AVX512VNNI, AVX512VNNI, AVX512VNNI, L2Byte512VNNI<std::uint8_t>)
+            FixedDimensionEntries(Cosine, AVX512VNNI, AVX512VNNI, AVX512VNNI, CosineByte512VNNI<std::uint8_t>)
+            FixedDimensionEntries(L2, AVX512, AVX512, AVX512, L2Byte512<std::uint8_t>)
+            FixedDimensionEntries(Cosine, AVX512, AVX512, AVX512, CosineByte512<std::uint8_t>)
+            FixedDimensionEntries(L2, AVX2, AVX, AVX2, L2Byte256<std::uint8_t>)
+            FixedDimensionEntries(Cosine, AVX2, AVX, AVX2, CosineByte256<std::uint8_t>)
+        };
+        p_count = sizeof(entries) / sizeof(entries[0]);
+        return entries;
+    }
+
+#undef FixedDimensionEntries
+#undef FixedDimensionEntry
+}
+
+template<typename T>
+bool DistanceUtils::SelectFixedDimensionKernels(SPTAG::DistCalcMethod p_method, DimensionType p_dimension,
+    float(*&p_pair)(const T*, const T*, DimensionType), void(*&p_batch)(const T*, const T* const*, int, DimensionType, float*))
+{
+    if (p_method == SPTAG::DistCalcMethod::InnerProduct) p_method = SPTAG::DistCalcMethod::Cosine;
+
+    std::size_t count;
+    const FixedDimensionEntry<T>* entries = FixedDimensionTable<T>(count);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        if (entries[i].method == p_method && entries[i].dimension == p_dimension && entries[i].supported())
+        {
+            p_pair = entries[i].pair;
+            p_batch = entries[i].batch;
+            return true;
+        }
+    }
+    return false;
+}
+
+#define DefineVectorValueType(Name, Type) \
+template bool DistanceUtils::SelectFixedDimensionKernels<Type>(SPTAG::DistCalcMethod, DimensionType, \
+    float(*&)(const Type*, const Type*, DimensionType), void(*&)(const Type*, const Type* const*, int, DimensionType, float*)); \
+
+#include "inc/Core/DefinitionList.h"
+#undef DefineVectorValueType
+
+namespace
+{
+    // Portable population count: sums bits in pairs, nibbles and bytes, then adds the bytes up with
+    // one multiply.
+    inline std::uint64_t PopCount64(std::uint64_t x)
+    {
+        x = x - ((x >> 1) & 0x5555555555555555ULL);
+        x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+        x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+        return (x * 0x0101010101010101ULL) >> 56;
+    }
+
+    SPTAG_TARGET_AVX512VPOPCNTDQ inline float CountDifferingBits512(const std::uint8_t* pX, const std::uint8_t* pY, std::size_t bytes)
+    {
+        __m512i bits = _mm512_setzero_si512();
+        std::size_t i = 0;
+        for (; i + 64 <= bytes; i += 64)
+        {
+            __m512i diff = _mm512_xor_si512(_mm512_loadu_si512((const void*)(pX + i)), _mm512_loadu_si512((const void*)(pY + i)));
+            bits = _mm512_add_epi64(bits, _mm512_popcnt_epi64(diff));
+        }
+        if (i < bytes)
+        {
+            __mmask64 mask = (1ULL << (bytes - i)) - 1;
+            __m512i diff = _mm512_xor_si512(_mm512_maskz_loadu_epi8(mask, pX + i), _mm512_maskz_loadu_epi8(mask, pY + i));
+            bits = _mm512_add_epi64(bits, _mm512_popcnt_epi64(diff));
+        }
+        return (float)_mm512_reduce_add_epi64(bits);
+    }
+}
+
+float DistanceUtils::CountDifferingBits_SSE(const std::uint8_t* pX, const std::uint8_t* pY, std::size_t bytes)
+{
+    std::uint64_t bits = 0;
+    std::size_t i = 0;
+    for (; i + 8 <= bytes; i += 8)
+    {
+        std::uint64_t x, y;
+        std::memcpy(&x, pX + i, sizeof(x));
+        std::memcpy(&y, pY + i, sizeof(y));
+        bits += PopCount64(x ^ y);
+    }
+    for (; i < bytes; i++) bits += PopCount64((std::uint64_t)(pX[i] ^ pY[i]));
+    return (float)bits;
+}
+
+SPTAG_TARGET_POPCNT float DistanceUtils::CountDifferingBits_POPCNT(const std::uint8_t* pX, const std::uint8_t* pY, std::size_t bytes)
+{
+    std::uint64_t bits = 0;
+    std::size_t i = 0;
+    for (; i + 8 <= bytes; i += 8)
+    {
+        std::uint64_t x, y;
+        std::memcpy(&x, pX + i, sizeof(x));
+        std::memcpy(&y, pY + i, sizeof(y));
+        bits += _mm_popcnt_u64(x ^ y);
+    }
+    for (; i < bytes; i++) bits += _mm_popcnt_u32((std::uint32_t)(pX[i] ^ pY[i]));
+    return (float)bits;
+}
+
+SPTAG_TARGET_AVX512VPOPCNTDQ float DistanceUtils::CountDifferingBits_AVX512VPOPCNTDQ(const std::uint8_t* pX, const std::uint8_t* pY, std::size_t bytes)
+{
+    return CountDifferingBits512(pX, pY, bytes);
+}
+
+// Codes of up to 512 bits fit in one register: the query is loaded once and every row is a single
+// masked load, xor and popcount.
+SPTAG_TARGET_AVX512VPOPCNTDQ void DistanceUtils::CountDifferingBitsBatch_AVX512VPOPCNTDQ(const std::uint8_t* pQuery, const std::uint8_t* const* pRows, int count, std::size_t bytes, float* pResults)
+{
+    if (bytes > 64)
+    {
+        for (int r = 0; r < count; r++) pResults[r] = CountDifferingBits512(pQuery, pRows[r], bytes);
+        return;
+    }
+
+    __mmask64 mask = (bytes == 64) ? ~0ULL : (1ULL << bytes) - 1;
+    __m512i query = _mm512_maskz_loadu_epi8(mask, pQuery);
+    for (int r = 0; r < count; r++)
+    {
+        __m512i diff = _mm512_xor_si512(query, _mm512_maskz_loadu_epi8(mask, pRows[r]));
+        pResults[r] = (float)_mm512_reduce_add_epi64(_mm512_popcnt_epi64(diff));
+    }
+}
@@ -0,0 +1,122 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "inc/Core/Common/InstructionUtils.h"
+
+#include <cstdint>
+
+#ifndef _MSC_VER
+#include <cpuid.h>
+#else
+#include <intrin.h>
+#endif
+
+using namespace SPTAG;
+using namespace SPTAG::COMMON;
+
+namespace
+{
+    void cpuid(int p_leaf, int p_subLeaf, std::uint32_t p_regs[4])
+    {
+#ifndef _MSC_VER
+        unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+        if (__get_cpuid_max(0, nullptr) >= (unsigned int)p_leaf)
+        {
+            __cpuid_count(p_leaf, p_subLeaf, eax, ebx, ecx, edx);
+        }
+        p_regs[0] = eax; p_regs[1] = ebx; p_regs[2] = ecx; p_regs[3] = edx;
+#else
+        int regs[4];
+        __cpuidex(regs, p_leaf, p_subLeaf);
+        for (int i = 0; i < 4; i++) p_regs[i] = (std::uint32_t)regs[i];
+#endif
+    }
+
+    // Register state the OS has enabled in XCR0. Only valid when OSXSAVE is reported.
+    std::uint64_t xgetbv()
+    {
+#ifndef _MSC_VER
+        std::uint32_t eax, edx;
+        __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        return ((std::uint64_t)edx << 32) | eax;
+#else
+        return _xgetbv(0);
+#endif
+    }
+}
+
+
+InstructionSet::InstructionSet_Internal::InstructionSet_Internal()
+    : HW_SSE(false),
+      HW_SSE2(false),
+      HW_POPCNT(false),
+      HW_AVX(false),
+      HW_AVX2(false),
+      HW_F16C(false),
+      HW_AVX512(false),
+      HW_AVX512VNNI(false),
+      HW_AVX512VPOPCNTDQ(false)
+{
+    std::uint32_t regs[4];
+    cpuid(0, 0, regs);
+    std::uint32_t maxLeaf = regs[0];
+    if (maxLeaf < 1) return;
+
+    cpuid(1, 0, regs);
+    HW_SSE = (regs[3] & (1u << 25)) != 0;
+    HW_SSE2 = (regs[3] & (1u << 26)) != 0;
+    HW_POPCNT = (regs[2] & (1u << 23)) != 0;
+
+    bool osxsave = (regs[2] & (1u << 27)) != 0;
+    std::uint64_t xcr0 = osxsave ? xgetbv() : 0;
+    // XMM and YMM state for AVX, plus opmask and both halves of the ZMM state for AVX-512.
+    bool osAVX = (xcr0 & 0x6) == 0x6;
+    bool osAVX512 = (xcr0 & 0xe6) == 0xe6;
+
+    HW_AVX = osAVX && (regs[2] & (1u << 28)) != 0;
+    HW_F16C = HW_AVX && (regs[2] & (1u << 29)) != 0;
+    if (maxLeaf < 7) return;
+
+    cpuid(7, 0, regs);
+    HW_AVX2 = HW_AVX && (regs[1] & (1u << 5)) != 0;
+
+    bool avx512f = (regs[1] & (1u << 16)) != 0;
+    bool avx512dq = (regs[1] & (1u << 17)) != 0;
+    bool avx512bw = (regs[1] & (1u << 30)) != 0;
+    bool avx512vl = (regs[1] & (1u << 31)) != 0;
+    HW_AVX512 = HW_AVX2 && osAVX512 && avx512f && avx512dq && avx512bw && avx512vl;
+    HW_AVX512VNNI = HW_AVX512 && (regs[2] & (1u << 11)) != 0;
+    HW_AVX512VPOPCNTDQ = HW_AVX512 && (regs[2] & (1u << 14)) != 0;
+}
+
+
+const InstructionSet::InstructionSet_Internal&
+InstructionSet::CPU_Rep()
+{
+    static const InstructionSet_Internal rep;
+    return rep;
+}
+
+
+bool InstructionSet::SSE() { return CPU_Rep().HW_SSE; }
+bool InstructionSet::SSE2() { return CPU_Rep().HW_SSE2; }
+bool InstructionSet::POPCNT() { return CPU_Rep().HW_POPCNT; }
+bool InstructionSet::AVX() { return CPU_Rep().HW_AVX; }
+bool InstructionSet::AVX2() { return CPU_Rep().HW_AVX2; }
+bool InstructionSet::F16C() { return CPU_Rep().HW_F16C; }
+bool InstructionSet::AVX512() { return CPU_Rep().HW_AVX512; }
+bool InstructionSet::AVX512VNNI() { return CPU_Rep().HW_AVX512VNNI; }
+bool InstructionSet::AVX512VPOPCNTDQ() { return CPU_Rep().HW_AVX512VPOPCNTDQ; }
+
+
+const char*
+InstructionSet::Best()
+{
+    if (AVX512VNNI()) return "AVX512VNNI";
+    if (AVX512()) return "AVX512";
+    if (AVX2()) return "AVX2";
+    if (AVX()) return "AVX";
+    if (SSE2()) return "SSE2";
+    if (SSE()) return "SSE";
+    return "None";
+}
@@ -0,0 +1,71 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "inc/Core/Common/PQQuantizer.h"
+
+#include <immintrin.h>
+
+using namespace SPTAG;
+using namespace SPTAG::COMMON;
+
+void PQUtils::ComputeADCDistanceBatch_SSE(const float* pTable, const std::uint8_t* const* pCodes, int count, DimensionType subvectors, float* pResults)
+{
+    for (int i = 0; i < count; i++)
+    {
+        const std::uint8_t* code = pCodes[i];
+        float dist = 0;
+        for (DimensionType m = 0; m < subvectors; m++) dist += pTable[m * CentroidNum + code[m]];
+        pResults[i] = dist;
+    }
+}
+
+SPTAG_TARGET_AVX2 void PQUtils::ComputeADCDistanceBatch_AVX2(const float* pTable, const std::uint8_t* const* pCodes, int count, DimensionType subvectors, float* pResults)
+{
+    const DimensionType full = subvectors & ~7;
+    const __m256i step = _mm256_set1_epi32(8 * CentroidNum);
+    const __m256i start = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(CentroidNum));
+    for (int i = 0; i < count; i++)
+    {
+        const std::uint8_t* code = pCodes[i];
+        __m256 acc = _mm256_setzero_ps();
+        __m256i offset = start;
+        for (DimensionType m = 0; m < full; m += 8)
+        {
+            __m256i idx = _mm256_add_epi32(offset, _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(code + m))));
+            acc = _mm256_add_ps(acc, _mm256_i32gather_ps(pTable, idx, 4));
+            offset = _mm256_add_epi32(offset, step);
+        }
+        __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+        sum = _mm_hadd_ps(sum, sum);
+        sum = _mm_hadd_ps(sum, sum);
+        float dist = _mm_cvtss_f32(sum);
+        for (DimensionType m = full; m < subvectors; m++) dist += pTable[m * CentroidNum + code[m]];
+        pResults[i] = dist;
+    }
+}
+
+SPTAG_TARGET_AVX512 void PQUtils::ComputeADCDistanceBatch_AVX512(const float* pTable, const std::uint8_t* const* pCodes, int count, DimensionType subvectors, float* pResults)
+{
+    const DimensionType full = subvectors & ~15;
+    const __mmask16 tailMask = (__mmask16)((1u << (subvectors - full)) - 1);
+    const __m512i step = _mm512_set1_epi32(16 * CentroidNum);
+    const __m512i start = _mm512_mullo_epi32(_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15), _mm512_set1_epi32(CentroidNum));
+    for (int i = 0; i < count; i++)
+    {
+        const std::uint8_t* code = pCodes[i];
+        __m512 acc = _mm512_setzero_ps();
+        __m512i offset = start;
+        for (DimensionType m = 0; m < full; m += 16)
+        {
+            __m512i idx = _mm512_add_epi32(offset, _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i*)(code + m))));
+            acc = _mm512_add_ps(acc, _mm512_i32gather_ps(idx, pTable, 4));
+            offset = _mm512_add_epi32(offset, step);
+        }
+        if (tailMask)
+        {
+            __m512i idx = _mm512_add_epi32(offset, _mm512_cvtepu8_epi32(_mm_maskz_loadu_epi8(tailMask, code + full)));
+            acc = _mm512_add_ps(acc, _mm512_mask_i32gather_ps(_mm512_setzero_ps(), tailMask, idx, pTable, 4));
+        }
+        pResults[i] = _mm512_reduce_add_ps(acc);
+    }
+}
@@ -0,0 +1,655 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "inc/Core/Flat/Index.h"
+
+#include <memory>
+
+#pragma warning(disable:4996)  // 'fopen': This function or variable may be unsafe. Consider using fopen_s instead. To disable deprecation, use _CRT_SECURE_NO_WARNINGS. See online help for details.
+#pragma warning(disable:4242)  // '=' : conversion from 'int' to 'short', possible loss of data
+#pragma warning(disable:4244)  // '=' : conversion from 'int' to 'short', possible loss of data
+#pragma warning(disable:4127)  // conditional expression is constant
+
+namespace SPTAG
+{
+    namespace Flat
+    {
+        // Scores all vectors on the first page and hands out the sorted results page by page.
+        template <typename T>
+        class Index<T>::ScanIterator : public ResultIterator
+        {
+        public:
+            ScanIterator(const Index<T>* p_index, const T* p_target, const SearchOptions& p_options)
+                : m_index(p_index),
+                  m_target(p_target, p_target + p_index->GetFeatureDim()),
+                  m_options(p_options),
+                  m_scanned(false),
+                  m_closed(false),
+                  m_cutShort(false),
+                  m_next(0)
+            {
+            }
+
+            ErrorCode Next(QueryResult& p_results)
+            {
+                if (m_closed) return ErrorCode::Fail;
+
+                if (!m_scanned)
+                {
+                    COMMON::RadiusResultSet<T> results(m_target.data(), MaxDist);
+                    m_cutShort = m_index->Scan(results, m_options, m_options.m_searchDeleted);
+                    m_results = results.GetResults();
+                    m_scanned = true;
+                }
+
+                for (int i = 0; i < p_results.GetResultNum(); i++)
+                {
+                    SizeType vid = (m_next < m_results.size()) ? m_results[m_next].VID : -1;
+                    p_results.SetResult(i, vid, (vid < 0) ? MaxDist : m_results[m_next++].Dist);
+                    if (p_results.WithMeta()) p_results.SetMetadata(i, (vid < 0) ? ByteArray::c_empty : m_index->GetMetadata(vid));
+                }
+                p_results.SetCutShort(m_cutShort);
+                return ErrorCode::Success;
+            }
+
+            void Close()
+            {
+                m_closed = true;
+                std::vector<BasicResult>().swap(m_results);
+            }
+
+        private:
+            const Index<T>* m_index;
+
+            // The caller's query may be gone by the time the next page is asked for.
+            std::vector<T> m_target;
+
+            SearchOptions m_options;
+
+            bool m_scanned;
+
+            bool m_closed;
+
+            bool m_cutShort;
+
+            size_t m_next;
+
+            std::vector<BasicResult> m_results;
+        };
+
+        template <typename T>
+        ErrorCode Index<T>::LoadConfig(Helper::IniReader& p_reader)
+        {
+#define DefineFlatParameter(VarName, VarType, DefaultValue, RepresentStr) \
+            SetParameter(RepresentStr, \
+                         p_reader.GetParameter("Index", \
+                         RepresentStr, \
+                         std::string(#DefaultValue)).c_str()); \
+
+#include "inc/Core/Flat/ParameterDefinitionList.h"
+#undef DefineFlatParameter
+            return ErrorCode::Success;
+        }
+
+        template <typename T>
+        ErrorCode Index<T>::LoadIndexDataFromMemory(const std::vector<ByteArray>& p_indexBlobs)
+        {
+            if (p_indexBlobs.size() < 2) return ErrorCode::LackOfInputs;
+
+            if (!m_pSamples.Load((char*)p_indexBlobs[0].Data())) return ErrorCode::FailedParseValue;
+            if (!m_deletedID.Load((char*)p_indexBlobs[1].Data())) return ErrorCode::FailedParseValue;
+            std::uint64_t offset = m_deletedID.BufferSize();
+            if (!m_attributes.Load((char*)p_indexBlobs[1].Data() + offset, p_indexBlobs[1].Length() - offset, GetNumSamples())) return ErrorCode::FailedParseValue;
+
+            omp_set_num_threads(m_iNumberOfThreads);
+            SelectDistanceKernels();
+            m_bReady = true;
+            return ErrorCode::Success;
+        }
+
+        template <typename T>
+        ErrorCode Index<T>::LoadIndexData(const std::string& p_folderPath)
+        {
+            if (!m_pSamples.Load(p_folderPath + m_sDataPointsFilename)) return ErrorCode::Fail;
+            {
+                std::cout << "Load DeleteID From " << p_folderPath + m_sDeleteDataPointsFilename << std::endl;
+                std::ifstream input(p_folderPath + m_sDeleteDataPointsFilename, std::ios::binary);
+                if (!input.is_open() || !m_deletedID.Load(input) || !m_attributes.Load(input, GetNumSamples())) return ErrorCode::Fail;
+                input.close();
+            }
+
+            omp_set_num_threads(m_iNumberOfThreads);
+            SelectDistanceKernels();
+            m_bReady = true;
+            return ErrorCode::Success;
+        }
+
+        template<typename T>
+        ErrorCode Index<T>::SaveConfig(std::ostream& p_configOut) const
+        {
+#define DefineFlatParameter(VarName, VarType, DefaultValue, RepresentStr) \
+    p_configOut << RepresentStr << "=" << GetParameter(RepresentStr) << std::endl;
+
+#include "inc/Core/Flat/ParameterDefinitionList.h"
+#undef DefineFlatParameter
+            p_configOut << std::endl;
+            return ErrorCode::Success;
+        }
+
+        template<typename T>
+        ErrorCode Index<T>::SaveIndexData(const std::string& p_folderPath)
+        {
+            std::lock_guard<std::mutex> lock(m_dataAddLock);
+            std::unique_lock<std::shared_timed_mutex> uniquelock(m_dataDeleteLock);
+
+            if (!m_pSamples.Save(p_folderPath + m_sDataPointsFilename)) return ErrorCode::Fail;
+            {
+                std::cout << "Save DeleteID To " << p_folderPath + m_sDeleteDataPointsFilename << std::endl;
+                std::ofstream output(p_folderPath + m_sDeleteDataPointsFilename, std::ios::binary);
+                if (!output.is_open() || !m_deletedID.Save(output) || !m_attributes.Save(output)) return ErrorCode::Fail;
+                output.close();
+            }
+            return ErrorCode::Success;
+        }
+
+        template<typename T>
+        ErrorCode Index<T>::SaveIndexData(const std::vector<std::ostream*>& p_indexStreams)
+        {
+            if (p_indexStreams.size() < 2) return ErrorCode::LackOfInputs;
+
+            std::lock_guard<std::mutex> lock(m_dataAddLock);
+            std::unique_lock<std::shared_timed_mutex> uniquelock(m_dataDeleteLock);
+
+            if (!m_pSamples.Save(*p_indexStreams[0])) return ErrorCode::Fail;
+            if (!m_deletedID.Save(*p_indexStreams[1]) || !m_attributes.Save(*p_indexStreams[1])) return ErrorCode::Fail;
+            return ErrorCode::Success;
+        }
+
+#pragma region K-NN search
+
+        template <typename T>
+        template <typename Q>
+        void Index<T>::ScanBlocks(Q** p_queries, const SearchOptions* const* p_options, int p_count, const bool* p_searchDeleted, bool* p_cutShort) const
+        {
+            const SizeType numSamples = GetNumSamples();
+            const SizeType blockSize = ScanBlockSize();
+            const DimensionType dimension = GetFeatureDim();
+            std::vector<const T*> rows(blockSize);
+            float dists[COMMON::DistanceUtils::BatchSize];
+
+            int active = p_count;
+            for (int q = 0; q < p_count; q++) p_cutShort[q] = false;
+
+            // Each block is scored by all queries before the scan moves on, while it is still in the cache.
+            for (SizeType begin = 0; begin < numSamples && active > 0; begin += blockSize)
+            {
+                const SizeType end = min(begin + blockSize, numSamples);
+                for (SizeType i = begin; i < end; i++) rows[i - begin] = m_pSamples[i];
+
+                for (int q = 0; q < p_count; q++)
+                {
+                    if (p_cutShort[q]) continue;
+                    if (p_options[q]->m_deadline != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() > p_options[q]->m_deadline)
+                    {
+                        p_cutShort[q] = true;
+                        active--;
+                        continue;
+                    }
+
+                    Q& query = *p_queries[q];
+                    for (SizeType batch = begin; batch < end; batch += COMMON::DistanceUtils::BatchSize)
+                    {
+                        int count = (int)min((SizeType)COMMON::DistanceUtils::BatchSize, end - batch);
+                        m_fComputeDistanceBatch(query.GetTarget(), rows.data() + (batch - begin), count, dimension, dists);
+                        for (int j = 0; j < count; j++)
+                        {
+                            // The deleted label, attribute and excluded ids are only looked up for a vector that would join the results.
+                            if (dists[j] <= query.worstDist() && Accepts(batch + j, *p_options[q], p_searchDeleted[q])) query.AddPoint(batch + j, dists[j]);
+                        }
+                    }
+                }
+            }
+
+            for (int q = 0; q < p_count; q++) p_queries[q]->SortResult();
+        }
+
+        template <typename T>
+        template <typename Q>
+        void Index<T>::ScanAllowedIDs(Q& p_query, const SearchOptions& p_options, bool p_searchDeleted) const
+        {
+            std::vector<SizeType> ids(*p_options.m_allowedIDs);
+            std::sort(ids.begin(), ids.end());
+            ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+            for (SizeType id : ids)
+            {
+                if (id < 0 || id >= GetNumSamples() || !Accepts(id, p_options, p_searchDeleted)) continue;
+
+                p_query.AddPoint(id, m_fComputeDistance(p_query.GetTarget(), m_pSamples[id], GetFeatureDim()));
+            }
+            p_query.SortResult();
+        }
+
+        template <typename T>
+        template <typename Q>
+        bool Index<T>::Scan(Q& p_query, const SearchOptions& p_options, bool p_searchDeleted) const
+        {
+            if (p_options.m_allowedIDs != nullptr)
+            {
+                ScanAllowedIDs(p_query, p_options, p_searchDeleted);
+                return false;
+            }
+
+            Q* query = &p_query;
+            const SearchOptions* options = &p_options;
+            bool cutShort;
+            ScanBlocks(&query, &options, 1, &p_searchDeleted, &cutShort);
+            return cutShort;
+        }
+
+        template <typename T>
+        void Index<T>::FillMetadata(QueryResult& p_query) const
+        {
+            if (p_query.WithMeta() && nullptr != m_pMetadata)
+            {
+                for (int i = 0; i < p_query.GetResultNum(); ++i)
+                {
+                    SizeType result = p_query.GetResult(i)->VID;
+                    p_query.SetMetadata(i, (result < 0) ? ByteArray::c_empty : m_pMetadata->GetMetadata(result));
+                }
+            }
+        }
+
+        template<typename T>
+        ErrorCode Index<T>::SearchIndex(QueryResult &p_query, bool p_searchDeleted) const
+        {
+            if (!m_bReady) return ErrorCode::EmptyIndex;
+
+            const SearchOptions& options = p_query.GetOptions();
+            p_searchDeleted = p_searchDeleted || options.m_searchDeleted;
+
+            bool cutShort;
+            if (options.m_distinctByMetadata && m_pMetadata != nullptr)
+            {
+                COMMON::DistinctResultSet<T> results((const T*)p_query.GetTarget(), p_query.GetResultNum(), m_pMetadata.get());
+                cutShort = Scan(results, options, p_searchDeleted);
+                results.CopyTo(p_query);
+            }
+            else
+            {
+                cutShort = Scan(*((COMMON::QueryResultSet<T>*)&p_query), options, p_searchDeleted);
+            }
+
+            p_query.SetCutShort(cutShort);
+            FillMetadata(p_query);
+            return ErrorCode::Success;
+        }
+
+        template<typename T>
+        ErrorCode Index<T>::SearchIndexGroup(QueryResult** p_queries, int p_queryCount, bool p_searchDeleted) const
+        {
+            if (!m_bReady) return ErrorCode::EmptyIndex;
+
+            std::vector<COMMON::QueryResultSet<T>*> queries;
+            std::vector<const SearchOptions*> options;
+            std::unique_ptr<bool[]> searchDeleted(new bool[p_queryCount]);
+            std::unique_ptr<bool[]> cutShort(new bool[p_queryCount]);
+            for (int i = 0; i < p_queryCount; i++)
+            {
+                const SearchOptions& queryOptions = p_queries[i]->GetOptions();
+                if (queryOptions.m_allowedIDs != nullptr || (queryOptions.m_distinctByMetadata && m_pMetadata != nullptr))
+                {
+                    SearchIndex(*p_queries[i], p_searchDeleted);
+                    continue;
+                }
+
+                searchDeleted[queries.size()] = p_searchDeleted || queryOptions.m_searchDeleted;
+                queries.push_back((COMMON::QueryResultSet<T>*)p_queries[i]);
+                options.push_back(&queryOptions);
+            }
+            if (queries.empty()) return ErrorCode::Success;
+
+            ScanBlocks(queries.data(), options.data(), (int)queries.size(), searchDeleted.get(), cutShort.get());
+            for (size_t i = 0; i < queries.size(); i++)
+            {
+                queries[i]->SetCutShort(cutShort[i]);
+                FillMetadata(*queries[i]);
+            }
+            return ErrorCode::Success;
+        }
+
+        template<typename T>
+        ErrorCode Index<T>::SearchIndex(const void* p_vector, int p_vectorCount, int p_neighborCount, bool p_withMeta, BasicResult* p_results) const
+        {
+            if (!m_bReady) return ErrorCode::EmptyIndex;
+
+            // Each thread scans for SearchGroupSize queries at a time, each query with its own top K heap.
+            const size_t vectorSize = sizeof(T) * GetFeatureDim();
+            const int groupSize = max(m_iSearchGroupSize, 1);
+            const int groups = (p_vectorCount + groupSize - 1) / groupSize;
+#pragma omp parallel for schedule(dynamic)
+            for (int g = 0; g < groups; g++)
+            {
+                const int first = g * groupSize;
+                const int count = min(groupSize, p_vectorCount - first);
+                std::vector<std::unique_ptr<QueryResult>> results(count);
+                std::vector<QueryResult*> queries(count);
+                for (int i = 0; i < count; i++)
+                {
+                    results[i].reset(new QueryResult((const char*)p_vector + (first + i) * vectorSize, p_neighborCount, p_withMeta, p_results + (size_t)(first + i) * p_neighborCount));
+                    queries[i] = results[i].get();
+                }
+                SearchIndexGroup(queries.data(), count);
+            }
+            return ErrorCode::Success;
+        }
+
+        template <typename T>
+        ErrorCode Index<T>::RefineSearchIndex(QueryResult &p_query, bool p_searchDeleted) const
+        {
+            return SearchIndex(p_query, p_searchDeleted);
+        }
+
+        template <typename T>
+        ErrorCode Index<T>::SearchIndexWithinRadius(QueryResult &p_query, float p_radius, bool p_searchDeleted) const
+        {
+            if (!m_bReady) return ErrorCode::EmptyIndex;
+
+            const SearchOptions& options = p_query.GetOptions();
+            COMMON::RadiusResultSet<T> results((const T*)p_query.GetTarget(), p_radius);
+            bool cutShort = Scan(results, options, p_searchDeleted || options.m_searchDeleted);
+
+            const std::vector<BasicResult>& found = results.GetResults();
+            p_query.Init(p_query.GetTarget(), static_cast<int>(found.size()), p_query.WithMeta());
+            p_query.SetCutShort(cutShort);
+            for (int i = 0; i < p_query.GetResultNum(); ++i) p_query.SetResult(i, found[i].VID, found[i].Dist);
+            FillMetadata(p_query);
+            return ErrorCode::Success;
+        }
+
+        template <typename T>
+        std::shared_ptr<ResultIterator> Index<T>::GetIterator(const void* p_target, const SearchOptions& p_options) const
+        {
+            if (!m_bReady) return nullptr;
+
+            return std::make_shared<ScanIterator>(this, (const T*)p_target, p_options);
+        }
+#pragma endregion
+
+        template <typename T>
+        ErrorCode Index<T>::BuildIndex(const void* p_data, SizeType p_vectorNum, DimensionType p_dimension)
+        {
+            if (p_data == nullptr || p_vectorNum == 0 || p_dimension == 0) return ErrorCode::EmptyData;
+
+            omp_set_num_threads(m_iNumberOfThreads);
+
+            m_pSamples.Initialize(p_vectorNum, p_dimension, (T*)p_data, false);
+            m_deletedID.Initialize(p_vectorNum);
+            m_attributes.Initialize(p_vectorNum);
+
+            if (DistCalcMethod::Cosine == m_iDistCalcMethod)
+            {
+                int base = COMMON::Utils::GetBase<T>();
+#pragma omp parallel for
+                for (SizeType i = 0; i < GetNumSamples(); i++) {
+                    COMMON::Utils::Normalize(m_pSamples[i], GetFeatureDim(), base);
+                }
+            }
+
+            SelectDistanceKernels();
+            m_bReady = true;
+            return ErrorCode::Success;
+        }
+
+        template <typename T>
+        ErrorCode Index<T>::RefineIndex(std::shared_ptr<VectorIndex>& p_newIndex)
+        {
+            p_newIndex.reset(new Index<T>());
+            Index<T>* ptr = (Index<T>*)p_newIndex.get();
+
+#define DefineFlatParameter(VarName, VarType, DefaultValue, RepresentStr) \
+            ptr->VarName =  VarName; \
+
+#include "inc/Core/Flat/ParameterDefinitionList.h"
+#undef DefineFlatParameter
+
+            std::lock_guard<std::mutex> lock(m_dataAddLock);
+            std::unique_lock<std::shared_timed_mutex> uniquelock(m_dataDeleteLock);
+
+            SizeType newR = GetNumSamples();
+
+            std::vector<SizeType> indices;
+            for (SizeType i = 0; i < newR; i++) {
+                if (!m_deletedID.Contains(i)) {
+                    indices.push_back(i);
+                }
+                else {
+                    while (m_deletedID.Contains(newR - 1) && newR > i) newR--;
+                    if (newR == i) break;
+                    indices.push_back(newR - 1);
+                    newR--;
+                }
+            }
+
+            std::cout << "Refine... from " << GetNumSamples() << "->" << newR << std::endl;
+
+            if (false == m_pSamples.Refine(indices, ptr->m_pSamples)) return ErrorCode::Fail;
+            if (nullptr != m_pMetadata && ErrorCode::Success != m_pMetadata->RefineMetadata(indices, ptr->m_pMetadata)) return ErrorCode::Fail;
+
+            ptr->m_deletedID.Initialize(newR);
+            if (false == m_attributes.Refine(indices, ptr->m_attributes)) return ErrorCode::Fail;
+            ptr->SelectDistanceKernels();
+            if (m_pMetaToVec != nullptr) ptr->BuildMetaMapping();
+            ptr->m_bReady = true;
+            return ErrorCode::Success;
+        }
+
+        template <typename T>
+        ErrorCode Index<T>::RefineIndex(const std::vector<std::ostream*>& p_indexStreams)
+        {
+            std::lock_guard<std::mutex> lock(m_dataAddLock);
+            std::unique_lock<std::shared_timed_mutex> uniquelock(m_dataDeleteLock);
+
+            SizeType newR = GetNumSamples();
+
+            std::vector<SizeType> indices;
+            for (SizeType i = 0; i < newR; i++) {
+                if (!m_deletedID.Contains(i)) {
+                    indices.push_back(i);
+                }
+                else {
+                    while (m_deletedID.Contains(newR - 1) && newR > i) newR--;
+                    if (newR == i) break;
+                    indices.push_back(newR - 1);
+                    newR--;
+                }
+            }
+
+            std::cout << "Refine... from " << GetNumSamples() << "->" << newR << std::endl;
+
+            if (false == m_pSamples.Refine(indices, *p_indexStreams[0])) return ErrorCode::Fail;
+            if (nullptr != m_pMetadata && (p_indexStreams.size() < 4 || ErrorCode::Success != m_pMetadata->RefineMetadata(indices, *p_indexStreams[2], *p_indexStreams[3]))) return ErrorCode::Fail;
+
+            COMMON::Labelset newDeletedID;
+            newDeletedID.Initialize(newR);
+            newDeletedID.Save(*p_indexStreams[1]);
+            if (false == m_attributes.Refine(indices, *p_indexStreams[1])) return ErrorCode::Fail;
+            return ErrorCode::Success;
+        }
+
+        template <typename T>
+        ErrorCode Index<T>::RefineIndex(const std::string& p_folderPath)
+        {
+            std::string folderPath(p_folderPath);
+            if (!folderPath.empty() && *(folderPath.rbegin()) != FolderSep)
+            {
+                folderPath += FolderSep;
+            }
+
+            if (!direxists(folderPath.c_str()))
+            {
+                mkdir(folderPath.c_str());
+            }
+
+            std::vector<std::ostream*> streams;
+            streams.push_back(new std::ofstream(folderPath + m_sDataPointsFilename, std::ios::binary));
+            streams.push_back(new std::ofstream(folderPath + m_sDeleteDataPointsFilename, std::ios::binary));
+            if (nullptr != m_pMetadata)
+            {
+                streams.push_back(new std::ofstream(folderPath + m_sMetadataFile, std::ios::binary));
+                streams.push_back(new std::ofstream(folderPath + m_sMetadataIndexFile, std::ios::binary));
+            }
+
+            for (size_t i = 0; i < streams.size(); i++)
+                if (!(((std::ofstream*)streams[i])->is_open())) return ErrorCode::FailedCreateFile;
+
+            ErrorCode ret = RefineIndex(streams);
+
+            for (size_t i = 0; i < streams.size(); i++)
+            {
+                ((std::ofstream*)streams[i])->close();
+                delete streams[i];
+            }
+            return ret;
+        }
+
+        template <typename T>
+        ErrorCode Index<T>::DeleteIndex(const void* p_vectors, SizeType p_vectorNum) {
+            const T* ptr_v = (const T*)p_vectors;
+#pragma omp parallel for schedule(dynamic)
+            for (SizeType i = 0; i < p_vectorNum; i++) {
+                COMMON::RadiusResultSet<T> query(ptr_v + i * GetFeatureDim(), 1e-6f);
+                Scan(query, SearchOptions(), false);
+
+                for (const BasicResult& result : query.GetResults()) {
+                    DeleteIndex(result.VID);
+                }
+            }
+            return ErrorCode::Success;
+        }
+
+        template <typename T>
+        ErrorCode Index<T>::DeleteIndex(const SizeType& p_id) {
+            std::shared_lock<std::shared_timed_mutex> sharedlock(m_dataDeleteLock);
+            if (m_deletedID.Insert(p_id)) return ErrorCode::Success;
+            return ErrorCode::VectorNotFound;
+        }
+
+        template <typename T>
+        ErrorCode Index<T>::SetAttribute(const SizeType idx, std::uint64_t p_attribute)
+        {
+            std::lock_guard<std::mutex> lock(m_dataAddLock);
+            if (idx < 0 || idx >= GetNumSamples()) return ErrorCode::VectorNotFound;
+
+            m_attributes.Set(idx, p_attribute);
+            return ErrorCode::Success;
+        }
+
+        template <typename T>
+        ErrorCode Index<T>::AddIndex(const void* p_data, SizeType p_vectorNum, DimensionType p_dimension, std::shared_ptr<MetadataSet> p_metadataSet, bool p_withMetaIndex)
+        {
+            if (p_data == nullptr || p_vectorNum == 0 || p_dimension == 0) return ErrorCode::EmptyData;
+
+            std::lock_guard<std::mutex> lock(m_dataAddLock);
+
+            SizeType begin = GetNumSamples();
+            SizeType end = begin + p_vectorNum;
+
+            if (begin == 0) {
+                ErrorCode ret;
+                if ((ret = BuildIndex(p_data, p_vectorNum, p_dimension)) != ErrorCode::Success) return ret;
+                m_pMetadata = std::move(p_metadataSet);
+                if (p_withMetaIndex && m_pMetadata != nullptr)
+                {
+                    BuildMetaMapping();
+                }
+                return ErrorCode::Success;
+            }
+
+            if (p_dimension != GetFeatureDim()) return ErrorCode::DimensionSizeMismatch;
+
+            // The labels and attributes grow first, so a search that already sees the new vectors can look them up.
+            if (m_deletedID.AddBatch(p_vectorNum) != ErrorCode::Success ||
+                m_attributes.AddBatch(p_vectorNum) != ErrorCode::Success ||
+                m_pSamples.AddBatch((const T*)p_data, p_vectorNum) != ErrorCode::Success) {
+                std::cout << "Memory Error: Cannot alloc space for vectors" << std::endl;
+                m_pSamples.SetR(begin);
+                m_deletedID.SetR(begin);
+                m_attributes.SetR(begin);
+                return ErrorCode::MemoryOverFlow;
+            }
+            if (DistCalcMethod::Cosine == m_iDistCalcMethod)
+            {
+                int base = COMMON::Utils::GetBase<T>();
+                for (SizeType i = begin; i < end; i++) {
+                    COMMON::Utils::Normalize((T*)m_pSamples[i], GetFeatureDim(), base);
+                }
+            }
+
+            if (m_pMetadata != nullptr) {
+                m_pMetadata->AddBatch(*p_metadataSet);
+
+                if (m_pMetaToVec != nullptr) {
+                    for (SizeType i = begin; i < end; i++) {
+                        ByteArray meta = m_pMetadata->GetMetadata(i);
+                        std::string metastr((char*)meta.Data(), meta.Length());
+                        auto iter = m_pMetaToVec->find(metastr);
+                        if (iter != m_pMetaToVec->end()) DeleteIndex(iter->second);
+                        (*m_pMetaToVec)[metastr] = i;
+                    }
+                }
+            }
+            return ErrorCode::Success;
+        }
+
+        template <typename T>
+        ErrorCode
+            Index<T>::SetParameter(const char* p_param, const char* p_value)
+        {
+            if (nullptr == p_param || nullptr == p_value) return ErrorCode::Fail;
+
+#define DefineFlatParameter(VarName, VarType, DefaultValue, RepresentStr) \
+    else if (SPTAG::Helper::StrUtils::StrEqualIgnoreCase(p_param, RepresentStr)) \
+    { \
+        fprintf(stderr, "Setting %s with value %s\n", RepresentStr, p_value); \
+        VarType tmp; \
+        if (SPTAG::Helper::Convert::ConvertStringTo<VarType>(p_value, tmp)) \
+        { \
+            VarName = tmp; \
+        } \
+    } \
+
+#include "inc/Core/Flat/ParameterDefinitionList.h"
+#undef DefineFlatParameter
+
+            SelectDistanceKernels();
+            m_iBaseSquare = (m_iDistCalcMethod == DistCalcMethod::Cosine || m_iDistCalcMethod == DistCalcMethod::InnerProduct) ? COMMON::Utils::GetBase<T>() * COMMON::Utils::GetBase<T>() : 1;
+            return ErrorCode::Success;
+        }
+
+
+        template <typename T>
+        std::string
+            Index<T>::GetParameter(const char* p_param) const
+        {
+            if (nullptr == p_param) return std::string();
+
+#define DefineFlatParameter(VarName, VarType, DefaultValue, RepresentStr) \
+    else if (SPTAG::Helper::StrUtils::StrEqualIgnoreCase(p_param, RepresentStr)) \
+    { \
+        return SPTAG::Helper::Convert::ConvertToString(VarName); \
+    } \
+
+#include "inc/Core/Flat/ParameterDefinitionList.h"
+#undef DefineFlatParameter
+
+            return std::string();
+        }
+    }
+}
+
+#define DefineVectorValueType(Name, Type) \
+template class SPTAG::Flat::Index<Type>; \
+
+#include "inc/Core/DefinitionList.h"
+#undef DefineVectorValueType
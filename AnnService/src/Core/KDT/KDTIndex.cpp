@@ -34,7 +34,16 @@ namespace SPTAG
             if (!m_pSamples.Load((char*)p_indexBlobs[0].Data())) return ErrorCode::FailedParseValue;
             if (!m_pTrees.LoadTrees((char*)p_indexBlobs[1].Data())) return ErrorCode::FailedParseValue;
             if (!m_pGraph.LoadGraph((char*)p_indexBlobs[2].Data())) return ErrorCode::FailedParseValue;
-            if (p_indexBlobs.size() > 3 && !m_deletedID.Load((char*)p_indexBlobs[3].Data())) return ErrorCode::FailedParseValue;
+            if (p_indexBlobs.size() > 3)
+            {
+                if (!m_deletedID.Load((char*)p_indexBlobs[3].Data())) return ErrorCode::FailedParseValue;
+                std::uint64_t offset = m_deletedID.BufferSize();
+                if (!m_attributes.Load((char*)p_indexBlobs[3].Data() + offset, p_indexBlobs[3].Length() - offset, GetNumSamples())) return ErrorCode::FailedParseValue;
+            }
+            else
+            {
+                m_attributes.Initialize(GetNumSamples());
+            }
 
             omp_set_num_threads(m_iNumberOfThreads);
             m_workSpacePool.reset(new COMMON::WorkSpacePool(max(m_iMaxCheck, m_pGraph.m_iMaxCheckForRefineGraph), GetNumSamples()));
@@ -50,7 +59,12 @@ namespace SPTAG
             if (!m_pSamples.Load(p_folderPath + m_sDataPointsFilename)) return ErrorCode::Fail;
             if (!m_pTrees.LoadTrees(p_folderPath + m_sKDTFilename)) return ErrorCode::Fail;
             if (!m_pGraph.LoadGraph(p_folderPath + m_sGraphFilename)) return ErrorCode::Fail;
-            if (!m_deletedID.Load(p_folderPath + m_sDeleteDataPointsFilename)) return ErrorCode::Fail;
+            {
+                std::cout << "Load DeleteID From " << p_folderPath + m_sDeleteDataPointsFilename << std::endl;
+                std::ifstream input(p_folderPath + m_sDeleteDataPointsFilename, std::ios::binary);
+                if (!input.is_open() || !m_deletedID.Load(input) || !m_attributes.Load(input, GetNumSamples())) return ErrorCode::Fail;
+                input.close();
+            }
 
             omp_set_num_threads(m_iNumberOfThreads);
             m_workSpacePool.reset(new COMMON::WorkSpacePool(max(m_iMaxCheck, m_pGraph.m_iMaxCheckForRefineGraph), GetNumSamples()));
@@ -81,7 +95,12 @@ namespace SPTAG
             if (!m_pSamples.Save(p_folderPath + m_sDataPointsFilename)) return ErrorCode::Fail;
             if (!m_pTrees.SaveTrees(p_folderPath + m_sKDTFilename)) return ErrorCode::Fail;
             if (!m_pGraph.SaveGraph(p_folderPath + m_sGraphFilename)) return ErrorCode::Fail;
-            if (!m_deletedID.Save(p_folderPath + m_sDeleteDataPointsFilename)) return ErrorCode::Fail;
+            {
+                std::cout << "Save DeleteID To " << p_folderPath + m_sDeleteDataPointsFilename << std::endl;
+                std::ofstream output(p_folderPath + m_sDeleteDataPointsFilename, std::ios::binary);
+                if (!output.is_open() || !m_deletedID.Save(output) || !m_attributes.Save(output)) return ErrorCode::Fail;
+                output.close();
+            }
             return ErrorCode::Success;
         }
 
@@ -96,17 +115,21 @@ namespace SPTAG
             if (!m_pSamples.Save(*p_indexStreams[0])) return ErrorCode::Fail;
             if (!m_pTrees.SaveTrees(*p_indexStreams[1])) return ErrorCode::Fail;
             if (!m_pGraph.SaveGraph(*p_indexStreams[2])) return ErrorCode::Fail;
-            if (!m_deletedID.Save(*p_indexStreams[3])) return ErrorCode::Fail;
+            if (!m_deletedID.Save(*p_indexStreams[3]) || !m_attributes.Save(*p_indexStreams[3])) return ErrorCode::Fail;
             return ErrorCode::Success;
         }
 
 #pragma region K-NN search
 
+// With early abandon, a neighbor is scored against upperBound and may come back with a partial distance
+// that is still above upperBound, which neither changes bLocalOpt nor lets the node into the results.
 #define Search(CheckDeleted) \
         std::shared_lock<std::shared_timed_mutex> lock(*(m_pTrees.m_lock)); \
+        const bool bounded = UseBoundedDistance(); \
         m_pTrees.InitSearchTrees(this, p_query, p_space); \
-        m_pTrees.SearchTrees(this, p_query, p_space, m_iNumberOfInitialDynamicPivots); \
+        m_pTrees.SearchTrees(this, p_query, p_space, p_space.m_iNumberOfInitialDynamicPivots); \
         while (!p_space.m_NGQueue.empty()) { \
+            if (p_space.DeadlinePassed()) break; \
             COMMON::HeapCell gnode = p_space.m_NGQueue.pop(); \
             const SizeType *node = m_pGraph[gnode.node]; \
             _mm_prefetch((const char *)node, _MM_HINT_T0); \
@@ -119,20 +142,34 @@ namespace SPTAG
             } \
             float upperBound = max(p_query.worstDist(), gnode.distance); \
             bool bLocalOpt = true; \
-            for (DimensionType i = 0; i < m_pGraph.m_iNeighborhoodSize; i++) { \
-                SizeType nn_index = node[i]; \
-                if (nn_index < 0) break; \
-                if (p_space.CheckAndSet(nn_index)) continue; \
-                float distance2leaf = m_fComputeDistance(p_query.GetTarget(), (m_pSamples)[nn_index], GetFeatureDim()); \
-                if (distance2leaf <= upperBound) bLocalOpt = false; \
-                p_space.m_iNumberOfCheckedLeaves++; \
-                p_space.m_NGQueue.insert(COMMON::HeapCell(nn_index, distance2leaf)); \
+            for (DimensionType i = 0; i < m_pGraph.m_iNeighborhoodSize;) { \
+                SizeType batchNodes[COMMON::DistanceUtils::BatchSize]; \
+                const T* batchRows[COMMON::DistanceUtils::BatchSize]; \
+                float batchDists[COMMON::DistanceUtils::BatchSize]; \
+                int batchCount = 0; \
+                for (; i < m_pGraph.m_iNeighborhoodSize && batchCount < COMMON::DistanceUtils::BatchSize; i++) { \
+                    SizeType nn_index = node[i]; \
+                    if (nn_index < 0) { i = m_pGraph.m_iNeighborhoodSize; break; } \
+                    if (p_space.CheckAndSet(nn_index)) continue; \
+                    batchNodes[batchCount] = nn_index; \
+                    batchRows[batchCount++] = (m_pSamples)[nn_index]; \
+                } \
+                if (bounded) { \
+                    p_space.m_iNumberOfBoundedDistances += batchCount; \
+                    p_space.m_iNumberOfAbandonedDistances += COMMON::DistanceUtils::ComputeDistanceBatchBounded(m_fComputeDistanceBatch, p_query.GetTarget(), batchRows, batchCount, GetFeatureDim(), upperBound, batchDists); \
+                } \
+                else m_fComputeDistanceBatch(p_query.GetTarget(), batchRows, batchCount, GetFeatureDim(), batchDists); \
+                p_space.m_iNumberOfCheckedLeaves += batchCount; \
+                for (int j = 0; j < batchCount; j++) { \
+                    if (batchDists[j] <= upperBound) bLocalOpt = false; \
+                    p_space.m_NGQueue.insert(COMMON::HeapCell(batchNodes[j], batchDists[j])); \
+                } \
             } \
             if (bLocalOpt) p_space.m_iNumOfContinuousNoBetterPropagation++; \
             else p_space.m_iNumOfContinuousNoBetterPropagation = 0; \
-            if (p_space.m_iNumOfContinuousNoBetterPropagation > m_iThresholdOfNumberOfContinuousNoBetterPropagation) { \
+            if (p_space.m_iNumOfContinuousNoBetterPropagation > p_space.m_iContinuousLimit) { \
                 if (p_space.m_iNumberOfTreeCheckedLeaves <= p_space.m_iNumberOfCheckedLeaves / 10) { \
-                    m_pTrees.SearchTrees(this, p_query, p_space, m_iNumberOfOtherDynamicPivots + p_space.m_iNumberOfCheckedLeaves); \
+                    m_pTrees.SearchTrees(this, p_query, p_space, p_space.m_iNumberOfOtherDynamicPivots + p_space.m_iNumberOfCheckedLeaves); \
                 } else if (gnode.distance > p_query.worstDist()) { \
                     break; \
                 } \
@@ -141,17 +178,145 @@ namespace SPTAG
         p_query.SortResult(); \
 
         template <typename T>
-        void Index<T>::SearchIndexWithoutDeleted(COMMON::QueryResultSet<T> &p_query, COMMON::WorkSpace &p_space) const
+        template <typename Q>
+        void Index<T>::SearchIndexWithoutDeleted(Q &p_query, COMMON::WorkSpace &p_space) const
         {
             Search(if (!m_deletedID.Contains(gnode.node)))
         }
 
         template <typename T>
-        void Index<T>::SearchIndexWithDeleted(COMMON::QueryResultSet<T> &p_query, COMMON::WorkSpace &p_space) const
+        template <typename Q>
+        void Index<T>::SearchIndexWithDeleted(Q &p_query, COMMON::WorkSpace &p_space) const
         {
             Search(;)
         }
 
+        // The walk goes through every node as usual, but only the nodes that pass the filter become results.
+        template <typename T>
+        template <typename Q>
+        void Index<T>::SearchIndexWithFilter(Q &p_query, COMMON::WorkSpace &p_space, bool p_searchDeleted) const
+        {
+            if (p_space.ScanAllowedIDs())
+            {
+                ScanAllowedIDs(p_query, p_space, p_searchDeleted);
+                return;
+            }
+            Search(if ((p_searchDeleted || !m_deletedID.Contains(gnode.node)) && p_space.PassesFilter(gnode.node, m_attributes.Get(gnode.node))))
+        }
+
+        template <typename T>
+        template <typename Q>
+        void Index<T>::SearchIndex(Q &p_query, COMMON::WorkSpace &p_space, bool p_searchDeleted) const
+        {
+            if (p_space.m_bFiltered)
+                SearchIndexWithFilter(p_query, p_space, p_searchDeleted);
+            else if (m_deletedID.Count() == 0 || p_searchDeleted)
+                SearchIndexWithDeleted(p_query, p_space);
+            else
+                SearchIndexWithoutDeleted(p_query, p_space);
+        }
+
+        template <typename T>
+        template <typename Q>
+        void Index<T>::ScanAllowedIDs(Q &p_query, COMMON::WorkSpace &p_space, bool p_searchDeleted) const
+        {
+            for (SizeType id : *p_space.m_pAllowedIDs)
+            {
+                if (id < 0 || id >= GetNumSamples() || p_space.CheckAndSet(id)) continue;
+                if ((!p_searchDeleted && m_deletedID.Contains(id)) || !p_space.MatchesAttribute(m_attributes.Get(id)) || p_space.IsExcluded(id)) continue;
+
+                p_query.AddPoint(id, m_fComputeDistance(p_query.GetTarget(), m_pSamples[id], GetFeatureDim()));
+            }
+            p_query.SortResult();
+        }
+
+        template <typename T>
+        void Index<T>::SearchIndexIterative(COMMON::IterativeResultSet<T>& p_query, COMMON::WorkSpace& p_space, bool p_isFirst, int p_count, bool p_searchDeleted, std::vector<BasicResult>& p_results) const
+        {
+            std::shared_lock<std::shared_timed_mutex> lock(*(m_pTrees.m_lock));
+            p_query.StartPage(p_count);
+            if (p_isFirst)
+            {
+                // A short allowed list is scored up front, and there is no walk to continue.
+                if (p_space.ScanAllowedIDs())
+                {
+                    ScanAllowedIDs(p_query, p_space, p_searchDeleted);
+                }
+                else
+                {
+                    m_pTrees.InitSearchTrees(this, p_query, p_space);
+                    m_pTrees.SearchTrees(this, p_query, p_space, p_space.m_iNumberOfInitialDynamicPivots);
+                }
+            }
+
+            // Every popped node joins the found vectors, for this page or a later one, and the walk goes back to
+            // the trees whenever the graph queue runs dry. It stops like a BKT search for the page: after
+            // MaxCheck / 64 nodes in a row farther than the page, or after MaxCheck more vectors. The node it
+            // stops on stays queued.
+            const int maxCheck = p_space.m_iNumberOfCheckedLeaves + p_space.m_iMaxCheck;
+            int noBetter = 0;
+            while (true)
+            {
+                if (p_space.m_NGQueue.empty()) m_pTrees.SearchTrees(this, p_query, p_space, p_space.m_iNumberOfOtherDynamicPivots + p_space.m_iNumberOfCheckedLeaves);
+                if (p_space.m_NGQueue.empty() || p_space.DeadlinePassed()) break;
+
+                COMMON::HeapCell gnode = p_space.m_NGQueue.pop();
+                if (gnode.distance > p_query.PageWorstDist())
+                {
+                    if (++noBetter > p_space.m_iMaxCheck / 64 || p_space.m_iNumberOfCheckedLeaves > maxCheck)
+                    {
+                        p_space.m_NGQueue.insert(gnode);
+                        break;
+                    }
+                }
+                else
+                {
+                    noBetter = 0;
+                }
+
+                const SizeType *node = m_pGraph[gnode.node];
+                _mm_prefetch((const char *)node, _MM_HINT_T0);
+                if ((p_searchDeleted || !m_deletedID.Contains(gnode.node)) && (!p_space.m_bFiltered || p_space.PassesFilter(gnode.node, m_attributes.Get(gnode.node))))
+                {
+                    p_query.AddPoint(gnode.node, gnode.distance);
+                }
+
+                for (DimensionType i = 0; i < m_pGraph.m_iNeighborhoodSize;)
+                {
+                    SizeType batchNodes[COMMON::DistanceUtils::BatchSize];
+                    const T* batchRows[COMMON::DistanceUtils::BatchSize];
+                    float batchDists[COMMON::DistanceUtils::BatchSize];
+                    int batchCount = 0;
+                    for (; i < m_pGraph.m_iNeighborhoodSize && batchCount < COMMON::DistanceUtils::BatchSize; i++)
+                    {
+                        SizeType nn_index = node[i];
+                        if (nn_index < 0) { i = m_pGraph.m_iNeighborhoodSize; break; }
+                        if (p_space.CheckAndSet(nn_index)) continue;
+                        batchNodes[batchCount] = nn_index;
+                        batchRows[batchCount++] = (m_pSamples)[nn_index];
+                    }
+                    m_fComputeDistanceBatch(p_query.GetTarget(), batchRows, batchCount, GetFeatureDim(), batchDists);
+                    p_space.m_iNumberOfCheckedLeaves += batchCount;
+                    for (int j = 0; j < batchCount; j++)
+                    {
+                        p_space.m_NGQueue.insert(COMMON::HeapCell(batchNodes[j], batchDists[j]));
+                    }
+                }
+            }
+            p_query.EndPage(p_results);
+        }
+
+        template<typename T>
+        void Index<T>::ResetWorkSpace(COMMON::WorkSpace& p_space, const SearchOptions& p_options, int p_maxCheck) const
+        {
+            p_space.Reset((p_options.m_maxCheck >= 0) ? p_options.m_maxCheck : p_maxCheck, m_eVisitedTable);
+            p_space.m_iContinuousLimit = (p_options.m_continuousLimit >= 0) ? p_options.m_continuousLimit : m_iThresholdOfNumberOfContinuousNoBetterPropagation;
+            p_space.m_iNumberOfInitialDynamicPivots = (p_options.m_initialDynamicPivots >= 0) ? p_options.m_initialDynamicPivots : m_iNumberOfInitialDynamicPivots;
+            p_space.m_iNumberOfOtherDynamicPivots = (p_options.m_otherDynamicPivots >= 0) ? p_options.m_otherDynamicPivots : m_iNumberOfOtherDynamicPivots;
+            p_space.SetDeadline(p_options.m_deadline);
+            p_space.SetFilter(p_options.m_attributeMask, p_options.m_attributeValue, p_options.m_allowedIDs.get(), p_options.m_excludedIDs.get(), GetNumSamples());
+        }
+
         template<typename T>
         ErrorCode
             Index<T>::SearchIndex(QueryResult &p_query, bool p_searchDeleted) const
@@ -159,13 +324,23 @@ namespace SPTAG
             if (!m_bReady) return ErrorCode::EmptyIndex;
 
             auto workSpace = m_workSpacePool->Rent();
-            workSpace->Reset(m_iMaxCheck);
+            ResetWorkSpace(*workSpace, p_query.GetOptions(), m_iMaxCheck);
+            p_searchDeleted = p_searchDeleted || p_query.GetOptions().m_searchDeleted;
 
-            if (m_deletedID.Count() == 0 || p_searchDeleted)
-                SearchIndexWithDeleted(*((COMMON::QueryResultSet<T>*)&p_query), *workSpace);
+            if (p_query.GetOptions().m_distinctByMetadata && m_pMetadata != nullptr)
+            {
+                COMMON::DistinctResultSet<T> results((const T*)p_query.GetTarget(), p_query.GetResultNum(), m_pMetadata.get());
+                SearchIndex(results, *workSpace, p_searchDeleted);
+                results.CopyTo(p_query);
+            }
             else
-                SearchIndexWithoutDeleted(*((COMMON::QueryResultSet<T>*)&p_query), *workSpace);
+            {
+                SearchIndex(*((COMMON::QueryResultSet<T>*)&p_query), *workSpace, p_searchDeleted);
+            }
 
+            m_iBoundedDistances += workSpace->m_iNumberOfBoundedDistances;
+            m_iAbandonedDistances += workSpace->m_iNumberOfAbandonedDistances;
+            p_query.SetCutShort(workSpace->m_bCutShort);
             m_workSpacePool->Return(workSpace);
 
             if (p_query.WithMeta() && nullptr != m_pMetadata)
@@ -183,7 +358,7 @@ namespace SPTAG
         ErrorCode Index<T>::RefineSearchIndex(QueryResult &p_query, bool p_searchDeleted) const
         {
             auto workSpace = m_workSpacePool->Rent();
-            workSpace->Reset(m_pGraph.m_iMaxCheckForRefineGraph);
+            ResetWorkSpace(*workSpace, p_query.GetOptions(), m_pGraph.m_iMaxCheckForRefineGraph);
 
             if (m_deletedID.Count() == 0 || p_searchDeleted)
                 SearchIndexWithDeleted(*((COMMON::QueryResultSet<T>*)&p_query), *workSpace);
@@ -193,6 +368,46 @@ namespace SPTAG
             m_workSpacePool->Return(workSpace);
             return ErrorCode::Success;
         }
+
+        template <typename T>
+        ErrorCode Index<T>::SearchIndexWithinRadius(QueryResult &p_query, float p_radius, bool p_searchDeleted) const
+        {
+            if (!m_bReady) return ErrorCode::EmptyIndex;
+
+            auto workSpace = m_workSpacePool->Rent();
+            ResetWorkSpace(*workSpace, p_query.GetOptions(), m_iMaxCheck);
+            p_searchDeleted = p_searchDeleted || p_query.GetOptions().m_searchDeleted;
+
+            // Stops after MaxCheck or once the continuous no better propagation limit is reached outside the radius.
+            COMMON::RadiusResultSet<T> results((const T*)p_query.GetTarget(), p_radius);
+            SearchIndex(results, *workSpace, p_searchDeleted);
+
+            m_iBoundedDistances += workSpace->m_iNumberOfBoundedDistances;
+            m_iAbandonedDistances += workSpace->m_iNumberOfAbandonedDistances;
+            const std::vector<BasicResult>& found = results.GetResults();
+            p_query.Init(p_query.GetTarget(), static_cast<int>(found.size()), p_query.WithMeta());
+            p_query.SetCutShort(workSpace->m_bCutShort);
+            m_workSpacePool->Return(workSpace);
+
+            for (int i = 0; i < p_query.GetResultNum(); ++i)
+            {
+                p_query.SetResult(i, found[i].VID, found[i].Dist);
+                if (p_query.WithMeta() && nullptr != m_pMetadata) p_query.SetMetadata(i, m_pMetadata->GetMetadata(found[i].VID));
+            }
+            return ErrorCode::Success;
+        }
+
+        template <typename T>
+        std::shared_ptr<ResultIterator> Index<T>::GetIterator(const void* p_target, const SearchOptions& p_options) const
+        {
+            if (!m_bReady) return nullptr;
+
+            auto workSpace = m_workSpacePool->Rent();
+            ResetWorkSpace(*workSpace, p_options, m_iMaxCheck);
+            // The pages together can visit far more vectors than the hash table is sized for.
+            workSpace->UseEpochVisitedTable();
+            return std::make_shared<COMMON::IndexResultIterator<T, Index<T>>>(this, m_workSpacePool.get(), workSpace, (const T*)p_target, p_options.m_searchDeleted);
+        }
 #pragma endregion
 
         template <typename T>
@@ -204,6 +419,7 @@ namespace SPTAG
 
             m_pSamples.Initialize(p_vectorNum, p_dimension, (T*)p_data, false);
             m_deletedID.Initialize(p_vectorNum);
+            m_attributes.Initialize(p_vectorNum);
 
             if (DistCalcMethod::Cosine == m_iDistCalcMethod)
             {
@@ -267,6 +483,7 @@ namespace SPTAG
             if (nullptr != m_pMetadata && ErrorCode::Success != m_pMetadata->RefineMetadata(indices, ptr->m_pMetadata)) return ErrorCode::Fail;
 
             ptr->m_deletedID.Initialize(newR);
+            if (false == m_attributes.Refine(indices, ptr->m_attributes)) return ErrorCode::Fail;
             COMMON::KDTree* newtree = &(ptr->m_pTrees);
             (*newtree).BuildTrees<T>(ptr);
             m_pGraph.RefineGraph<T>(this, indices, reverseIndices, nullptr, &(ptr->m_pGraph));
@@ -320,6 +537,7 @@ namespace SPTAG
             COMMON::Labelset newDeletedID;
             newDeletedID.Initialize(newR);
             newDeletedID.Save(*p_indexStreams[3]);
+            if (false == m_attributes.Refine(indices, *p_indexStreams[3])) return ErrorCode::Fail;
             return ErrorCode::Success;
         }
 
@@ -385,6 +603,16 @@ namespace SPTAG
             return ErrorCode::VectorNotFound;
         }
 
+        template <typename T>
+        ErrorCode Index<T>::SetAttribute(const SizeType idx, std::uint64_t p_attribute)
+        {
+            std::lock_guard<std::mutex> lock(m_dataAddLock);
+            if (idx < 0 || idx >= GetNumSamples()) return ErrorCode::VectorNotFound;
+
+            m_attributes.Set(idx, p_attribute);
+            return ErrorCode::Success;
+        }
+
         template <typename T>
         ErrorCode Index<T>::AddIndex(const void* p_data, SizeType p_vectorNum, DimensionType p_dimension, std::shared_ptr<MetadataSet> p_metadataSet, bool p_withMetaIndex)
         {
@@ -412,11 +640,13 @@ namespace SPTAG
 
                 if (m_pSamples.AddBatch((const T*)p_data, p_vectorNum) != ErrorCode::Success ||
                     m_pGraph.AddBatch(p_vectorNum) != ErrorCode::Success ||
-                    m_deletedID.AddBatch(p_vectorNum) != ErrorCode::Success) {
+                    m_deletedID.AddBatch(p_vectorNum) != ErrorCode::Success ||
+                    m_attributes.AddBatch(p_vectorNum) != ErrorCode::Success) {
                     std::cout << "Memory Error: Cannot alloc space for vectors" << std::endl;
                     m_pSamples.SetR(begin);
                     m_pGraph.SetR(begin);
                     m_deletedID.SetR(begin);
+                    m_attributes.SetR(begin);
                     return ErrorCode::MemoryOverFlow;
                 }
                 if (DistCalcMethod::Cosine == m_iDistCalcMethod)
@@ -475,7 +705,8 @@ namespace SPTAG
 #undef DefineKDTParameter
 
             m_fComputeDistance = COMMON::DistanceCalcSelector<T>(m_iDistCalcMethod);
-            m_iBaseSquare = (m_iDistCalcMethod == DistCalcMethod::Cosine) ? COMMON::Utils::GetBase<T>() * COMMON::Utils::GetBase<T>() : 1;
+            m_fComputeDistanceBatch = COMMON::DistanceBatchCalcSelector<T>(m_iDistCalcMethod);
+            m_iBaseSquare = (m_iDistCalcMethod == DistCalcMethod::Cosine || m_iDistCalcMethod == DistCalcMethod::InnerProduct) ? COMMON::Utils::GetBase<T>() * COMMON::Utils::GetBase<T>() : 1;
             return ErrorCode::Success;
         }
 
@@ -10,6 +10,7 @@
 
 #include "inc/Core/BKT/Index.h"
 #include "inc/Core/KDT/Index.h"
+#include "inc/Core/Flat/Index.h"
 #include <fstream>
 
 
@@ -144,7 +145,8 @@ VectorIndex::SaveIndex(std::string& p_config, const std::vector<ByteArray>& p_in
     }
     else 
     {
-        if (m_pMetadata != nullptr && p_indexStreams.size() > 5)
+        // The metadata streams follow the ones of the index data.
+        if (m_pMetadata != nullptr && p_indexStreams.size() >= BufferSize()->size() + 2)
         {
             ret = m_pMetadata->SaveMetadata(*p_indexStreams[p_indexStreams.size() - 2], *p_indexStreams[p_indexStreams.size() - 1]);
         }
@@ -198,8 +200,9 @@ VectorIndex::BuildIndex(std::shared_ptr<VectorSet> p_vectorSet,
         return ErrorCode::Fail;
     }
 
-    BuildIndex(p_vectorSet->GetData(), p_vectorSet->Count(), p_vectorSet->Dimension());
+    // Set before the build, which may renumber the vectors along with their metadata.
     m_pMetadata = std::move(p_metadataSet);
+    BuildIndex(p_vectorSet->GetData(), p_vectorSet->Count(), p_vectorSet->Dimension());
     if (p_withMetaIndex && m_pMetadata != nullptr) 
     {
         BuildMetaMapping();
@@ -220,6 +223,17 @@ VectorIndex::SearchIndex(const void* p_vector, int p_vectorCount, int p_neighbor
 }
 
 
+ErrorCode
+VectorIndex::SearchIndexGroup(QueryResult** p_queries, int p_queryCount, bool p_searchDeleted) const {
+    ErrorCode ret = ErrorCode::Success;
+    for (int i = 0; i < p_queryCount; i++) {
+        ErrorCode code = SearchIndex(*p_queries[i], p_searchDeleted);
+        if (code != ErrorCode::Success) ret = code;
+    }
+    return ret;
+}
+
+
 ErrorCode 
 VectorIndex::AddIndex(std::shared_ptr<VectorSet> p_vectorSet, std::shared_ptr<MetadataSet> p_metadataSet, bool p_withMetaIndex) {
     if (nullptr == p_vectorSet || p_vectorSet->GetValueType() != GetVectorValueType())
@@ -310,6 +324,19 @@ VectorIndex::CreateInstance(IndexAlgoType p_algo, VectorValueType p_valuetype)
     case VectorValueType::Name: \
         return std::shared_ptr<VectorIndex>(new KDT::Index<Type>); \
 
+#include "inc/Core/DefinitionList.h"
+#undef DefineVectorValueType
+
+        default: break;
+        }
+    }
+    else if (p_algo == IndexAlgoType::Flat) {
+        switch (p_valuetype)
+        {
+#define DefineVectorValueType(Name, Type) \
+    case VectorValueType::Name: \
+        return std::shared_ptr<VectorIndex>(new Flat::Index<Type>); \
+
 #include "inc/Core/DefinitionList.h"
 #undef DefineVectorValueType
 
@@ -378,7 +405,7 @@ VectorIndex::LoadIndex(const std::string& p_config, const std::vector<ByteArray>
     ret = p_vectorIndex->LoadIndexDataFromMemory(p_indexBlobs);
     if (ErrorCode::Success != ret) return ret;
 
-    if (iniReader.DoesSectionExist("MetaData") && p_indexBlobs.size() > 4)
+    if (iniReader.DoesSectionExist("MetaData") && p_indexBlobs.size() >= p_vectorIndex->BufferSize()->size() + 2)
     {
         ByteArray pMetaIndex = p_indexBlobs[p_indexBlobs.size() - 1];
         p_vectorIndex->m_pMetadata.reset(new MemMetadataSet(p_indexBlobs[p_indexBlobs.size() - 2],
@@ -409,6 +436,12 @@ std::uint64_t VectorIndex::EstimatedVectorCount(std::uint64_t p_memory, Dimensio
     else if (p_algo == IndexAlgoType::KDT) {
         treeNodeSize = sizeof(SizeType) * 2 + sizeof(DimensionType) + sizeof(float);
     }
+    else if (p_algo == IndexAlgoType::Flat) {
+        // Flat keeps neither trees nor a graph.
+        treeNodeSize = 0;
+        p_treeNumber = 0;
+        p_neighborhoodSize = 0;
+    }
     else {
         return 0;
     }
@@ -426,6 +459,12 @@ std::uint64_t VectorIndex::EstimatedMemoryUsage(std::uint64_t p_vectorCount, Dim
     else if (p_algo == IndexAlgoType::KDT) {
         treeNodeSize = sizeof(SizeType) * 2 + sizeof(DimensionType) + sizeof(float);
     }
+    else if (p_algo == IndexAlgoType::Flat) {
+        // Flat keeps neither trees nor a graph.
+        treeNodeSize = 0;
+        p_treeNumber = 0;
+        p_neighborhoodSize = 0;
+    }
     else {
         return 0;
     }
@@ -15,7 +15,7 @@
 using namespace SPTAG;
 
 template <typename T>
-float CalcRecall(std::vector<QueryResult> &results, const std::vector<std::set<SizeType>> &truth, SizeType NumQuerys, int K, std::ofstream& log)
+float CalcRecall(const VectorIndex& index, std::vector<QueryResult> &results, const std::vector<std::set<SizeType>> &truth, SizeType NumQuerys, int K, std::ofstream& log)
 {
     float meanrecall = 0, minrecall = MaxDist, maxrecall = 0, stdrecall = 0;
     std::vector<float> thisrecall(NumQuerys, 0);
@@ -25,7 +25,9 @@ float CalcRecall(std::vector<QueryResult> &results, const std::vector<std::set<S
         {
             for (int j = 0; j < K; j++)
             {
-                if (results[i].GetResult(j)->VID == id)
+                // The truth file counts vectors in input order, which an index may have renumbered.
+                SizeType vid = results[i].GetResult(j)->VID;
+                if (vid >= 0 && index.GetOriginalID(vid) == id)
                 {
                     thisrecall[i] += 1;
                     break;
@@ -109,7 +111,7 @@ int Process(Helper::IniReader& reader, VectorIndex& index)
     clock_t * latencies = new clock_t[numQuerys + 1];
 
     int base = 1;
-    if (index.GetDistCalcMethod() == DistCalcMethod::Cosine) {
+    if (index.GetDistCalcMethod() == DistCalcMethod::Cosine || index.GetDistCalcMethod() == DistCalcMethod::InnerProduct) {
         base = COMMON::Utils::GetBase<T>();
     }
     int basesquare = base * base;
@@ -173,7 +175,7 @@ int Process(Helper::IniReader& reader, VectorIndex& index)
             float recall = 0;
             if (ftruth.is_open())
             {
-                recall = CalcRecall<T>(results, truth, numQuerys, K, log);
+                recall = CalcRecall<T>(index, results, truth, numQuerys, K, log);
             }
 
 #ifndef _MSC_VER
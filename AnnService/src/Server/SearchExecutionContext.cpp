@@ -45,7 +45,9 @@ SearchExecutionContext::SearchExecutionContext(const std::shared_ptr<const Servi
       m_vectorDimension(0),
       m_inputValueType(VectorValueType::Undefined),
       m_extractMetadata(false),
-      m_resultNum(p_serviceSettings->m_defaultMaxResultNumber)
+      m_resultNum(p_serviceSettings->m_defaultMaxResultNumber),
+      m_radiusSearch(false),
+      m_radius(0)
 {
 }
 
@@ -103,6 +105,70 @@ SearchExecutionContext::ExtractOption()
         {
             Helper::Convert::ConvertStringTo<SizeType>(optionPair.second, m_resultNum);
         }
+        else if (Helper::StrUtils::StrEqualIgnoreCase(optionPair.first, "maxcheck"))
+        {
+            Helper::Convert::ConvertStringTo<int>(optionPair.second, m_searchOptions.m_maxCheck);
+        }
+        else if (Helper::StrUtils::StrEqualIgnoreCase(optionPair.first, "thresholdofnumberofcontinuousnobetterpropagation"))
+        {
+            Helper::Convert::ConvertStringTo<int>(optionPair.second, m_searchOptions.m_continuousLimit);
+        }
+        else if (Helper::StrUtils::StrEqualIgnoreCase(optionPair.first, "numberofinitialdynamicpivots"))
+        {
+            Helper::Convert::ConvertStringTo<int>(optionPair.second, m_searchOptions.m_initialDynamicPivots);
+        }
+        else if (Helper::StrUtils::StrEqualIgnoreCase(optionPair.first, "numberofotherdynamicpivots"))
+        {
+            Helper::Convert::ConvertStringTo<int>(optionPair.second, m_searchOptions.m_otherDynamicPivots);
+        }
+        else if (Helper::StrUtils::StrEqualIgnoreCase(optionPair.first, "searchdeleted"))
+        {
+            Helper::Convert::ConvertStringTo<bool>(optionPair.second, m_searchOptions.m_searchDeleted);
+        }
+        else if (Helper::StrUtils::StrEqualIgnoreCase(optionPair.first, "timebudget"))
+        {
+            // Microseconds from now, after which the search returns what it has found so far.
+            std::int64_t budget = 0;
+            if (Helper::Convert::ConvertStringTo<std::int64_t>(optionPair.second, budget) && budget > 0)
+            {
+                m_searchOptions.SetTimeBudget(std::chrono::microseconds(budget));
+            }
+        }
+        else if (Helper::StrUtils::StrEqualIgnoreCase(optionPair.first, "attributemask"))
+        {
+            Helper::Convert::ConvertStringTo<std::uint64_t>(optionPair.second, m_searchOptions.m_attributeMask);
+        }
+        else if (Helper::StrUtils::StrEqualIgnoreCase(optionPair.first, "attributevalue"))
+        {
+            Helper::Convert::ConvertStringTo<std::uint64_t>(optionPair.second, m_searchOptions.m_attributeValue);
+        }
+        else if (Helper::StrUtils::StrEqualIgnoreCase(optionPair.first, "radius"))
+        {
+            m_radiusSearch = Helper::Convert::ConvertStringTo<float>(optionPair.second, m_radius);
+        }
+        else if (Helper::StrUtils::StrEqualIgnoreCase(optionPair.first, "excludeids"))
+        {
+            std::shared_ptr<std::unordered_set<SizeType>> excludedIDs(new std::unordered_set<SizeType>());
+            std::string ids(optionPair.second);
+            std::size_t begin = 0;
+            while (begin < ids.size())
+            {
+                std::size_t end = ids.find(',', begin);
+                if (end == std::string::npos) end = ids.size();
+
+                SizeType id;
+                if (end > begin && Helper::Convert::ConvertStringTo<SizeType>(ids.substr(begin, end - begin).c_str(), id))
+                {
+                    excludedIDs->insert(id);
+                }
+                begin = end + 1;
+            }
+            m_searchOptions.m_excludedIDs = std::move(excludedIDs);
+        }
+        else if (Helper::StrUtils::StrEqualIgnoreCase(optionPair.first, "distinctmetadata"))
+        {
+            Helper::Convert::ConvertStringTo<bool>(optionPair.second, m_searchOptions.m_distinctByMetadata);
+        }
     }
 
     return ErrorCode::Success;
@@ -218,3 +284,24 @@ SearchExecutionContext::GetExtractMetadata() const
 {
     return m_extractMetadata;
 }
+
+
+const SearchOptions&
+SearchExecutionContext::GetSearchOptions() const
+{
+    return m_searchOptions;
+}
+
+
+const bool
+SearchExecutionContext::IsRadiusSearch() const
+{
+    return m_radiusSearch;
+}
+
+
+const float
+SearchExecutionContext::GetRadius() const
+{
+    return m_radius;
+}
@@ -3,6 +3,8 @@
 
 #include "inc/Server/SearchExecutor.h"
 
+#include <algorithm>
+
 using namespace SPTAG;
 using namespace SPTAG::Service;
 
@@ -34,7 +36,75 @@ SearchExecutor::Execute()
 
 
 void
-SearchExecutor::ExecuteInternal()
+SearchExecutor::ExecuteGroup(const std::vector<std::unique_ptr<SearchExecutor>>& p_executors)
+{
+    std::vector<SearchExecutor*> prepared;
+    std::vector<std::shared_ptr<VectorIndex>> indexes;
+    for (const auto& executor : p_executors)
+    {
+        if (!executor->Prepare())
+        {
+            continue;
+        }
+
+        if (executor->m_executionContext->IsRadiusSearch())
+        {
+            executor->SearchSelectedIndexes();
+            continue;
+        }
+
+        prepared.push_back(executor.get());
+        for (const auto& vectorIndex : executor->m_selectedIndex)
+        {
+            if (std::find(indexes.begin(), indexes.end(), vectorIndex) == indexes.end())
+            {
+                indexes.push_back(vectorIndex);
+            }
+        }
+    }
+
+    for (const auto& vectorIndex : indexes)
+    {
+        std::vector<SearchExecutor*> owners;
+        std::vector<std::unique_ptr<QueryResult>> results;
+        std::vector<QueryResult*> queries;
+        for (SearchExecutor* executor : prepared)
+        {
+            const auto& selected = executor->m_selectedIndex;
+            if (std::find(selected.begin(), selected.end(), vectorIndex) == selected.end())
+            {
+                continue;
+            }
+
+            owners.push_back(executor);
+            results.emplace_back(new QueryResult(executor->m_executionContext->GetVector().Data(),
+                                                 executor->m_executionContext->GetResultNum(),
+                                                 executor->m_executionContext->GetExtractMetadata()));
+            results.back()->SetOptions(executor->m_executionContext->GetSearchOptions());
+            queries.push_back(results.back().get());
+        }
+
+        if (ErrorCode::Success == vectorIndex->SearchIndexGroup(queries.data(), static_cast<int>(queries.size())))
+        {
+            for (std::size_t i = 0; i < owners.size(); ++i)
+            {
+                owners[i]->m_executionContext->AddResults(vectorIndex->GetIndexName(), *results[i]);
+            }
+        }
+    }
+
+    for (const auto& executor : p_executors)
+    {
+        if (bool(executor->m_callback))
+        {
+            executor->m_callback(std::move(executor->m_executionContext));
+        }
+    }
+}
+
+
+bool
+SearchExecutor::Prepare()
 {
     m_executionContext.reset(new SearchExecutionContext(c_serviceContext->GetServiceSettings()));
 
@@ -45,35 +115,70 @@ SearchExecutor::ExecuteInternal()
 
     if (m_selectedIndex.empty())
     {
-        return;
+        return false;
     }
 
-    const auto& firstIndex = m_selectedIndex.front();
+    const auto firstIndex = m_selectedIndex.front();
 
     if (ErrorCode::Success != m_executionContext->ExtractVector(firstIndex->GetVectorValueType()))
     {
-        return;
+        return false;
     }
 
     if (m_executionContext->GetVectorDimension() != firstIndex->GetFeatureDim())
     {
-        return;
+        return false;
     } 
 
+    m_selectedIndex.erase(std::remove_if(m_selectedIndex.begin(),
+                                         m_selectedIndex.end(),
+                                         [&firstIndex](const std::shared_ptr<VectorIndex>& p_index)
+                                         {
+                                             return p_index->GetVectorValueType() != firstIndex->GetVectorValueType()
+                                                 || p_index->GetFeatureDim() != firstIndex->GetFeatureDim();
+                                         }),
+                          m_selectedIndex.end());
+    return true;
+}
+
+
+void
+SearchExecutor::ExecuteInternal()
+{
+    if (!Prepare())
+    {
+        return;
+    }
+
+    SearchSelectedIndexes();
+}
+
+
+void
+SearchExecutor::SearchSelectedIndexes()
+{
+    const bool radiusSearch = m_executionContext->IsRadiusSearch();
+
+    // A radius search sizes the query to the vectors it finds in each index.
     QueryResult query(m_executionContext->GetVector().Data(),
-                      m_executionContext->GetResultNum(),
+                      radiusSearch ? 0 : m_executionContext->GetResultNum(),
                       m_executionContext->GetExtractMetadata());
+    query.SetOptions(m_executionContext->GetSearchOptions());
 
     for (const auto& vectorIndex : m_selectedIndex)
     {
-        if (vectorIndex->GetVectorValueType() != firstIndex->GetVectorValueType()
-            || vectorIndex->GetFeatureDim() != firstIndex->GetFeatureDim())
+        ErrorCode ret;
+        if (radiusSearch)
         {
-            continue;
+            ret = vectorIndex->SearchIndexWithinRadius(query, m_executionContext->GetRadius());
+        }
+        else
+        {
+            query.Reset();
+            ret = vectorIndex->SearchIndex(query);
         }
 
-        query.Reset();
-        if (ErrorCode::Success == vectorIndex->SearchIndex(query))
+        if (ErrorCode::Success == ret)
         {
             m_executionContext->AddResults(vectorIndex->GetIndexName(), query);
         }
@@ -121,7 +121,11 @@ SearchService::RunSocketMode()
     handlerMap->emplace(Socket::PacketType::SearchRequest,
                         [this](Socket::ConnectionID p_srcID, Socket::Packet p_packet)
                         {
-                            boost::asio::post(*m_threadPool, std::bind(&SearchService::SearchHanlder, this, p_srcID, std::move(p_packet)));
+                            {
+                                std::lock_guard<std::mutex> lock(m_pendingSearchesMutex);
+                                m_pendingSearches.emplace_back(p_srcID, std::move(p_packet));
+                            }
+                            boost::asio::post(*m_threadPool, std::bind(&SearchService::SearchHanlder, this));
                         });
 
     m_socketServer.reset(new Socket::Server(m_serviceContext->GetServiceSettings()->m_listenAddr,
@@ -203,30 +207,55 @@ SearchService::RunInteractiveMode()
 
 
 void
-SearchService::SearchHanlder(Socket::ConnectionID p_localConnectionID, Socket::Packet p_packet)
+SearchService::SearchHanlder()
 {
-    if (p_packet.Header().m_bodyLength == 0)
+    std::vector<std::pair<Socket::ConnectionID, Socket::Packet>> requests;
     {
-        return;
+        std::lock_guard<std::mutex> lock(m_pendingSearchesMutex);
+        std::size_t count = min(m_pendingSearches.size(),
+                                static_cast<std::size_t>(max((SizeType)1, m_serviceContext->GetServiceSettings()->m_searchGroupSize)));
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            requests.emplace_back(std::move(m_pendingSearches.front()));
+            m_pendingSearches.pop_front();
+        }
     }
 
-    if (Socket::c_invalidConnectionID == p_packet.Header().m_connectionID)
+    std::vector<std::unique_ptr<SearchExecutor>> executors;
+    for (auto& request : requests)
     {
-        p_packet.Header().m_connectionID = p_localConnectionID;
-    }
+        Socket::Packet& packet = request.second;
+        if (packet.Header().m_bodyLength == 0)
+        {
+            continue;
+        }
 
-    Socket::RemoteQuery remoteQuery;
-    remoteQuery.Read(p_packet.Body());
+        if (Socket::c_invalidConnectionID == packet.Header().m_connectionID)
+        {
+            packet.Header().m_connectionID = request.first;
+        }
 
-    auto callback = std::bind(&SearchService::SearchHanlderCallback,
-                              this,
-                              std::placeholders::_1,
-                              std::move(p_packet));
+        Socket::RemoteQuery remoteQuery;
+        remoteQuery.Read(packet.Body());
 
-    SearchExecutor executor(std::move(remoteQuery.m_queryString),
-                            m_serviceContext,
-                            callback);
-    executor.Execute();
+        auto callback = std::bind(&SearchService::SearchHanlderCallback,
+                                  this,
+                                  std::placeholders::_1,
+                                  std::move(packet));
+
+        executors.emplace_back(new SearchExecutor(std::move(remoteQuery.m_queryString),
+                                                  m_serviceContext,
+                                                  callback));
+    }
+
+    if (executors.size() == 1)
+    {
+        executors.front()->Execute();
+    }
+    else if (!executors.empty())
+    {
+        SearchExecutor::ExecuteGroup(executors);
+    }
 }
 
 
@@ -25,6 +25,7 @@ ServiceContext::ServiceContext(const std::string& p_configFilePath)
     m_settings->m_listenPort = iniReader.GetParameter("Service", "ListenPort", std::string("8000"));
     m_settings->m_threadNum = iniReader.GetParameter("Service", "ThreadNumber", static_cast<std::uint32_t>(8));
     m_settings->m_socketThreadNum = iniReader.GetParameter("Service", "SocketThreadNumber", static_cast<std::uint32_t>(8));
+    m_settings->m_searchGroupSize = iniReader.GetParameter("Service", "SearchGroupSize", static_cast<SizeType>(1));
 
     m_settings->m_defaultMaxResultNumber = iniReader.GetParameter("QueryConfig", "DefaultMaxResultNumber", static_cast<SizeType>(10));
     m_settings->m_vectorSeparator = iniReader.GetParameter("QueryConfig", "DefaultSeparator", std::string("|"));
@@ -121,6 +121,8 @@ RemoteSearchResult::EstimateBufferSize() const
         }
     }
 
+    sum += sizeof(bool) * m_allIndexResults.size();
+
     return sum;
 }
 
@@ -155,6 +157,11 @@ RemoteSearchResult::Write(std::uint8_t* p_buffer) const
         }
     }
 
+    for (const auto& indexRes : m_allIndexResults)
+    {
+        p_buffer = SimpleSerialization::SimpleWriteBuffer(indexRes.m_results.IsCutShort(), p_buffer);
+    }
+
     return p_buffer;
 }
 
@@ -206,5 +213,15 @@ RemoteSearchResult::Read(const std::uint8_t* p_buffer)
         }
     }
 
+    if (mirrorVer >= 1)
+    {
+        for (auto& indexRes : m_allIndexResults)
+        {
+            bool cutShort = false;
+            p_buffer = SimpleSerialization::SimpleReadBuffer(p_buffer, cutShort);
+            indexRes.m_results.SetCutShort(cutShort);
+        }
+    }
+
     return p_buffer;
 }
@@ -0,0 +1,342 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+// Times the distance kernels and writes one tab separated line per measurement to stdout:
+//
+//   type  method  kernel  dim  alignment  residency  calls  ns_per_call  gb_per_s
+//
+// kernel is Scalar (the plain loop below), one of the per instruction set kernels, Dispatch
+// (DistanceUtils::ComputeL2Distance / ComputeCosineDistance, i.e. runtime selection on every call)
+// or Fixed (the fixed dimension kernel, when DistanceUtils has one for the type and dimension).
+// Binary vectors only have Hamming kernels, so they are timed under that method instead.
+// Rows are read in a random order from a working set that either fits in L1 or is far larger
+// than the last level cache; unaligned rows start one element past a 64 byte boundary.
+// gb_per_s counts the bytes of both vectors of every call.
+
+#include "inc/Core/Common.h"
+#include "inc/Core/Common/DistanceUtils.h"
+#include "inc/Helper/ArgumentsParser.h"
+#include "inc/Helper/CommonHelper.h"
+
+#include <algorithm>
+#include <bitset>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace SPTAG;
+using namespace SPTAG::COMMON;
+
+namespace
+{
+
+class BenchmarkOptions : public Helper::ArgumentsParser
+{
+public:
+    BenchmarkOptions()
+        : m_dimensions("32,96,100,128,256,768,1024"),
+          m_valueTypes("Int8,UInt8,Int16,Float,Float16,BFloat16,Binary"),
+          m_minTimeMs(50),
+          m_dramMB(256)
+    {
+        AddOptionalOption(m_dimensions, "-d", "--dimensions", "Comma separated vector dimensions.");
+        AddOptionalOption(m_valueTypes, "-v", "--valuetypes", "Comma separated value types.");
+        AddOptionalOption(m_minTimeMs, "-t", "--time", "Minimum milliseconds per measurement.");
+        AddOptionalOption(m_dramMB, "-m", "--memory", "Megabytes of the DRAM resident working set.");
+    }
+
+    virtual ~BenchmarkOptions()
+    {
+    }
+
+    std::string m_dimensions;
+
+    std::string m_valueTypes;
+
+    int m_minTimeMs;
+
+    int m_dramMB;
+};
+
+
+template<typename T>
+using Kernel = float(*)(const T*, const T*, DimensionType);
+
+template<typename T>
+struct NamedKernel
+{
+    const char* name;
+    Kernel<T> kernel;
+};
+
+
+// Reference loops in the same form as Test/src/DistanceTest.cpp.
+template<typename T>
+float ScalarL2Distance(const T* pX, const T* pY, DimensionType length)
+{
+    float diff = 0;
+    const T* pEnd = pX + length;
+    while (pX < pEnd) {
+        float c = ((float)(*pX++) - (float)(*pY++)); diff += c * c;
+    }
+    return diff;
+}
+
+template<typename T>
+float ScalarCosineDistance(const T* pX, const T* pY, DimensionType length)
+{
+    float sum = 0;
+    const T* pEnd = pX + length;
+    while (pX < pEnd) sum += (float)(*pX++) * (float)(*pY++);
+    return (float)Utils::GetBase<T>() * Utils::GetBase<T>() - sum;
+}
+
+
+template<typename T>
+std::vector<DistCalcMethod> BenchmarkMethods()
+{
+    return { DistCalcMethod::L2, DistCalcMethod::Cosine };
+}
+
+template<>
+std::vector<DistCalcMethod> BenchmarkMethods<Binary>()
+{
+    return { DistCalcMethod::Hamming };
+}
+
+
+template<typename T>
+void AddKernel(std::vector<NamedKernel<T>>& p_kernels, const char* p_name, DistCalcMethod p_method, Kernel<T> p_l2, Kernel<T> p_cosine)
+{
+    p_kernels.push_back({ p_name, (p_method == DistCalcMethod::L2) ? p_l2 : p_cosine });
+}
+
+template<typename T>
+std::vector<NamedKernel<T>> CollectKernels(DistCalcMethod p_method, DimensionType p_dimension)
+{
+    std::vector<NamedKernel<T>> kernels;
+    AddKernel<T>(kernels, "Scalar", p_method, &ScalarL2Distance<T>, &ScalarCosineDistance<T>);
+    AddKernel<T>(kernels, "SSE", p_method, &DistanceUtils::ComputeL2Distance_SSE, &DistanceUtils::ComputeCosineDistance_SSE);
+
+    bool avx = (sizeof(T) == 4) ? InstructionSet::AVX() :
+        (InstructionSet::AVX2() && (!std::is_same<T, Float16>::value || InstructionSet::F16C()));
+    if (avx) AddKernel<T>(kernels, "AVX", p_method, &DistanceUtils::ComputeL2Distance_AVX, &DistanceUtils::ComputeCosineDistance_AVX);
+    if (InstructionSet::AVX512()) AddKernel<T>(kernels, "AVX512", p_method, &DistanceUtils::ComputeL2Distance_AVX512, &DistanceUtils::ComputeCosineDistance_AVX512);
+    if (sizeof(T) == 1 && InstructionSet::AVX512VNNI())
+        AddKernel<T>(kernels, "AVX512VNNI", p_method, &DistanceUtils::ComputeL2Distance_AVX512VNNI, &DistanceUtils::ComputeCosineDistance_AVX512VNNI);
+
+    AddKernel<T>(kernels, "Dispatch", p_method, &DistanceUtils::ComputeL2Distance<T>, &DistanceUtils::ComputeCosineDistance<T>);
+
+    Kernel<T> fixedPair;
+    void(*fixedBatch)(const T*, const T* const*, int, DimensionType, float*);
+    if (DistanceUtils::SelectFixedDimensionKernels<T>(p_method, p_dimension, fixedPair, fixedBatch))
+        kernels.push_back({ "Fixed", fixedPair });
+    return kernels;
+}
+
+
+float ScalarHammingDistance(const Binary* pX, const Binary* pY, DimensionType length)
+{
+    float diff = 0;
+    for (DimensionType i = 0; i < length; i++) diff += (float)std::bitset<8>(pX[i].bits ^ pY[i].bits).count();
+    return diff;
+}
+
+float DispatchHammingDistance(const Binary* pX, const Binary* pY, DimensionType length)
+{
+    return DistanceCalcSelector<Binary>(DistCalcMethod::Hamming)(pX, pY, length);
+}
+
+template<>
+std::vector<NamedKernel<Binary>> CollectKernels<Binary>(DistCalcMethod p_method, DimensionType p_dimension)
+{
+    std::vector<NamedKernel<Binary>> kernels;
+    kernels.push_back({ "Scalar", &ScalarHammingDistance });
+    kernels.push_back({ "SSE", &DistanceUtils::ComputeHammingDistance_SSE<Binary> });
+    if (InstructionSet::POPCNT()) kernels.push_back({ "POPCNT", &DistanceUtils::ComputeHammingDistance_POPCNT<Binary> });
+    if (InstructionSet::AVX512VPOPCNTDQ()) kernels.push_back({ "AVX512VPOPCNTDQ", &DistanceUtils::ComputeHammingDistance_AVX512VPOPCNTDQ<Binary> });
+    kernels.push_back({ "Dispatch", &DispatchHammingDistance });
+    return kernels;
+}
+
+
+// A set of rows in a random visiting order. Rows are padded to whole cache lines so that the
+// only difference between the aligned and the unaligned set is the offset of the first row.
+template<typename T>
+class WorkingSet
+{
+public:
+    WorkingSet(DimensionType p_dimension, std::size_t p_bytes, bool p_aligned, std::mt19937& p_rng)
+        : m_dimension(p_dimension)
+    {
+        std::size_t rowBytes = ((sizeof(T) * p_dimension + 63) / 64) * 64;
+        m_stride = rowBytes / sizeof(T);
+        m_rows = max((SizeType)(p_bytes / rowBytes), (SizeType)2);
+        m_buffer = (char*)_mm_malloc(rowBytes * m_rows + 64, 64);
+        m_data = (T*)(m_buffer + (p_aligned ? 0 : sizeof(T)));
+
+        // Values stay within the range the index normalizes to, so the integer kernels see
+        // realistic magnitudes; Binary rows are random bytes.
+        const bool nonNegative = std::is_unsigned<T>::value || std::is_same<T, Binary>::value;
+        float scale = std::is_same<T, Binary>::value ? 127.5f : (float)Utils::GetBase<T>();
+        if (std::is_unsigned<T>::value) scale /= 2;
+        std::uniform_real_distribution<float> values(-1.0f, 1.0f);
+        for (SizeType i = 0; i < m_rows; i++)
+        {
+            T* row = m_data + i * m_stride;
+            for (DimensionType j = 0; j < m_dimension; j++)
+            {
+                float v = values(p_rng) * scale;
+                row[j] = (T)(nonNegative ? v + scale : v);
+            }
+        }
+
+        m_order.resize(m_rows);
+        for (SizeType i = 0; i < m_rows; i++) m_order[i] = i;
+        std::shuffle(m_order.begin(), m_order.end(), p_rng);
+    }
+
+    ~WorkingSet()
+    {
+        _mm_free(m_buffer);
+    }
+
+    inline SizeType R() const { return m_rows; }
+
+    inline const T* Row(SizeType p_index) const { return m_data + m_order[p_index] * m_stride; }
+
+private:
+    DimensionType m_dimension;
+    std::size_t m_stride;
+    SizeType m_rows;
+    char* m_buffer;
+    T* m_data;
+    std::vector<SizeType> m_order;
+};
+
+
+volatile float g_sink;
+
+// Compares a fixed query row against the rows of the working set in order. The number of calls
+// is doubled until one run takes p_minTimeMs, and the best of three runs of that length is
+// returned in nanoseconds per call. The row cursor carries over between runs, so DRAM resident
+// rows are not revisited while they might still be cached.
+template<typename T>
+double TimeKernel(Kernel<T> p_kernel, const WorkingSet<T>& p_set, DimensionType p_dimension, int p_minTimeMs, std::uint64_t& p_calls)
+{
+    const T* query = p_set.Row(0);
+    SizeType row = 0;
+    float sum = 0;
+    auto run = [&](std::uint64_t p_count)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (std::uint64_t c = 0; c < p_count; c++)
+        {
+            sum += p_kernel(query, p_set.Row(row), p_dimension);
+            if (++row == p_set.R()) row = 0;
+        }
+        return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    std::uint64_t calls = 1024;
+    double best = run(calls);
+    while (best < p_minTimeMs * 1e6 && calls < ((std::uint64_t)1 << 40))
+    {
+        calls *= 2;
+        best = run(calls);
+    }
+    for (int i = 0; i < 2; i++) best = min(best, run(calls));
+
+    g_sink = sum;
+    p_calls = calls;
+    return best / calls;
+}
+
+
+template<typename T>
+void Run(const BenchmarkOptions& p_options, const std::vector<DimensionType>& p_dimensions)
+{
+    std::string type = Helper::Convert::ConvertToString(GetEnumValueType<T>());
+    std::mt19937 rng(0);
+
+    for (DimensionType dimension : p_dimensions)
+    {
+        for (bool dram : { false, true })
+        {
+            // L1 holds 32KB on current x86 cores; leave room for the stack and the order array.
+            std::size_t bytes = dram ? (std::size_t)p_options.m_dramMB << 20 : (std::size_t)16 << 10;
+            for (bool aligned : { true, false })
+            {
+                WorkingSet<T> set(dimension, bytes, aligned, rng);
+                for (DistCalcMethod method : BenchmarkMethods<T>())
+                {
+                    for (const NamedKernel<T>& kernel : CollectKernels<T>(method, dimension))
+                    {
+                        std::uint64_t calls = 0;
+                        double ns = TimeKernel(kernel.kernel, set, dimension, p_options.m_minTimeMs, calls);
+                        double gbps = 2.0 * sizeof(T) * dimension / ns;
+                        std::printf("%s\t%s\t%s\t%d\t%s\t%s\t%llu\t%.3f\t%.3f\n",
+                            type.c_str(), Helper::Convert::ConvertToString(method).c_str(), kernel.name, (int)dimension,
+                            aligned ? "aligned" : "unaligned", dram ? "DRAM" : "L1",
+                            (unsigned long long)calls, ns, gbps);
+                        std::fflush(stdout);
+                    }
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+
+int main(int argc, char* argv[])
+{
+    BenchmarkOptions options;
+    if (!options.Parse(argc, argv))
+    {
+        exit(1);
+    }
+
+    std::vector<DimensionType> dimensions;
+    for (const std::string& dim : Helper::StrUtils::SplitString(options.m_dimensions, ","))
+    {
+        DimensionType value;
+        if (!Helper::Convert::ConvertStringTo(dim.c_str(), value) || value <= 0)
+        {
+            std::fprintf(stderr, "Invalid dimension: %s\n", dim.c_str());
+            exit(1);
+        }
+        dimensions.push_back(value);
+    }
+
+    std::fprintf(stderr, "AVX:%d AVX2:%d F16C:%d AVX512:%d AVX512VNNI:%d\n",
+        InstructionSet::AVX(), InstructionSet::AVX2(), InstructionSet::F16C(), InstructionSet::AVX512(), InstructionSet::AVX512VNNI());
+    std::printf("type\tmethod\tkernel\tdim\talignment\tresidency\tcalls\tns_per_call\tgb_per_s\n");
+
+    for (const std::string& name : Helper::StrUtils::SplitString(options.m_valueTypes, ","))
+    {
+        VectorValueType valueType = VectorValueType::Undefined;
+        if (!Helper::Convert::ConvertStringTo(name.c_str(), valueType) || valueType == VectorValueType::Undefined)
+        {
+            std::fprintf(stderr, "Invalid value type: %s\n", name.c_str());
+            exit(1);
+        }
+
+        switch (valueType)
+        {
+#define DefineVectorValueType(Name, Type) \
+        case VectorValueType::Name: \
+            Run<Type>(options, dimensions); \
+            break; \
+
+#include "inc/Core/DefinitionList.h"
+#undef DefineVectorValueType
+
+        default: break;
+        }
+    }
+    return 0;
+}
@@ -6,6 +6,7 @@
 #include "inc/Core/VectorIndex.h"
 #include "inc/Core/Common/CommonUtils.h"
 
+#include <set>
 #include <unordered_set>
 #include <ctime>
 
@@ -22,6 +23,20 @@ void Build(SPTAG::IndexAlgoType algo, std::string distCalcMethod, std::shared_pt
     BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->SaveIndex(out));
 }
 
+template <typename T>
+void BuildQuantized(SPTAG::IndexAlgoType algo, std::string distCalcMethod, std::string quantizer, std::shared_ptr<SPTAG::VectorSet>& vec, std::shared_ptr<SPTAG::MetadataSet>& meta, const std::string out)
+{
+
+    std::shared_ptr<SPTAG::VectorIndex> vecIndex = SPTAG::VectorIndex::CreateInstance(algo, SPTAG::GetEnumValueType<T>());
+    BOOST_CHECK(nullptr != vecIndex);
+
+    vecIndex->SetParameter("DistCalcMethod", distCalcMethod);
+    vecIndex->SetParameter("Quantizer", quantizer);
+
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->BuildIndex(vec, meta));
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->SaveIndex(out));
+}
+
 template <typename T>
 void BuildWithMetaMapping(SPTAG::IndexAlgoType algo, std::string distCalcMethod, std::shared_ptr<SPTAG::VectorSet>& vec, std::shared_ptr<SPTAG::MetadataSet>& meta, const std::string out)
 {
@@ -173,6 +188,458 @@ void Test(SPTAG::IndexAlgoType algo, std::string distCalcMethod)
     Search<float>("testindices", query.data(), q, k, truthmeta6);
 }
 
+template <typename T>
+void TestQuantizer(SPTAG::IndexAlgoType algo, std::string distCalcMethod, std::string quantizer)
+{
+    SPTAG::SizeType n = 2000, q = 3;
+    SPTAG::DimensionType m = 16;
+    int k = 3;
+    std::vector<T> vec;
+    for (SPTAG::SizeType i = 0; i < n; i++) {
+        for (SPTAG::DimensionType j = 0; j < m; j++) {
+            vec.push_back((T)i);
+        }
+    }
+
+    std::vector<T> query;
+    for (SPTAG::SizeType i = 0; i < q; i++) {
+        for (SPTAG::DimensionType j = 0; j < m; j++) {
+            query.push_back((T)i * 2);
+        }
+    }
+
+    std::vector<char> meta;
+    std::vector<std::uint64_t> metaoffset;
+    for (SPTAG::SizeType i = 0; i < n; i++) {
+        metaoffset.push_back((std::uint64_t)meta.size());
+        std::string a = std::to_string(i);
+        for (size_t j = 0; j < a.length(); j++)
+            meta.push_back(a[j]);
+    }
+    metaoffset.push_back((std::uint64_t)meta.size());
+
+    std::shared_ptr<SPTAG::VectorSet> vecset(new SPTAG::BasicVectorSet(
+        SPTAG::ByteArray((std::uint8_t*)vec.data(), sizeof(T) * n * m, false),
+        SPTAG::GetEnumValueType<T>(), m, n));
+
+    std::shared_ptr<SPTAG::MetadataSet> metaset(new SPTAG::MemMetadataSet(
+        SPTAG::ByteArray((std::uint8_t*)meta.data(), meta.size() * sizeof(char), false),
+        SPTAG::ByteArray((std::uint8_t*)metaoffset.data(), metaoffset.size() * sizeof(std::uint64_t), false),
+        n));
+
+    // Candidates are re-ranked with full precision distances, so the results match the unquantized index.
+    BuildQuantized<T>(algo, distCalcMethod, quantizer, vecset, metaset, "testindices");
+    std::string truthmeta1[] = { "0", "1", "2", "2", "1", "3", "4", "3", "5" };
+    Search<T>("testindices", query.data(), q, k, truthmeta1);
+
+    Add<T>("testindices", vecset, metaset, "testindices");
+    std::string truthmeta2[] = { "0", "0", "1", "2", "2", "1", "4", "4", "3" };
+    Search<T>("testindices", query.data(), q, k, truthmeta2);
+
+    Delete<T>("testindices", query.data(), q, "testindices");
+    std::string truthmeta3[] = { "1", "1", "3", "1", "3", "1", "3", "5", "3" };
+    Search<T>("testindices", query.data(), q, k, truthmeta3);
+}
+
+template <typename T>
+void TestAccurateDistance(SPTAG::IndexAlgoType algo, std::string distCalcMethod)
+{
+    SPTAG::SizeType n = 1000, q = 5;
+    SPTAG::DimensionType m = 16;
+    std::vector<T> vec;
+    for (SPTAG::SizeType i = 0; i < n * m; i++) vec.push_back((T)(rand() % 100 + 1));
+
+    std::shared_ptr<SPTAG::VectorSet> vecset(new SPTAG::BasicVectorSet(
+        SPTAG::ByteArray((std::uint8_t*)vec.data(), sizeof(T) * n * m, false),
+        SPTAG::GetEnumValueType<T>(), m, n));
+
+    std::shared_ptr<SPTAG::VectorIndex> vecIndex = SPTAG::VectorIndex::CreateInstance(algo, SPTAG::GetEnumValueType<T>());
+    BOOST_CHECK(nullptr != vecIndex);
+    vecIndex->SetParameter("DistCalcMethod", distCalcMethod);
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->BuildIndex(vecset, nullptr));
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->AddIndex(vecset, nullptr));
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->SaveIndex("testindices"));
+    vecIndex.reset();
+
+    // The distance to a sample id uses the norms saved with the index and must match the pointer overload.
+    BOOST_CHECK(SPTAG::ErrorCode::Success == SPTAG::VectorIndex::LoadIndex("testindices", vecIndex));
+    BOOST_CHECK(nullptr != vecIndex && vecIndex->GetNumSamples() == 2 * n);
+    for (SPTAG::SizeType i = 0; i < q; i++)
+    {
+        const T* query = vec.data() + i * m;
+        for (SPTAG::SizeType j = 0; j < vecIndex->GetNumSamples(); j += 97)
+        {
+            BOOST_CHECK_SMALL(vecIndex->AccurateDistance(query, j) - vecIndex->AccurateDistance(query, vecIndex->GetSample(j)), 1e-5f);
+        }
+    }
+}
+
+template <typename T>
+void TestVisitedTable(SPTAG::IndexAlgoType algo, std::string distCalcMethod)
+{
+    SPTAG::SizeType n = 2000, q = 20;
+    SPTAG::DimensionType m = 16;
+    int k = 10;
+    std::vector<T> vec;
+    for (SPTAG::SizeType i = 0; i < n * m; i++) vec.push_back((T)(rand() % 100 + 1));
+
+    std::shared_ptr<SPTAG::VectorSet> vecset(new SPTAG::BasicVectorSet(
+        SPTAG::ByteArray((std::uint8_t*)vec.data(), sizeof(T) * n * m, false),
+        SPTAG::GetEnumValueType<T>(), m, n));
+
+    std::shared_ptr<SPTAG::VectorIndex> vecIndex = SPTAG::VectorIndex::CreateInstance(algo, SPTAG::GetEnumValueType<T>());
+    BOOST_CHECK(nullptr != vecIndex);
+    vecIndex->SetParameter("DistCalcMethod", distCalcMethod);
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->BuildIndex(vecset, nullptr));
+    // Keep the background tree rebuild from changing the index between the two searches.
+    vecIndex->SetParameter("AddCountForRebuild", "100000");
+
+    // The second round searches ids added after the work spaces were created.
+    for (int round = 0; round < 2; round++)
+    {
+        for (SPTAG::SizeType i = 0; i < q; i++)
+        {
+            SPTAG::QueryResult hashRes(vec.data() + i * m, k, false);
+            vecIndex->SetParameter("VisitedTable", "Hash");
+            vecIndex->SearchIndex(hashRes);
+
+            SPTAG::QueryResult epochRes(vec.data() + i * m, k, false);
+            vecIndex->SetParameter("VisitedTable", "Epoch");
+            vecIndex->SearchIndex(epochRes);
+
+            for (int j = 0; j < k; j++)
+            {
+                BOOST_CHECK(hashRes.GetResult(j)->VID == epochRes.GetResult(j)->VID);
+            }
+        }
+        BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->AddIndex(vecset, nullptr));
+    }
+}
+
+template <typename T>
+void TestDeadline(SPTAG::IndexAlgoType algo, std::string distCalcMethod)
+{
+    SPTAG::SizeType n = 1000;
+    SPTAG::DimensionType m = 16;
+    int k = 10;
+    std::vector<T> vec;
+    for (SPTAG::SizeType i = 0; i < n * m; i++) vec.push_back((T)(rand() % 100 + 1));
+
+    std::shared_ptr<SPTAG::VectorSet> vecset(new SPTAG::BasicVectorSet(
+        SPTAG::ByteArray((std::uint8_t*)vec.data(), sizeof(T) * n * m, false),
+        SPTAG::GetEnumValueType<T>(), m, n));
+
+    std::shared_ptr<SPTAG::VectorIndex> vecIndex = SPTAG::VectorIndex::CreateInstance(algo, SPTAG::GetEnumValueType<T>());
+    BOOST_CHECK(nullptr != vecIndex);
+    vecIndex->SetParameter("DistCalcMethod", distCalcMethod);
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->BuildIndex(vecset, nullptr));
+
+    SPTAG::QueryResult res(vec.data(), k, false);
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->SearchIndex(res));
+    BOOST_CHECK(!res.IsCutShort());
+    BOOST_CHECK(res.GetResult(0)->VID == 0);
+
+    // A deadline that has already passed stops the search at its first hop.
+    SPTAG::SearchOptions options;
+    options.SetTimeBudget(std::chrono::nanoseconds(0));
+    res.Reset();
+    res.SetOptions(options);
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->SearchIndex(res));
+    BOOST_CHECK(res.IsCutShort());
+}
+
+template <typename T>
+void TestRadiusSearch(SPTAG::IndexAlgoType algo, std::string distCalcMethod)
+{
+    SPTAG::SizeType n = 1000;
+    SPTAG::DimensionType m = 16;
+    std::vector<T> vec;
+    for (SPTAG::SizeType i = 0; i < n * m; i++) vec.push_back((T)(rand() % 100 + 1));
+
+    std::shared_ptr<SPTAG::VectorSet> vecset(new SPTAG::BasicVectorSet(
+        SPTAG::ByteArray((std::uint8_t*)vec.data(), sizeof(T) * n * m, false),
+        SPTAG::GetEnumValueType<T>(), m, n));
+
+    std::shared_ptr<SPTAG::VectorIndex> vecIndex = SPTAG::VectorIndex::CreateInstance(algo, SPTAG::GetEnumValueType<T>());
+    BOOST_CHECK(nullptr != vecIndex);
+    vecIndex->SetParameter("DistCalcMethod", distCalcMethod);
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->BuildIndex(vecset, nullptr));
+
+    // Take the radius from the 20th nearest vector; the search is approximate, so it may miss a few of them.
+    std::vector<float> dists;
+    for (SPTAG::SizeType i = 0; i < n; i++) dists.push_back(vecIndex->ComputeDistance(vec.data(), vec.data() + i * m));
+    std::sort(dists.begin(), dists.end());
+    float radius = dists[19];
+    int expected = static_cast<int>(std::upper_bound(dists.begin(), dists.end(), radius) - dists.begin());
+
+    SPTAG::QueryResult res(vec.data(), 0, false);
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->SearchIndexWithinRadius(res, radius));
+    BOOST_CHECK(res.GetResultNum() <= expected && res.GetResultNum() >= expected * 9 / 10);
+    BOOST_CHECK(res.GetResultNum() > 0 && res.GetResult(0)->Dist == 0);
+    for (int i = 0; i < res.GetResultNum(); i++)
+    {
+        BOOST_CHECK(res.GetResult(i)->Dist <= radius);
+        if (i > 0) BOOST_CHECK(res.GetResult(i - 1)->Dist <= res.GetResult(i)->Dist);
+    }
+}
+
+template <typename T>
+void TestFilter(SPTAG::IndexAlgoType algo, std::string distCalcMethod)
+{
+    SPTAG::SizeType n = 1000;
+    SPTAG::DimensionType m = 16;
+    int k = 10;
+    std::vector<T> vec;
+    for (SPTAG::SizeType i = 0; i < n * m; i++) vec.push_back((T)(rand() % 100 + 1));
+
+    std::shared_ptr<SPTAG::VectorSet> vecset(new SPTAG::BasicVectorSet(
+        SPTAG::ByteArray((std::uint8_t*)vec.data(), sizeof(T) * n * m, false),
+        SPTAG::GetEnumValueType<T>(), m, n));
+
+    std::shared_ptr<SPTAG::VectorIndex> vecIndex = SPTAG::VectorIndex::CreateInstance(algo, SPTAG::GetEnumValueType<T>());
+    BOOST_CHECK(nullptr != vecIndex);
+    vecIndex->SetParameter("DistCalcMethod", distCalcMethod);
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->BuildIndex(vecset, nullptr));
+    for (SPTAG::SizeType i = 0; i < n; i++) vecIndex->SetAttribute(i, i % 10);
+
+    // The attributes survive a save and load.
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->SaveIndex("testfilter"));
+    BOOST_CHECK(SPTAG::ErrorCode::Success == SPTAG::VectorIndex::LoadIndex("testfilter", vecIndex));
+    BOOST_CHECK(vecIndex->GetAttribute(n - 1) == (n - 1) % 10);
+
+    SPTAG::SearchOptions options;
+    options.m_attributeMask = 0xF;
+    options.m_attributeValue = 3;
+    SPTAG::QueryResult res(vec.data(), k, false);
+    res.SetOptions(options);
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->SearchIndex(res));
+    for (int i = 0; i < k; i++) BOOST_CHECK(res.GetResult(i)->VID >= 0 && res.GetResult(i)->VID % 10 == 3);
+
+    // A short list of allowed vectors is scanned; only those that also match the attributes are returned.
+    options.m_allowedIDs = std::make_shared<std::vector<SPTAG::SizeType>>(std::vector<SPTAG::SizeType>{ 3, 4, 13, 23, 500, 503 });
+    res.Reset();
+    res.SetOptions(options);
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->SearchIndex(res));
+    std::set<SPTAG::SizeType> found;
+    for (int i = 0; i < k && res.GetResult(i)->VID >= 0; i++) found.insert(res.GetResult(i)->VID);
+    BOOST_CHECK(found == std::set<SPTAG::SizeType>({ 3, 13, 23, 503 }));
+}
+
+template <typename T>
+void TestExcludeAndDistinct(SPTAG::IndexAlgoType algo, std::string distCalcMethod)
+{
+    // Groups of 5 near duplicates that share their metadata.
+    SPTAG::SizeType n = 1000, group = 5;
+    SPTAG::DimensionType m = 16;
+    int k = 10;
+    std::vector<T> vec;
+    std::vector<char> meta;
+    std::vector<std::uint64_t> metaoffset;
+    for (SPTAG::SizeType g = 0; g < n / group; g++)
+    {
+        std::vector<T> base;
+        for (SPTAG::DimensionType j = 0; j < m; j++) base.push_back((T)(rand() % 100 + 1));
+        for (SPTAG::SizeType i = 0; i < group; i++)
+        {
+            for (SPTAG::DimensionType j = 0; j < m; j++) vec.push_back(base[j] + ((j == 0) ? (T)i : 0));
+
+            std::string key = std::to_string(g);
+            metaoffset.push_back((std::uint64_t)meta.size());
+            meta.insert(meta.end(), key.begin(), key.end());
+        }
+    }
+    metaoffset.push_back((std::uint64_t)meta.size());
+
+    std::shared_ptr<SPTAG::VectorSet> vecset(new SPTAG::BasicVectorSet(
+        SPTAG::ByteArray((std::uint8_t*)vec.data(), sizeof(T) * n * m, false),
+        SPTAG::GetEnumValueType<T>(), m, n));
+    std::shared_ptr<SPTAG::MetadataSet> metaset(new SPTAG::MemMetadataSet(
+        SPTAG::ByteArray((std::uint8_t*)meta.data(), meta.size() * sizeof(char), false),
+        SPTAG::ByteArray((std::uint8_t*)metaoffset.data(), metaoffset.size() * sizeof(std::uint64_t), false),
+        n));
+
+    std::shared_ptr<SPTAG::VectorIndex> vecIndex = SPTAG::VectorIndex::CreateInstance(algo, SPTAG::GetEnumValueType<T>());
+    BOOST_CHECK(nullptr != vecIndex);
+    vecIndex->SetParameter("DistCalcMethod", distCalcMethod);
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->BuildIndex(vecset, metaset));
+
+    SPTAG::SearchOptions options;
+    options.m_excludedIDs = std::make_shared<std::unordered_set<SPTAG::SizeType>>(std::unordered_set<SPTAG::SizeType>{ 0, 1, 2 });
+    options.m_distinctByMetadata = true;
+    SPTAG::QueryResult res(vec.data(), k, true);
+    res.SetOptions(options);
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->SearchIndex(res));
+
+    // The nearest vector of the query's own group that is not excluded comes first, then one per group.
+    BOOST_CHECK(res.GetResult(0)->VID == 3);
+    std::set<std::string> keys;
+    for (int i = 0; i < k; i++)
+    {
+        BOOST_CHECK(res.GetResult(i)->VID >= 0 && options.m_excludedIDs->count(res.GetResult(i)->VID) == 0);
+        keys.insert(std::string((char*)res.GetResult(i)->Meta.Data(), res.GetResult(i)->Meta.Length()));
+        if (i > 0) BOOST_CHECK(res.GetResult(i - 1)->Dist <= res.GetResult(i)->Dist);
+    }
+    BOOST_CHECK(keys.size() == (std::size_t)k);
+}
+
+template <typename T>
+void TestIterator(SPTAG::IndexAlgoType algo, std::string distCalcMethod)
+{
+    SPTAG::SizeType n = 2000;
+    SPTAG::DimensionType m = 16;
+    int page = 10, pages = 5;
+    std::vector<T> vec;
+    for (SPTAG::SizeType i = 0; i < n * m; i++) vec.push_back((T)(rand() % 100 + 1));
+
+    std::shared_ptr<SPTAG::VectorSet> vecset(new SPTAG::BasicVectorSet(
+        SPTAG::ByteArray((std::uint8_t*)vec.data(), sizeof(T) * n * m, false),
+        SPTAG::GetEnumValueType<T>(), m, n));
+
+    std::shared_ptr<SPTAG::VectorIndex> vecIndex = SPTAG::VectorIndex::CreateInstance(algo, SPTAG::GetEnumValueType<T>());
+    BOOST_CHECK(nullptr != vecIndex);
+    vecIndex->SetParameter("DistCalcMethod", distCalcMethod);
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->BuildIndex(vecset, nullptr));
+
+    SPTAG::QueryResult all(vec.data(), page * pages, false);
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->SearchIndex(all));
+    std::set<SPTAG::SizeType> truth;
+    for (int i = 0; i < page * pages; i++) truth.insert(all.GetResult(i)->VID);
+
+    // The pages hold different vectors, each page nearest first, and together about the same as one search for all of them.
+    std::shared_ptr<SPTAG::ResultIterator> iterator = vecIndex->GetIterator(vec.data());
+    BOOST_CHECK(nullptr != iterator);
+    std::set<SPTAG::SizeType> found;
+    int hits = 0;
+    for (int p = 0; p < pages; p++)
+    {
+        SPTAG::QueryResult res(vec.data(), page, false);
+        BOOST_CHECK(SPTAG::ErrorCode::Success == iterator->Next(res));
+        for (int i = 0; i < page; i++)
+        {
+            SPTAG::SizeType vid = res.GetResult(i)->VID;
+            BOOST_CHECK(vid >= 0 && found.insert(vid).second);
+            hits += (int)truth.count(vid);
+            if (i > 0) BOOST_CHECK(res.GetResult(i - 1)->Dist <= res.GetResult(i)->Dist);
+        }
+    }
+    BOOST_CHECK(found.count(0) == 1);
+    BOOST_CHECK(hits >= page * pages * 9 / 10);
+
+    iterator->Close();
+    SPTAG::QueryResult closed(vec.data(), page, false);
+    BOOST_CHECK(SPTAG::ErrorCode::Fail == iterator->Next(closed));
+}
+
+template <typename T>
+void TestExactBatchSearch(SPTAG::IndexAlgoType algo, std::string distCalcMethod)
+{
+    SPTAG::SizeType n = 5000, q = 20;
+    SPTAG::DimensionType m = 24;
+    int k = 10;
+    std::vector<T> vec;
+    for (SPTAG::SizeType i = 0; i < n * m; i++) vec.push_back((T)(rand() % 100 + 1));
+
+    std::shared_ptr<SPTAG::VectorSet> vecset(new SPTAG::BasicVectorSet(
+        SPTAG::ByteArray((std::uint8_t*)vec.data(), sizeof(T) * n * m, false),
+        SPTAG::GetEnumValueType<T>(), m, n));
+
+    std::shared_ptr<SPTAG::VectorIndex> vecIndex = SPTAG::VectorIndex::CreateInstance(algo, SPTAG::GetEnumValueType<T>());
+    BOOST_CHECK(nullptr != vecIndex);
+    vecIndex->SetParameter("DistCalcMethod", distCalcMethod);
+    vecIndex->SetParameter("SearchGroupSize", "6");
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->BuildIndex(vecset, nullptr));
+
+    // The batch search scores the queries in groups; each must get the exact K nearest, as a search on its own does.
+    std::vector<SPTAG::BasicResult> batch(q * k);
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->SearchIndex(vec.data(), q, k, false, batch.data()));
+    for (SPTAG::SizeType i = 0; i < q; i++)
+    {
+        const T* query = vec.data() + i * m;
+        std::vector<float> dists;
+        for (SPTAG::SizeType j = 0; j < n; j++) dists.push_back(vecIndex->ComputeDistance(query, vec.data() + j * m));
+        std::sort(dists.begin(), dists.end());
+
+        SPTAG::QueryResult res(query, k, false);
+        BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->SearchIndex(res));
+        for (int j = 0; j < k; j++)
+        {
+            BOOST_CHECK(res.GetResult(j)->Dist == dists[j]);
+            BOOST_CHECK(batch[i * k + j].Dist == dists[j]);
+        }
+    }
+}
+
+template <typename T>
+void TestReorder(SPTAG::IndexAlgoType algo, std::string distCalcMethod)
+{
+    SPTAG::SizeType n = 2000, q = 20;
+    SPTAG::DimensionType m = 16;
+    std::vector<T> vec;
+    for (SPTAG::SizeType i = 0; i < n * m; i++) vec.push_back((T)(rand() % 100 + 1));
+
+    std::string meta;
+    std::vector<std::uint64_t> metaoffset;
+    for (SPTAG::SizeType i = 0; i < n; i++)
+    {
+        metaoffset.push_back((std::uint64_t)meta.size());
+        meta += std::to_string(i);
+    }
+    metaoffset.push_back((std::uint64_t)meta.size());
+
+    std::shared_ptr<SPTAG::VectorSet> vecset(new SPTAG::BasicVectorSet(
+        SPTAG::ByteArray((std::uint8_t*)vec.data(), sizeof(T) * n * m, false),
+        SPTAG::GetEnumValueType<T>(), m, n));
+    std::shared_ptr<SPTAG::MetadataSet> metaset(new SPTAG::MemMetadataSet(
+        SPTAG::ByteArray((std::uint8_t*)meta.data(), meta.size() * sizeof(char), false),
+        SPTAG::ByteArray((std::uint8_t*)metaoffset.data(), metaoffset.size() * sizeof(std::uint64_t), false),
+        n));
+
+    std::shared_ptr<SPTAG::VectorIndex> vecIndex = SPTAG::VectorIndex::CreateInstance(algo, SPTAG::GetEnumValueType<T>());
+    BOOST_CHECK(nullptr != vecIndex);
+    vecIndex->SetParameter("DistCalcMethod", distCalcMethod);
+    vecIndex->SetParameter("ReorderVectors", "true");
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->BuildIndex(vecset, metaset, true));
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->SaveIndex("testindices"));
+    vecIndex.reset();
+    BOOST_CHECK(SPTAG::ErrorCode::Success == SPTAG::VectorIndex::LoadIndex("testindices", vecIndex));
+    BOOST_CHECK(nullptr != vecIndex);
+
+    // The vectors moved together with their metadata, and the original ids are a permutation of the input rows.
+    std::vector<bool> seen(n, false);
+    for (SPTAG::SizeType i = 0; i < n; i++)
+    {
+        SPTAG::SizeType orig = vecIndex->GetOriginalID(i);
+        BOOST_REQUIRE(orig >= 0 && orig < n && !seen[orig]);
+        seen[orig] = true;
+        BOOST_CHECK(memcmp(vecIndex->GetSample(i), vec.data() + orig * m, sizeof(T) * m) == 0);
+        SPTAG::ByteArray vm = vecIndex->GetMetadata(i);
+        BOOST_CHECK(std::string((char*)vm.Data(), vm.Length()) == std::to_string(orig));
+    }
+    for (SPTAG::SizeType i = 0; i < q; i++)
+    {
+        SPTAG::QueryResult res(vec.data() + i * m, 1, false);
+        vecIndex->SearchIndex(res);
+        BOOST_CHECK(vecIndex->GetOriginalID(res.GetResult(0)->VID) == i);
+    }
+
+    // Refining past the delete threshold reorders the remaining vectors again.
+    for (SPTAG::SizeType i = 0; i < n / 2; i++) vecIndex->DeleteIndex(vecIndex->GetMetadata(i));
+    BOOST_CHECK(SPTAG::ErrorCode::Success == vecIndex->SaveIndex("testindices"));
+    vecIndex.reset();
+    BOOST_CHECK(SPTAG::ErrorCode::Success == SPTAG::VectorIndex::LoadIndex("testindices", vecIndex));
+    BOOST_CHECK(nullptr != vecIndex && vecIndex->GetNumSamples() == n - n / 2);
+    for (SPTAG::SizeType i = 0; i < vecIndex->GetNumSamples(); i++)
+    {
+        SPTAG::ByteArray vm = vecIndex->GetMetadata(i);
+        SPTAG::SizeType orig = std::stoi(std::string((char*)vm.Data(), vm.Length()));
+        BOOST_CHECK(memcmp(vecIndex->GetSample(i), vec.data() + orig * m, sizeof(T) * m) == 0);
+
+        SPTAG::QueryResult res(vec.data() + orig * m, 1, true);
+        vecIndex->SearchIndex(res);
+        BOOST_CHECK(res.GetResult(0)->VID == i);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE (AlgoTest)
 
 BOOST_AUTO_TEST_CASE(KDTTest)
@@ -185,4 +652,67 @@ BOOST_AUTO_TEST_CASE(BKTTest)
     Test<float>(SPTAG::IndexAlgoType::BKT, "L2");
 }
 
+BOOST_AUTO_TEST_CASE(BKTPQTest)
+{
+    TestQuantizer<float>(SPTAG::IndexAlgoType::BKT, "L2", "PQ");
+}
+
+BOOST_AUTO_TEST_CASE(BKTSQ8Test)
+{
+    TestQuantizer<float>(SPTAG::IndexAlgoType::BKT, "L2", "SQ8");
+}
+
+BOOST_AUTO_TEST_CASE(BKTAccurateDistanceTest)
+{
+    TestAccurateDistance<float>(SPTAG::IndexAlgoType::BKT, "Cosine");
+}
+
+BOOST_AUTO_TEST_CASE(BKTEpochVisitedTableTest)
+{
+    TestVisitedTable<float>(SPTAG::IndexAlgoType::BKT, "L2");
+}
+
+BOOST_AUTO_TEST_CASE(DeadlineTest)
+{
+    TestDeadline<float>(SPTAG::IndexAlgoType::BKT, "L2");
+    TestDeadline<float>(SPTAG::IndexAlgoType::KDT, "L2");
+}
+
+BOOST_AUTO_TEST_CASE(RadiusSearchTest)
+{
+    TestRadiusSearch<float>(SPTAG::IndexAlgoType::BKT, "L2");
+    TestRadiusSearch<float>(SPTAG::IndexAlgoType::KDT, "L2");
+}
+
+BOOST_AUTO_TEST_CASE(FilterTest)
+{
+    TestFilter<float>(SPTAG::IndexAlgoType::BKT, "L2");
+    TestFilter<float>(SPTAG::IndexAlgoType::KDT, "L2");
+}
+
+BOOST_AUTO_TEST_CASE(ExcludeAndDistinctTest)
+{
+    TestExcludeAndDistinct<float>(SPTAG::IndexAlgoType::BKT, "L2");
+    TestExcludeAndDistinct<float>(SPTAG::IndexAlgoType::KDT, "L2");
+}
+
+BOOST_AUTO_TEST_CASE(IteratorTest)
+{
+    TestIterator<float>(SPTAG::IndexAlgoType::BKT, "L2");
+    TestIterator<float>(SPTAG::IndexAlgoType::KDT, "L2");
+}
+
+BOOST_AUTO_TEST_CASE(BKTReorderTest)
+{
+    TestReorder<float>(SPTAG::IndexAlgoType::BKT, "L2");
+}
+
+BOOST_AUTO_TEST_CASE(FlatTest)
+{
+    Test<float>(SPTAG::IndexAlgoType::Flat, "L2");
+    TestFilter<float>(SPTAG::IndexAlgoType::Flat, "L2");
+    TestIterator<float>(SPTAG::IndexAlgoType::Flat, "L2");
+    TestExactBatchSearch<float>(SPTAG::IndexAlgoType::Flat, "L2");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -1,6 +1,7 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#include <algorithm>
 #include <bitset>
 #include "inc/Test.h"
 #include "inc/Core/Common/DistanceUtils.h"
@@ -36,23 +37,209 @@ void test(int high) {
     T *X = new T[dimension], *Y = new T[dimension];
     BOOST_ASSERT(X != nullptr && Y != nullptr);
     for (SPTAG::DimensionType i = 0; i < dimension; i++) {
-        X[i] = random<T>(high, -high);
-        Y[i] = random<T>(high, -high);
+        X[i] = random<T>(high, std::is_signed<T>::value ? -high : 0);
+        Y[i] = random<T>(high, std::is_signed<T>::value ? -high : 0);
     }
     BOOST_CHECK_CLOSE_FRACTION(ComputeL2Distance(X, Y, dimension), SPTAG::COMMON::DistanceUtils::ComputeL2Distance(X, Y, dimension), 1e-5);
     BOOST_CHECK_CLOSE_FRACTION(high*high - ComputeCosineDistance(X, Y, dimension), SPTAG::COMMON::DistanceUtils::ComputeCosineDistance(X, Y, dimension), 1e-5);
+    BOOST_CHECK_CLOSE_FRACTION(high*high - ComputeCosineDistance(X, Y, dimension), SPTAG::COMMON::DistanceUtils::ComputeDistance(X, Y, dimension, SPTAG::DistCalcMethod::InnerProduct), 1e-5);
+
+    // Every kernel the runtime dispatcher may pick on this machine must agree with the scalar version.
+    using SPTAG::COMMON::DistanceUtils;
+    using SPTAG::COMMON::InstructionSet;
+    typedef float(*Kernel)(const T*, const T*, SPTAG::DimensionType);
+    std::vector<std::pair<Kernel, Kernel>> kernels;
+    kernels.push_back({ &DistanceUtils::ComputeL2Distance_SSE, &DistanceUtils::ComputeCosineDistance_SSE });
+    if (InstructionSet::AVX2()) kernels.push_back({ &DistanceUtils::ComputeL2Distance_AVX, &DistanceUtils::ComputeCosineDistance_AVX });
+    if (InstructionSet::AVX512()) kernels.push_back({ &DistanceUtils::ComputeL2Distance_AVX512, &DistanceUtils::ComputeCosineDistance_AVX512 });
+    if (InstructionSet::AVX512VNNI()) kernels.push_back({ &DistanceUtils::ComputeL2Distance_AVX512VNNI, &DistanceUtils::ComputeCosineDistance_AVX512VNNI });
+    for (auto& kernel : kernels) {
+        BOOST_CHECK_CLOSE_FRACTION(ComputeL2Distance(X, Y, dimension), kernel.first(X, Y, dimension), 1e-5);
+        BOOST_CHECK_CLOSE_FRACTION(high*high - ComputeCosineDistance(X, Y, dimension), kernel.second(X, Y, dimension), 1e-5);
+    }
 
     delete[] X;
     delete[] Y;
 }
 
+template<typename T>
+void testBatch(int high) {
+    // An odd row count covers both the blocks of four and the leftover rows.
+    const int count = 7;
+    SPTAG::DimensionType dimension = random<SPTAG::DimensionType>(256, 2);
+    std::vector<T> data((count + 1) * dimension);
+    for (auto& v : data) v = random<T>(high, std::is_signed<T>::value ? -high : 0);
+    const T* query = data.data();
+    std::vector<const T*> rows;
+    for (int i = 1; i <= count; i++) rows.push_back(data.data() + i * dimension);
+
+    using SPTAG::COMMON::DistanceUtils;
+    using SPTAG::COMMON::InstructionSet;
+    typedef void(*BatchKernel)(const T*, const T* const*, int, SPTAG::DimensionType, float*);
+    std::vector<std::pair<BatchKernel, BatchKernel>> kernels;
+    kernels.push_back({ &DistanceUtils::ComputeL2DistanceBatch_SSE, &DistanceUtils::ComputeCosineDistanceBatch_SSE });
+    if (InstructionSet::AVX2()) kernels.push_back({ &DistanceUtils::ComputeL2DistanceBatch_AVX, &DistanceUtils::ComputeCosineDistanceBatch_AVX });
+    if (InstructionSet::AVX512()) kernels.push_back({ &DistanceUtils::ComputeL2DistanceBatch_AVX512, &DistanceUtils::ComputeCosineDistanceBatch_AVX512 });
+    if (InstructionSet::AVX512VNNI()) kernels.push_back({ &DistanceUtils::ComputeL2DistanceBatch_AVX512VNNI, &DistanceUtils::ComputeCosineDistanceBatch_AVX512VNNI });
+    for (auto& kernel : kernels) {
+        float l2[count], cosine[count];
+        kernel.first(query, rows.data(), count, dimension, l2);
+        kernel.second(query, rows.data(), count, dimension, cosine);
+        for (int i = 0; i < count; i++) {
+            BOOST_CHECK_CLOSE_FRACTION(ComputeL2Distance(query, rows[i], dimension), l2[i], 1e-5);
+            BOOST_CHECK_CLOSE_FRACTION(high*high - ComputeCosineDistance(query, rows[i], dimension), cosine[i], 1e-5);
+        }
+    }
+}
+
+void testHamming() {
+    const int count = 7;
+    // Cover whole 64-byte registers, 8-byte words and leftover bytes.
+    for (SPTAG::DimensionType dimension : { 1, 7, 32, 64, 100, 200 }) {
+        std::vector<SPTAG::Binary> data((count + 1) * dimension);
+        for (auto& v : data) v.bits = (std::uint8_t)(std::rand() & 0xff);
+        const SPTAG::Binary* query = data.data();
+        std::vector<const SPTAG::Binary*> rows;
+        std::vector<float> truth;
+        for (int i = 1; i <= count; i++) {
+            rows.push_back(data.data() + i * dimension);
+            int bits = 0;
+            for (SPTAG::DimensionType j = 0; j < dimension; j++) bits += (int)std::bitset<8>(query[j].bits ^ rows.back()[j].bits).count();
+            truth.push_back((float)bits);
+        }
+
+        using SPTAG::COMMON::DistanceUtils;
+        using SPTAG::COMMON::InstructionSet;
+        typedef float(*Kernel)(const SPTAG::Binary*, const SPTAG::Binary*, SPTAG::DimensionType);
+        typedef void(*BatchKernel)(const SPTAG::Binary*, const SPTAG::Binary* const*, int, SPTAG::DimensionType, float*);
+        std::vector<std::pair<Kernel, BatchKernel>> kernels;
+        kernels.push_back({ &DistanceUtils::ComputeHammingDistance_SSE, &DistanceUtils::ComputeHammingDistanceBatch_SSE });
+        if (InstructionSet::POPCNT()) kernels.push_back({ &DistanceUtils::ComputeHammingDistance_POPCNT, &DistanceUtils::ComputeHammingDistanceBatch_POPCNT });
+        if (InstructionSet::AVX512VPOPCNTDQ()) kernels.push_back({ &DistanceUtils::ComputeHammingDistance_AVX512VPOPCNTDQ, &DistanceUtils::ComputeHammingDistanceBatch_AVX512VPOPCNTDQ });
+        for (auto& kernel : kernels) {
+            float batch[count];
+            kernel.second(query, rows.data(), count, dimension, batch);
+            for (int i = 0; i < count; i++) {
+                BOOST_CHECK_EQUAL(truth[i], kernel.first(query, rows[i], dimension));
+                BOOST_CHECK_EQUAL(truth[i], batch[i]);
+            }
+        }
+
+        // Binary vectors are compared by Hamming distance whatever the method.
+        for (int i = 0; i < count; i++) {
+            BOOST_CHECK_EQUAL(truth[i], DistanceUtils::ComputeL2Distance(query, rows[i], dimension));
+            BOOST_CHECK_EQUAL(truth[i], DistanceUtils::ComputeDistance(query, rows[i], dimension, SPTAG::DistCalcMethod::Hamming));
+        }
+    }
+}
+
+template<typename T>
+void testBounded(int high) {
+    const int count = 7;
+    const SPTAG::DimensionType dimension = 1000;
+    std::vector<T> data((count + 1) * dimension);
+    for (auto& v : data) v = random<T>(high, std::is_signed<T>::value ? -high : 0);
+    const T* query = data.data();
+    std::vector<const T*> rows;
+    for (int i = 1; i <= count; i++) rows.push_back(data.data() + i * dimension);
+
+    using SPTAG::COMMON::DistanceUtils;
+    auto fComputeDistance = SPTAG::COMMON::DistanceCalcSelector<T>(SPTAG::DistCalcMethod::L2);
+    auto fComputeDistanceBatch = SPTAG::COMMON::DistanceBatchCalcSelector<T>(SPTAG::DistCalcMethod::L2);
+    std::vector<float> full(count), bounded(count);
+    fComputeDistanceBatch(query, rows.data(), count, dimension, full.data());
+
+    // A bound above every distance never abandons and gives the full distances.
+    float maxDist = *std::max_element(full.begin(), full.end());
+    BOOST_CHECK_EQUAL(0, DistanceUtils::ComputeDistanceBatchBounded(fComputeDistanceBatch, query, rows.data(), count, dimension, maxDist * 2, bounded.data()));
+    for (int i = 0; i < count; i++) {
+        bool abandoned;
+        BOOST_CHECK_CLOSE_FRACTION(full[i], bounded[i], 1e-5);
+        BOOST_CHECK_CLOSE_FRACTION(full[i], DistanceUtils::ComputeDistanceBounded(fComputeDistance, query, rows[i], dimension, maxDist * 2, abandoned), 1e-5);
+        BOOST_CHECK(!abandoned);
+    }
+
+    // A tiny bound abandons every row after the first block, with a partial sum above the bound.
+    float bound = maxDist / 100;
+    BOOST_CHECK_EQUAL(count, DistanceUtils::ComputeDistanceBatchBounded(fComputeDistanceBatch, query, rows.data(), count, dimension, bound, bounded.data()));
+    for (int i = 0; i < count; i++) {
+        bool abandoned;
+        float dist = DistanceUtils::ComputeDistanceBounded(fComputeDistance, query, rows[i], dimension, bound, abandoned);
+        BOOST_CHECK(abandoned);
+        BOOST_CHECK(dist > bound && dist < full[i]);
+        BOOST_CHECK(bounded[i] > bound && bounded[i] < full[i]);
+    }
+}
+
+template<typename T>
+void testFixedDimension(int high) {
+    const int count = 7;
+    for (SPTAG::DimensionType dimension : { 96, 128, 256, 768 }) {
+        std::vector<T> data((count + 1) * dimension);
+        for (auto& v : data) v = random<T>(high, std::is_signed<T>::value ? -high : 0);
+        const T* query = data.data();
+        std::vector<const T*> rows;
+        for (int i = 1; i <= count; i++) rows.push_back(data.data() + i * dimension);
+
+        for (SPTAG::DistCalcMethod method : { SPTAG::DistCalcMethod::L2, SPTAG::DistCalcMethod::Cosine }) {
+            float(*pair)(const T*, const T*, SPTAG::DimensionType) = nullptr;
+            void(*batch)(const T*, const T* const*, int, SPTAG::DimensionType, float*) = nullptr;
+            // Machines below AVX have no fixed dimension kernels.
+            if (!SPTAG::COMMON::DistanceUtils::SelectFixedDimensionKernels<T>(method, dimension, pair, batch)) continue;
+
+            float results[count];
+            batch(query, rows.data(), count, dimension, results);
+            for (int i = 0; i < count; i++) {
+                float expected = (method == SPTAG::DistCalcMethod::L2) ? ComputeL2Distance(query, rows[i], dimension) : high * high - ComputeCosineDistance(query, rows[i], dimension);
+                BOOST_CHECK_CLOSE_FRACTION(expected, results[i], 1e-4);
+                BOOST_CHECK_CLOSE_FRACTION(expected, pair(query, rows[i], dimension), 1e-4);
+            }
+
+            // Any other length goes to the generic kernel.
+            float expected = (method == SPTAG::DistCalcMethod::L2) ? ComputeL2Distance(query, rows[0], dimension - 3) : high * high - ComputeCosineDistance(query, rows[0], dimension - 3);
+            BOOST_CHECK_CLOSE_FRACTION(expected, pair(query, rows[0], dimension - 3), 1e-4);
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE(DistanceTest)
 
 BOOST_AUTO_TEST_CASE(TestDistanceComputation)
 {
     test<float>(1);
     test<std::int8_t>(127);
+    test<std::uint8_t>(255);
     test<std::int16_t>(32767);
+    test<SPTAG::Float16>(1);
+    test<SPTAG::BFloat16>(1);
+}
+
+BOOST_AUTO_TEST_CASE(TestBatchDistanceComputation)
+{
+    testBatch<float>(1);
+    testBatch<std::int8_t>(127);
+    testBatch<std::uint8_t>(255);
+    testBatch<std::int16_t>(32767);
+    testBatch<SPTAG::Float16>(1);
+    testBatch<SPTAG::BFloat16>(1);
+}
+
+BOOST_AUTO_TEST_CASE(TestBoundedDistanceComputation)
+{
+    testBounded<float>(1);
+    testBounded<std::int8_t>(127);
+}
+
+BOOST_AUTO_TEST_CASE(TestFixedDimensionDistanceComputation)
+{
+    testFixedDimension<float>(1);
+    testFixedDimension<std::int8_t>(127);
+    testFixedDimension<std::uint8_t>(255);
+}
+
+BOOST_AUTO_TEST_CASE(TestHammingDistanceComputation)
+{
+    testHamming();
 }
 
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
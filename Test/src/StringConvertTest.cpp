@@ -110,6 +110,7 @@ BOOST_AUTO_TEST_CASE(ConvertIndexAlgoType)
 {
     Local::TestConvertSuccCase<SPTAG::IndexAlgoType>(SPTAG::IndexAlgoType::BKT, "BKT");
     Local::TestConvertSuccCase<SPTAG::IndexAlgoType>(SPTAG::IndexAlgoType::KDT, "KDT");
+    Local::TestConvertSuccCase<SPTAG::IndexAlgoType>(SPTAG::IndexAlgoType::Flat, "Flat");
 }
 
 BOOST_AUTO_TEST_CASE(ConvertVectorValueType)
@@ -117,12 +118,17 @@ BOOST_AUTO_TEST_CASE(ConvertVectorValueType)
     Local::TestConvertSuccCase<SPTAG::VectorValueType>(SPTAG::VectorValueType::Float, "Float");
     Local::TestConvertSuccCase<SPTAG::VectorValueType>(SPTAG::VectorValueType::Int8, "Int8");
     Local::TestConvertSuccCase<SPTAG::VectorValueType>(SPTAG::VectorValueType::Int16, "Int16");
+    Local::TestConvertSuccCase<SPTAG::VectorValueType>(SPTAG::VectorValueType::Float16, "Float16");
+    Local::TestConvertSuccCase<SPTAG::VectorValueType>(SPTAG::VectorValueType::BFloat16, "BFloat16");
+    Local::TestConvertSuccCase<SPTAG::VectorValueType>(SPTAG::VectorValueType::Binary, "Binary");
 }
 
 BOOST_AUTO_TEST_CASE(ConvertDistCalcMethod)
 {
     Local::TestConvertSuccCase<SPTAG::DistCalcMethod>(SPTAG::DistCalcMethod::Cosine, "Cosine");
     Local::TestConvertSuccCase<SPTAG::DistCalcMethod>(SPTAG::DistCalcMethod::L2, "L2");
+    Local::TestConvertSuccCase<SPTAG::DistCalcMethod>(SPTAG::DistCalcMethod::InnerProduct, "InnerProduct");
+    Local::TestConvertSuccCase<SPTAG::DistCalcMethod>(SPTAG::DistCalcMethod::Hamming, "Hamming");
 }
 
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -34,6 +34,8 @@ public:
 
     std::shared_ptr<QueryResult> BatchSearch(ByteArray p_data, int p_vectorNum, int p_resultNum, bool p_withMetaData);
 
+    std::shared_ptr<QueryResult> RadiusSearch(ByteArray p_data, float p_radius, bool p_withMetaData);
+
     bool ReadyToServe() const;
 
     bool Save(const char* p_saveFile) const;
@@ -142,6 +142,17 @@ AnnIndex::BatchSearch(ByteArray p_data, int p_vectorNum, int p_resultNum, bool p
     return std::move(results);
 }
 
+std::shared_ptr<QueryResult>
+AnnIndex::RadiusSearch(ByteArray p_data, float p_radius, bool p_withMetaData)
+{
+    std::shared_ptr<QueryResult> results = std::make_shared<QueryResult>(p_data.Data(), 0, p_withMetaData);
+    if (nullptr != m_index && p_data.Length() == m_inputVectorSize)
+    {
+        m_index->SearchIndexWithinRadius(*results, p_radius);
+    }
+    return std::move(results);
+}
+
 bool
 AnnIndex::ReadyToServe() const
 {